@@ -14,6 +14,9 @@
 #include <ew/transform.h>
 #include <ew/camera.h>
 #include <ew/cameraController.h>
+#include <ew/glState.h>
+#include <ew/headless.h>
+#include <ew/meshCache.h>
 
 void framebufferSizeCallback(GLFWwindow* window, int width, int height);
 void resetCamera(ew::Camera& camera, ew::CameraController& cameraController);
@@ -41,17 +44,33 @@ struct Material
 	float shininess; //Shininess
 };
 
-int main() {
-	printf("Initializing...");
-	if (!glfwInit()) {
-		printf("GLFW failed to init!");
+int main(int argc, char** argv) {
+	//--headless --frames N renders offscreen for batch perf runs, see ew::HeadlessOptions
+	ew::HeadlessOptions headlessOptions;
+	if (!ew::ParseHeadlessOptions(argc, argv, headlessOptions)) {
 		return 1;
 	}
+	printf("Initializing...");
+	GLFWwindow* window;
+	if (headlessOptions.enabled) {
+		SCREEN_WIDTH = headlessOptions.width;
+		SCREEN_HEIGHT = headlessOptions.height;
+		window = ew::CreateHeadlessWindow(SCREEN_WIDTH, SCREEN_HEIGHT);
+		if (window == NULL) {
+			return 1;
+		}
+	}
+	else {
+		if (!glfwInit()) {
+			printf("GLFW failed to init!");
+			return 1;
+		}
 
-	GLFWwindow* window = glfwCreateWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Camera", NULL, NULL);
-	if (window == NULL) {
-		printf("GLFW failed to create window");
-		return 1;
+		window = glfwCreateWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Camera", NULL, NULL);
+		if (window == NULL) {
+			printf("GLFW failed to create window");
+			return 1;
+		}
 	}
 	glfwMakeContextCurrent(window);
 	glfwSetFramebufferSizeCallback(window, framebufferSizeCallback);
@@ -68,9 +87,9 @@ int main() {
 	ImGui_ImplOpenGL3_Init();
 
 	//Global settings
-	glEnable(GL_CULL_FACE);
-	glCullFace(GL_BACK);
-	glEnable(GL_DEPTH_TEST);
+	ew::GLState::setEnabled(GL_CULL_FACE, true);
+	ew::GLState::cullFace(GL_BACK);
+	ew::GLState::setEnabled(GL_DEPTH_TEST, true);
 
 	ew::Shader shader("assets/defaultLit.vert", "assets/defaultLit.frag");
 	ew::Shader unlitShader("assets/unlit.vert", "assets/unlit.frag");
@@ -82,10 +101,12 @@ int main() {
 	ew::Mesh sphereMesh(ew::createSphere(0.5f, 64));
 	ew::Mesh cylinderMesh(ew::createCylinder(0.5f, 1.0f, 32));
 
-	ew::Mesh unlitsphereMeshR(ew::createSphere(0.125f, 32));
-	ew::Mesh unlitsphereMeshG(ew::createSphere(0.125f, 32));
-	ew::Mesh unlitsphereMeshY(ew::createSphere(0.125f, 32));
-	ew::Mesh unlitsphereMeshB(ew::createSphere(0.125f, 32));
+	//Identical light spheres share one upload
+	ew::MeshCache meshCache;
+	ew::MeshHandle unlitsphereMeshR = meshCache.getSphere(0.125f, 32);
+	ew::MeshHandle unlitsphereMeshG = meshCache.getSphere(0.125f, 32);
+	ew::MeshHandle unlitsphereMeshY = meshCache.getSphere(0.125f, 32);
+	ew::MeshHandle unlitsphereMeshB = meshCache.getSphere(0.125f, 32);
 
 
 	//Initialize transforms
@@ -130,10 +151,13 @@ int main() {
 
 	resetCamera(camera,cameraController);
 
-	while (!glfwWindowShouldClose(window)) {
+	//Headless runs draw into an offscreen target on a fixed time step
+	ew::HeadlessRun headlessRun(headlessOptions);
+	while (headlessRun.isRunning(window)) {
 		glfwPollEvents();
+		headlessRun.beginFrame();
 
-		float time = (float)glfwGetTime();
+		float time = headlessRun.getTime();
 		float deltaTime = time - prevTime;
 		prevTime = time;
 
@@ -146,65 +170,65 @@ int main() {
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 		shader.use();
-		glBindTexture(GL_TEXTURE_2D, brickTexture);
-		shader.setInt("_Texture", 0);
-		shader.setMat4("_ViewProjection", camera.ProjectionMatrix() * camera.ViewMatrix());
+		ew::GLState::bindTexture(GL_TEXTURE_2D, brickTexture);
+		shader.setInt(EW_UNIFORM("_Texture"), 0);
+		shader.setMat4(EW_UNIFORM("_ViewProjection"), camera.ProjectionMatrix() * camera.ViewMatrix());
 
 		//TODO: Render point lights
-		shader.setVec3("_Lights[0].position", _lights[0].position);
-		shader.setVec3("_Lights[0].color", _lights[0].color);
+		shader.setVec3(EW_UNIFORM("_Lights[0].position"), _lights[0].position);
+		shader.setVec3(EW_UNIFORM("_Lights[0].color"), _lights[0].color);
 
-		shader.setVec3("_Lights[1].position", _lights[1].position);
-		shader.setVec3("_Lights[1].color", _lights[1].color);
+		shader.setVec3(EW_UNIFORM("_Lights[1].position"), _lights[1].position);
+		shader.setVec3(EW_UNIFORM("_Lights[1].color"), _lights[1].color);
 
-		shader.setVec3("_Lights[2].position", _lights[2].position);
-		shader.setVec3("_Lights[2].color", _lights[2].color);
+		shader.setVec3(EW_UNIFORM("_Lights[2].position"), _lights[2].position);
+		shader.setVec3(EW_UNIFORM("_Lights[2].color"), _lights[2].color);
 
-		shader.setVec3("_Lights[3].position", _lights[3].position);
-		shader.setVec3("_Lights[3].color", _lights[3].color);
+		shader.setVec3(EW_UNIFORM("_Lights[3].position"), _lights[3].position);
+		shader.setVec3(EW_UNIFORM("_Lights[3].color"), _lights[3].color);
 
-		shader.setInt("numLights", lights);
+		shader.setInt(EW_UNIFORM("numLights"), lights);
 
-		shader.setFloat("_Material.ambientK", _material.ambientK);
-		shader.setFloat("_Material.diffuseK", _material.diffuseK);
-		shader.setFloat("_Material.specular", _material.specular);
-		shader.setFloat("_Material.shininess", _material.shininess);
+		shader.setFloat(EW_UNIFORM("_Material.ambientK"), _material.ambientK);
+		shader.setFloat(EW_UNIFORM("_Material.diffuseK"), _material.diffuseK);
+		shader.setFloat(EW_UNIFORM("_Material.specular"), _material.specular);
+		shader.setFloat(EW_UNIFORM("_Material.shininess"), _material.shininess);
 
-		shader.setVec3("_CameraPosition", camera.position);
+		shader.setVec3(EW_UNIFORM("_CameraPosition"), camera.position);
 
 		//Draw shapes
-		shader.setMat4("_Model", cubeTransform.getModelMatrix());
+		shader.setMat4(EW_UNIFORM("_Model"), cubeTransform.getModelMatrix());
 		cubeMesh.draw();
 
-		shader.setMat4("_Model", planeTransform.getModelMatrix());
+		shader.setMat4(EW_UNIFORM("_Model"), planeTransform.getModelMatrix());
 		planeMesh.draw();
 
-		shader.setMat4("_Model", sphereTransform.getModelMatrix());
+		shader.setMat4(EW_UNIFORM("_Model"), sphereTransform.getModelMatrix());
 		sphereMesh.draw();
 
-		shader.setMat4("_Model", cylinderTransform.getModelMatrix());
+		shader.setMat4(EW_UNIFORM("_Model"), cylinderTransform.getModelMatrix());
 		cylinderMesh.draw();
 
 
 		unlitShader.use();
 
-		unlitShader.setMat4("_ViewProjection", camera.ProjectionMatrix() * camera.ViewMatrix());
+		unlitShader.setMat4(EW_UNIFORM("_ViewProjection"), camera.ProjectionMatrix() * camera.ViewMatrix());
 		
-		unlitShader.setMat4("_Model", unlitRed.getModelMatrix());
-		unlitShader.setVec3("_Color",_lights[0].color);
-		unlitsphereMeshR.draw();
+		unlitShader.setMat4(EW_UNIFORM("_Model"), unlitRed.getModelMatrix());
+		unlitShader.setVec3(EW_UNIFORM("_Color"),_lights[0].color);
+		unlitsphereMeshR->draw();
 
-		unlitShader.setMat4("_Model", unlitGreen.getModelMatrix());
-		unlitShader.setVec3("_Color", _lights[1].color);
-		unlitsphereMeshG.draw();
+		unlitShader.setMat4(EW_UNIFORM("_Model"), unlitGreen.getModelMatrix());
+		unlitShader.setVec3(EW_UNIFORM("_Color"), _lights[1].color);
+		unlitsphereMeshG->draw();
 
-		unlitShader.setMat4("_Model", unlitYellow.getModelMatrix());
-		unlitShader.setVec3("_Color", _lights[2].color);
-		unlitsphereMeshY.draw();
+		unlitShader.setMat4(EW_UNIFORM("_Model"), unlitYellow.getModelMatrix());
+		unlitShader.setVec3(EW_UNIFORM("_Color"), _lights[2].color);
+		unlitsphereMeshY->draw();
 
-		unlitShader.setMat4("_Model", unlitBlue.getModelMatrix());
-		unlitShader.setVec3("_Color", _lights[3].color);
-		unlitsphereMeshB.draw();
+		unlitShader.setMat4(EW_UNIFORM("_Model"), unlitBlue.getModelMatrix());
+		unlitShader.setVec3(EW_UNIFORM("_Color"), _lights[3].color);
+		unlitsphereMeshB->draw();
 
 		//Render UI
 		{
@@ -277,14 +301,15 @@ int main() {
 			ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 		}
 
-		glfwSwapBuffers(window);
+		headlessRun.endFrame(window);
 	}
+	headlessRun.finish();
 	printf("Shutting down...");
 }
 
 void framebufferSizeCallback(GLFWwindow* window, int width, int height)
 {
-	glViewport(0, 0, width, height);
+	ew::GLState::viewport(0, 0, width, height);
 	SCREEN_WIDTH = width;
 	SCREEN_HEIGHT = height;
 }
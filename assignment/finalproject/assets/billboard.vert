@@ -3,21 +3,33 @@ layout(location = 0) in vec3 vPos;
 layout(location = 1) in vec3 vNormal;
 layout(location = 2) in vec2 vUV;
 
+//Per instance, see qm::BillboardInstance
+layout(location = 3) in vec3 vInstancePosition;
+layout(location = 4) in vec2 vInstanceScale;
+layout(location = 5) in vec4 vInstanceUVRect; //Atlas offset (xy) and scale (zw)
+layout(location = 6) in float vInstanceLayer;
+
 out Surface{
 	vec2 UV;
 	vec3 WorldPosition;
 	vec3 WorldNormal;
+	flat float Layer;
 }vs_out;  
 
-uniform mat4 _Model;
 uniform mat4 _ViewProjection;
-//Uniform for Camera Normal
+
+//Shared by every billboard this frame, see qm::billBoardBasis
+uniform vec3 _BillboardRight;
+uniform vec3 _BillboardUp;
+uniform vec3 _BillboardForward;
 
 void main(){
+	mat3 rotation = mat3(_BillboardRight, _BillboardUp, _BillboardForward);
 
-	//Somewhere we need to do the math here
-	vs_out.UV = vUV;
-	vs_out.WorldPosition = vec3(_Model * vec4(vPos,1));
-	vs_out.WorldNormal = transpose(inverse(mat3(_Model))) * vNormal;
-	gl_Position = _ViewProjection * _Model * vec4(vPos,1.0);
-}
\ No newline at end of file
+	vec3 worldPosition = vInstancePosition + rotation * (vPos * vec3(vInstanceScale, 1.0));
+	vs_out.UV = vInstanceUVRect.xy + vUV * vInstanceUVRect.zw;
+	vs_out.Layer = vInstanceLayer;
+	vs_out.WorldPosition = worldPosition;
+	vs_out.WorldNormal = rotation * vNormal;
+	gl_Position = _ViewProjection * vec4(worldPosition,1.0);
+}
@@ -10,6 +10,7 @@ in Surface{
 struct Light
 {
 	vec3 position;
+	float radius; //0 reaches everything
 	vec3 color;
 };
 
@@ -21,11 +22,35 @@ struct Material
 	float shininess; //Shininess
 };
 
-#define MAX_LIGHTS 4
-uniform Light _Lights[MAX_LIGHTS];
-uniform int numLights;
+//Must match the structs and bindings in lightingUniforms.h and lightClusters.h
+layout(std430, binding = 3) readonly buffer LightBuffer
+{
+	Light _Lights[];
+};
+
+layout(std430, binding = 4) readonly buffer ClusterBuffer
+{
+	uvec2 _Clusters[]; //Offset into _LightIndices and count, per cluster
+};
+
+layout(std430, binding = 5) readonly buffer LightIndexBuffer
+{
+	uint _LightIndices[];
+};
+
+layout(std140, binding = 2) uniform ClusterBlock
+{
+	mat4 _ClusterView;
+	uvec4 _ClusterGrid; //Clusters in x, y and z, and the number of lights
+	vec4 _ClusterDepth; //Near plane, far plane, slices / log(far / near)
+	vec4 _ClusterTileSize; //Pixels per cluster
+};
+
+layout(std140, binding = 1) uniform MaterialBlock
+{
+	Material _Material;
+};
 
-uniform Material _Material;
 uniform vec3 _CameraPosition;
 uniform sampler2D _Texture;
 
@@ -33,11 +58,11 @@ void main(){
 	
 	
 
-	int numOfLights = numLights;
-	if(numLights > 4)
-	{
-		numOfLights = 4;
-	}
+	//Find this fragment's cluster: screen tile from gl_FragCoord, log depth slice from view depth
+	float viewDepth = -(_ClusterView * vec4(fs_in.WorldPosition,1)).z;
+	uint slice = uint(clamp(log(max(viewDepth,_ClusterDepth.x) / _ClusterDepth.x) * _ClusterDepth.z, 0.0, float(_ClusterGrid.z - 1)));
+	uvec2 tile = min(uvec2(gl_FragCoord.xy / _ClusterTileSize.xy), _ClusterGrid.xy - 1);
+	uvec2 cluster = _Clusters[(slice * _ClusterGrid.y + tile.y) * _ClusterGrid.x + tile.x];
 
 	vec4 newTex = texture(_Texture,fs_in.UV);
 	vec3 texColor = newTex.rgb;
@@ -48,10 +73,20 @@ void main(){
 
 	vec3 totalLight = vec3(0);
 
-	for(int i = 0; i < numOfLights; i++)
+	for(uint c = 0; c < cluster.y; c++)
 	{
+	uint i = _LightIndices[cluster.x + c];
 	vec3 LightPosition = _Lights[i].position;
 	vec3 omega = normalize(LightPosition - position); //Omega Vector
+	//Windowed falloff so a light is exactly 0 at its radius
+	float radius = _Lights[i].radius;
+	float falloff = 1.0;
+	if(radius > 0.0)
+	{
+		float d = length(LightPosition - position) / radius;
+		falloff = clamp(1.0 - d * d * d * d, 0.0, 1.0);
+		falloff *= falloff;
+	}
 	vec3 v = normalize(_CameraPosition - position);
 	vec3 h = normalize(omega + v);
 
@@ -59,9 +94,9 @@ void main(){
 	vec3 Dif = _Lights[i].color * _Material.diffuseK * max(dot(omega, normal),0);
 	vec3 Spec = _Lights[i].color * _Material.specular * pow(max(dot(h,normal),0),_Material.shininess);
 
-	totalLight += Amb;
-	totalLight += Dif;
-	totalLight += Spec;
+	totalLight += Amb * falloff;
+	totalLight += Dif * falloff;
+	totalLight += Spec * falloff;
 	}
 
 	texColor *= totalLight;
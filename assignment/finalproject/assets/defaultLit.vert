@@ -1,5 +1,7 @@
 #version 450
-layout(location = 0) in vec3 vPos;
+//Either ew::Vertex or ew::CompactVertex, see ew::SetupVertexFormat.
+//Compact vertices have half float positions with w = 0 and octahedral normals in xy.
+layout(location = 0) in vec4 vPos;
 layout(location = 1) in vec3 vNormal;
 layout(location = 2) in vec2 vUV;
 
@@ -12,9 +14,21 @@ out Surface{
 uniform mat4 _Model;
 uniform mat4 _ViewProjection;
 
+//Same as ew::OctahedralDecode
+vec3 octDecode(vec2 e){
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0);
+	n.x += n.x >= 0.0 ? -t : t;
+	n.y += n.y >= 0.0 ? -t : t;
+	return normalize(n);
+}
+
 void main(){
+	//Float positions are vec3, so w reads as the default 1
+	vec3 normal = vPos.w == 0.0 ? octDecode(vNormal.xy) : vNormal;
+	vec4 position = vec4(vPos.xyz, 1.0);
 	vs_out.UV = vUV;
-	vs_out.WorldPosition = vec3(_Model * vec4(vPos,1));
-	vs_out.WorldNormal = transpose(inverse(mat3(_Model))) * vNormal;
-	gl_Position = _ViewProjection * _Model * vec4(vPos,1.0);
+	vs_out.WorldPosition = vec3(_Model * position);
+	vs_out.WorldNormal = transpose(inverse(mat3(_Model))) * normal;
+	gl_Position = _ViewProjection * _Model * position;
 }
\ No newline at end of file
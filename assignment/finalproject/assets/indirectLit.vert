@@ -0,0 +1,49 @@
+#version 450
+#extension GL_ARB_shader_draw_parameters : require
+//defaultLit.vert for ew::GeometryArena draws. Each draw reads its model matrix from _Draws[gl_DrawIDARB].
+//Either ew::Vertex or ew::CompactVertex, see ew::SetupVertexFormat.
+//Compact vertices have half float positions with w = 0 and octahedral normals in xy.
+layout(location = 0) in vec4 vPos;
+layout(location = 1) in vec3 vNormal;
+layout(location = 2) in vec2 vUV;
+
+out Surface{
+	vec2 UV;
+	vec3 WorldPosition;
+	vec3 WorldNormal;
+}vs_out;
+flat out vec4 Emissive;
+
+//Must match ew::IndirectDrawData and ew::DRAW_BLOCK_BINDING
+struct DrawData
+{
+	mat4 model;
+	vec4 color; //Unlit color when alpha > 0
+};
+layout(std430, binding = 2) readonly buffer DrawBlock
+{
+	DrawData _Draws[];
+};
+
+uniform mat4 _ViewProjection;
+
+//Same as ew::OctahedralDecode
+vec3 octDecode(vec2 e){
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0);
+	n.x += n.x >= 0.0 ? -t : t;
+	n.y += n.y >= 0.0 ? -t : t;
+	return normalize(n);
+}
+
+void main(){
+	mat4 model = _Draws[gl_DrawIDARB].model;
+	Emissive = _Draws[gl_DrawIDARB].color;
+	//Float positions are vec3, so w reads as the default 1
+	vec3 normal = vPos.w == 0.0 ? octDecode(vNormal.xy) : vNormal;
+	vec4 position = vec4(vPos.xyz, 1.0);
+	vs_out.UV = vUV;
+	vs_out.WorldPosition = vec3(model * position);
+	vs_out.WorldNormal = transpose(inverse(mat3(model))) * normal;
+	gl_Position = _ViewProjection * model * position;
+}
\ No newline at end of file
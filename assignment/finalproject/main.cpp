@@ -9,18 +9,33 @@
 #include <imgui_impl_opengl3.h>
 
 #include <ew/shader.h>
-#include <ew/texture.h>
 #include <ew/procGen.h>
 #include <ew/transform.h>
 #include <ew/camera.h>
 #include <ew/cameraController.h>
+#include <ew/lightingUniforms.h>
+#include <ew/lightClusters.h>
+#include <ew/frustum.h>
+#include <ew/bvh.h>
+#include <ew/meshOptimizer.h>
+#include <ew/geometryArena.h>
+#include <ew/renderQueue.h>
+#include <ew/glState.h>
+#include <ew/headless.h>
+#include <ew/profiler.h>
+#include <ew/random.h>
+#include <ew/sceneGenerator.h>
+#include <ew/textureLoader.h>
+#include <ew/textureAtlas.h>
 
 #include <qm/procGen.h>
 #include <qm/transformations.h>
+#include <qm/billboardBatch.h>
 #include "assets/orbit.h"
 
 void framebufferSizeCallback(GLFWwindow* window, int width, int height);
 void resetCamera(ew::Camera& camera, ew::CameraController& cameraController);
+void cursorRay(GLFWwindow* window, const ew::Camera& camera, ew::Vec3* origin, ew::Vec3* direction);
 
 int SCREEN_WIDTH = 1080;
 int SCREEN_HEIGHT = 720;
@@ -37,11 +52,15 @@ ew::CameraController cameraController;
 // orbit and controls
 akc::Orbit orbit;
 bool orbiting = false, orbitInitial = true;
+bool frustumCulling = true;
+bool wasClicking = false;
+bool wavePlane = false;
 
 struct Light
 {
 	ew::Vec3 position; //World space
 	ew::Vec3 color; //RGB
+	float radius = 0; //Fades out by this distance, 0 reaches everything
 };
 
 struct Material
@@ -52,17 +71,33 @@ struct Material
 	float shininess; //Shininess
 };
 
-int main() {
-	printf("Initializing...");
-	if (!glfwInit()) {
-		printf("GLFW failed to init!");
+int main(int argc, char** argv) {
+	//--headless --frames N renders offscreen for batch perf runs, see ew::HeadlessOptions
+	ew::HeadlessOptions headlessOptions;
+	if (!ew::ParseHeadlessOptions(argc, argv, headlessOptions)) {
 		return 1;
 	}
+	printf("Initializing...");
+	GLFWwindow* window;
+	if (headlessOptions.enabled) {
+		SCREEN_WIDTH = headlessOptions.width;
+		SCREEN_HEIGHT = headlessOptions.height;
+		window = ew::CreateHeadlessWindow(SCREEN_WIDTH, SCREEN_HEIGHT);
+		if (window == NULL) {
+			return 1;
+		}
+	}
+	else {
+		if (!glfwInit()) {
+			printf("GLFW failed to init!");
+			return 1;
+		}
 
-	GLFWwindow* window = glfwCreateWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Camera", NULL, NULL);
-	if (window == NULL) {
-		printf("GLFW failed to create window");
-		return 1;
+		window = glfwCreateWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Camera", NULL, NULL);
+		if (window == NULL) {
+			printf("GLFW failed to create window");
+			return 1;
+		}
 	}
 	glfwMakeContextCurrent(window);
 	glfwSetFramebufferSizeCallback(window, framebufferSizeCallback);
@@ -80,33 +115,48 @@ int main() {
 //Hello
 
 	//Global settings
-	glEnable(GL_CULL_FACE);
-	glCullFace(GL_BACK);
-	glEnable(GL_DEPTH_TEST);
+	ew::GLState::setEnabled(GL_CULL_FACE, true);
+	ew::GLState::cullFace(GL_BACK);
+	ew::GLState::setEnabled(GL_DEPTH_TEST, true);
 
 	ew::Shader shader("assets/defaultLit.vert", "assets/defaultLit.frag");
-	ew::Shader unlitShader("assets/unlit.vert", "assets/unlit.frag");
+	ew::Shader indirectShader("assets/indirectLit.vert", "assets/indirectLit.frag");
 	//Zach: Put in shader line for billboard
 	ew::Shader billboardingShader("assets/billboard.vert", "assets/billboard.frag");
-	unsigned int brickTexture = ew::loadTexture("assets/brick_color.jpg", GL_REPEAT, GL_LINEAR);
-	unsigned int BBTexture = ew::loadTexture("assets/Blob.png", GL_REPEAT, GL_LINEAR);
-	
-
-	//Create cube
-	ew::Mesh planeMesh(ew::createPlane(8, 8, 10));
-
-	ew::Mesh vertPlaneMesh(qm::createVertPlane(1.0f,10));
-
-	ew::Mesh sphereMesh(ew::createSphere(0.5f, 64));
+	//Decoded on worker threads, placeholders are drawn until each one is uploaded.
+	//Files cooked by the cookAssetsFP target (.ewtex next to each image) are uploaded directly.
+	ew::TextureLoader textureLoader;
+	unsigned int brickTexture = textureLoader.load("assets/brick_color.jpg", GL_REPEAT, GL_LINEAR);
+	//Every billboard sprite is packed into one array texture, so all billboard batches share one bind
+	ew::TextureAtlas spriteAtlas(2048, 16, 1024);
+	int blobSprite = spriteAtlas.add("assets/Blob.png");
+	int treeSprite = spriteAtlas.add("assets/Tree.png", true);
+	int riveSprite = spriteAtlas.add("assets/Rive.png", true);
+	spriteAtlas.build();
+
+	//Reordered for the post transform cache, see benchmark/mesh_optimizer_stats.
+	//High vertex count meshes use the 16 byte compact vertex format.
+	ew::MeshData sphereMeshData = ew::createSphere(0.5f, 64);
+	ew::OptimizeMesh(sphereMeshData);
+	ew::Mesh sphereMesh(sphereMeshData, ew::VertexFormat::COMPACT);
 	ew::Mesh cylinderMesh(ew::createCylinder(0.5f, 1.0f, 32));
 
-	ew::Mesh unlitsphereMeshR(ew::createSphere(0.125f, 32));
-	ew::Mesh unlitsphereMeshG(ew::createSphere(0.125f, 32));
-	ew::Mesh unlitsphereMeshY(ew::createSphere(0.125f, 32));
-	ew::Mesh unlitsphereMeshB(ew::createSphere(0.125f, 32));
+	//The plane, cube and light spheres share one vertex and index buffer and draw in one call.
+	//The light spheres are identical, so the arena stores that mesh once. Everything in it uses the compact vertex format.
+	ew::GeometryArena arena(1 << 16, 1 << 17, ew::VertexFormat::COMPACT);
+	int planeMesh = arena.add(ew::createPlane(8, 8, 10, nullptr, ew::Topology::TRIANGLE_STRIP));
+	int cubeMesh = arena.add(ew::createCube(0.5f));
+	int unlitSphereMesh = arena.add(ew::createSphere(0.125f, 32));
+	int litSphereMesh = arena.add(ew::createSphere(0.5f, 16));
+
+	//Sorted by shader and texture every frame so each is bound once
+	ew::RenderQueue renderQueue;
 
-	ew::MeshData cubeMeshData = ew::createCube(0.5f);
-	ew::Mesh cubeMesh(cubeMeshData);
+	//Rewritten every frame straight into mapped memory
+	ew::MeshData waveMeshData = ew::createPlane(8, 8, 64);
+	ew::Mesh waveMesh(waveMeshData, ew::MeshUsage::STREAMING);
+	ew::Transform waveTransform;
+	waveTransform.position = ew::Vec3(0, -1.0f, -8.0f);
 
 
 	//Initialize transforms
@@ -124,39 +174,104 @@ int main() {
 
 	// verPlaneTransform.position = ew::Vec3(0, 0, 0);
 
-	ew::Transform unlitRed;
-	ew::Transform unlitGreen;
-	ew::Transform unlitYellow;
-	ew::Transform unlitBlue;
-
-	// array of billboards, initialize positions - Atticus Clark
-	const int MAX_BILLBOARDS = 10;
+	// batch of billboards, initialize positions - Atticus Clark
+	const int MAX_BILLBOARDS = 100000;
+	const int EDITABLE_BILLBOARDS = 10; //Only the first few get position widgets
 	int activeBillboards = 2;
-	qm::BillBoardTransform billboards[MAX_BILLBOARDS];
+	int billboardMode = (int)qm::BillboardMode::Spherical;
+	qm::BillboardBasis billboardBasis; //Kept across frames, see qm::billBoardBasis
+	ew::MeshData billboardQuad = qm::createVertPlane(1.0f, 1, ew::Topology::TRIANGLE_STRIP);
+	qm::BillboardBatch billboards(billboardQuad, MAX_BILLBOARDS);
 
 	for(int i = 0; i < MAX_BILLBOARDS; i++) {
-		billboards[i].position = ew::Vec3(0, i * 2, 0);
+		billboards.add(ew::Vec3(0, i * 2, 0), ew::Vec2(1.0f), spriteAtlas.getSprite(blobSprite));
+	}
+	billboards.setCount(activeBillboards);
+
+	//BVH over the active billboards for click picking, rebuilt when the count changes
+	ew::BVH billboardBVH;
+	int bvhBillboards = -1;
+	int selectedBillboard = -1;
+	auto billboardBounds = [&](int i) {
+		ew::AABB box;
+		float radius = billboards.getBoundingRadius(i);
+		box.min = billboards.getInstance(i).position - ew::Vec3(radius);
+		box.max = billboards.getInstance(i).position + ew::Vec3(radius);
+		return box;
+	};
+	auto moveBillboard = [&](int i, const ew::Vec3& position) {
+		billboards.setPosition(i, position);
+		if (i < billboardBVH.getObjectCount()) {
+			billboardBVH.refit(i, billboardBounds(i));
+		}
+	};
+
+	//Benchmark scene from --scene, generated from its seed so every run and build draws the same thing
+	ew::SceneConfig sceneConfig;
+	ew::GeneratedScene scene;
+	if (!headlessOptions.scene.empty()) {
+		std::string scenePath = ew::GetScenePath(headlessOptions.scene);
+		if (!ew::LoadSceneConfig(scenePath.c_str(), sceneConfig)) {
+			return 1;
+		}
+		scene = ew::GenerateScene(sceneConfig);
+		printf("Scene %s: %d meshes, %d lights, %d billboards\n", sceneConfig.name.c_str(),
+			(int)scene.meshes.size(), (int)scene.lights.size(), (int)scene.billboards.size());
+	}
+	//Mesh kinds index this, the models never change
+	int sceneMeshKinds[2] = { cubeMesh, litSphereMesh };
+	std::vector<ew::Mat4> sceneModels(scene.meshes.size());
+	for (size_t i = 0; i < scene.meshes.size(); i++) {
+		sceneModels[i] = scene.meshes[i].transform.getModelMatrix();
 	}
 
+	//Foliage field scattered around the plane, or the scene's billboards. Trees and Rives are mixed in one batch, told apart by their atlas sprite.
+	const int MAX_FOLIAGE = 100000;
+	int activeFoliage = 0;
+	qm::BillboardBatch foliage(billboardQuad, MAX_FOLIAGE);
+	if (scene.billboards.empty()) {
+		ew::Random foliageRandom(1);
+		for (int i = 0; i < MAX_FOLIAGE; i++) {
+			int sprite = (i % 4 == 0) ? riveSprite : treeSprite;
+			float size = foliageRandom.range(0.75f, 2.0f);
+			foliage.add(ew::Vec3(foliageRandom.range(-100.0f, 100.0f), -1.0f + size * 0.5f, foliageRandom.range(-100.0f, 100.0f)), ew::Vec2(size), spriteAtlas.getSprite(sprite));
+		}
+		foliage.setCount(0);
+	}
+	else {
+		//Sprite kinds index this
+		int sceneSprites[3] = { treeSprite, riveSprite, blobSprite };
+		for (size_t i = 0; i < scene.billboards.size() && i < MAX_FOLIAGE; i++) {
+			const ew::GeneratedBillboard& billboard = scene.billboards[i];
+			foliage.add(billboard.position, billboard.size, spriteAtlas.getSprite(sceneSprites[billboard.kind % 3]));
+		}
+		activeFoliage = foliage.getCount();
+	}
 
-	//Light Array
-	Light _lights[4];
-	int lights = 4;
+
+	//Light Array, replaced by the scene's lights if it has any
+	std::vector<Light> _lights(4);
 	_lights[0].color = ew::Vec3(1, 0, 0);
 	_lights[0].position = ew::Vec3(5, 1, 0);
-	unlitRed.position = _lights[0].position;
 
 	_lights[1].color = ew::Vec3(0, 1, 0);
 	_lights[1].position = ew::Vec3(5, 1, -5);
-	unlitGreen.position = _lights[1].position;
 
 	_lights[2].color = ew::Vec3(1, 1, 0);
 	_lights[2].position = ew::Vec3(0, 1, 5);
-	unlitYellow.position = _lights[2].position;
 
 	_lights[3].color = ew::Vec3(0, 0, 1);
 	_lights[3].position = ew::Vec3(-5, 1, 5);
-	unlitBlue.position = _lights[3].position;
+
+	if (!scene.lights.empty()) {
+		_lights.resize(scene.lights.size());
+		for (size_t i = 0; i < scene.lights.size(); i++) {
+			_lights[i].position = scene.lights[i].position;
+			_lights[i].color = scene.lights[i].color;
+			_lights[i].radius = scene.lights[i].radius;
+		}
+	}
+	int lights = (int)_lights.size();
 
 	Material _material;
 	_material.ambientK = 0.2;
@@ -164,18 +279,49 @@ int main() {
 	_material.specular = 0.5;
 	_material.shininess = 128;
 
+	//Lights and material are shared by every lit shader
+	ew::LightingUniforms lightingUniforms;
+	//Per cluster light lists, so each fragment only shades the lights that reach it
+	ew::LightClusters lightClusters;
+
+	ew::CullStats cullStats;
+
 	resetCamera(camera, cameraController);
+	if (!headlessOptions.scene.empty()) {
+		camera.farPlane = sceneConfig.farPlane;
+	}
 
-	while (!glfwWindowShouldClose(window)) {
+	//Headless runs draw into an offscreen target on a fixed time step.
+	//Textures are finished up front so every run renders the same frames.
+	ew::HeadlessRun headlessRun(headlessOptions);
+	ew::Profiler profiler;
+	if (headlessRun.isHeadless()) {
+		textureLoader.finish();
+	}
+	while (headlessRun.isRunning(window)) {
 		glfwPollEvents();
+		headlessRun.beginFrame();
+		profiler.beginFrame();
+		ew::GLState::beginFrame();
+		{
+			ew::ProfileScope scope(profiler, "Texture streaming");
+			textureLoader.update(2.0f);
+		}
 
-		float time = (float)glfwGetTime();
+		float time = headlessRun.getTime();
 		float deltaTime = time - prevTime;
 		prevTime = time;
 
 		// Update camera - modified by Atticus Clark
+		int cameraScope = profiler.beginScope("Camera update", false);
 		camera.aspectRatio = (float)SCREEN_WIDTH / SCREEN_HEIGHT;
-		if(orbiting) {
+		if (!sceneConfig.cameraPath.empty()) {
+			//Scripted, so frame times line up across runs. Interactive runs loop it.
+			float duration = ew::GetCameraPathDuration(sceneConfig.cameraPath);
+			float pathTime = headlessRun.isHeadless() || duration <= 0.0f ? time : fmodf(time, duration);
+			ew::SampleCameraPath(sceneConfig.cameraPath, pathTime, camera.position, camera.target);
+		}
+		else if(orbiting) {
 			// fly camera breaks orbit function anyway
 			/*
 			if(orbitInitial) {
@@ -202,87 +348,177 @@ int main() {
 			}
 			cameraController.Move(window, &camera, deltaTime);
 		}
+		profiler.endScope(cameraScope);
+
+		//Billboard picking
+		int pickingScope = profiler.beginScope("Picking", false);
+		if (activeBillboards != bvhBillboards) {
+			std::vector<ew::AABB> boxes(activeBillboards);
+			for (int i = 0; i < activeBillboards; i++) {
+				boxes[i] = billboardBounds(i);
+			}
+			billboardBVH.build(boxes.data(), activeBillboards);
+			bvhBillboards = activeBillboards;
+			if (selectedBillboard >= activeBillboards) {
+				selectedBillboard = -1;
+			}
+		}
+		bool clicking = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+		if (clicking && !wasClicking && !ImGui::GetIO().WantCaptureMouse) {
+			ew::Vec3 rayOrigin, rayDirection;
+			cursorRay(window, camera, &rayOrigin, &rayDirection);
+			selectedBillboard = billboardBVH.raycast(rayOrigin, rayDirection).object;
+		}
+		wasClicking = clicking;
+		profiler.endScope(pickingScope);
 
 		//RENDER
 		glClearColor(bgColor.x, bgColor.y, bgColor.z, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		shader.use();
-
-		billboardingShader.use();
-		
-		shader.setInt("_Texture", 0);
-		shader.setMat4("_ViewProjection", camera.ProjectionMatrix() * camera.ViewMatrix());
-
-		//TODO: Render point lights
-		shader.setVec3("_Lights[0].position", _lights[0].position);
-		shader.setVec3("_Lights[0].color", _lights[0].color); 
-
-		shader.setVec3("_Lights[1].position", _lights[1].position);
-		shader.setVec3("_Lights[1].color", _lights[1].color);
-
-		shader.setVec3("_Lights[2].position", _lights[2].position);
-		shader.setVec3("_Lights[2].color", _lights[2].color);
-
-		shader.setVec3("_Lights[3].position", _lights[3].position);
-		shader.setVec3("_Lights[3].color", _lights[3].color);
-
-		shader.setInt("numLights", lights);
-
-		shader.setFloat("_Material.ambientK", _material.ambientK);
-		shader.setFloat("_Material.diffuseK", _material.diffuseK);
-		shader.setFloat("_Material.specular", _material.specular);
-		shader.setFloat("_Material.shininess", _material.shininess);
-
-		shader.setVec3("_CameraPosition", camera.position);
-
-		glBindTexture(GL_TEXTURE_2D, brickTexture);
-		shader.setMat4("_Model", planeTransform.getModelMatrix());
-		planeMesh.draw();
+		//Only uploads when a light or the material actually changed
+		lightingUniforms.setNumLights(lights);
+		for (int i = 0; i < lights; i++) {
+			lightingUniforms.setLight(i, _lights[i].position, _lights[i].color, _lights[i].radius);
+		}
+		lightingUniforms.setMaterial(_material.ambientK, _material.diffuseK, _material.specular, _material.shininess);
+		lightingUniforms.bind();
+		{
+			ew::ProfileScope scope(profiler, "Light clustering", false);
+			lightClusters.build(lightingUniforms.getLights(), lights, camera, SCREEN_WIDTH, SCREEN_HEIGHT);
+			lightClusters.bind();
+		}
 
-		shader.setMat4("_Model", cubeTransform.getModelMatrix());
-		cubeMesh.draw();
+		int submitScope = profiler.beginScope("Culling and submission", false);
+		ew::Mat4 viewProjection = camera.ProjectionMatrix() * camera.ViewMatrix();
+
+		//Frustum culling, counts are shown under Performance
+		ew::Frustum frustum = ew::ExtractFrustum(viewProjection);
+		cullStats = ew::CullStats();
+		auto meshVisible = [&](const ew::Bounds& bounds, const ew::Mat4& model) {
+			bool visible = !frustumCulling || ew::IsVisible(frustum, bounds, model);
+			(visible ? cullStats.visible : cullStats.culled)++;
+			return visible;
+		};
+
+		//Queue the arena's draws on the CPU, then submit them together
+		arena.clearDraws();
+		ew::Mat4 planeModel = planeTransform.getModelMatrix();
+		if (meshVisible(arena.getBounds(planeMesh), planeModel)) {
+			arena.addDraw(planeMesh, planeModel);
+		}
+		ew::Mat4 cubeModel = cubeTransform.getModelMatrix();
+		if (meshVisible(arena.getBounds(cubeMesh), cubeModel)) {
+			arena.addDraw(cubeMesh, cubeModel);
+		}
+		for (size_t i = 0; i < scene.meshes.size(); i++) {
+			int mesh = sceneMeshKinds[scene.meshes[i].kind % 2];
+			if (meshVisible(arena.getBounds(mesh), sceneModels[i])) {
+				arena.addDraw(mesh, sceneModels[i]);
+			}
+		}
+		for (int i = 0; i < lights; i++)
+		{
+			ew::Mat4 unlitModel = ew::Translate(_lights[i].position);
+			if (meshVisible(arena.getBounds(unlitSphereMesh), unlitModel)) {
+				//Dim scene lights still show their hue at full brightness
+				ew::Vec3 color = _lights[i].color;
+				float peak = fmaxf(color.x, fmaxf(color.y, color.z));
+				arena.addDraw(unlitSphereMesh, unlitModel, ew::Vec4(peak > 0.0f ? color / peak : color, 1.0f));
+			}
+		}
 
-		billboardingShader.use();
-		glBindTexture(GL_TEXTURE_2D, BBTexture);
+		//Per frame uniforms. Shader setters don't need the program bound, the queue binds each one once.
+		indirectShader.setInt(EW_UNIFORM("_Texture"), 0);
+		indirectShader.setMat4(EW_UNIFORM("_ViewProjection"), viewProjection);
+		indirectShader.setVec3(EW_UNIFORM("_CameraPosition"), camera.position);
+		shader.setInt(EW_UNIFORM("_Texture"), 0);
+		shader.setMat4(EW_UNIFORM("_ViewProjection"), viewProjection);
+		shader.setVec3(EW_UNIFORM("_CameraPosition"), camera.position);
+		billboardingShader.setInt(EW_UNIFORM("_Texture"), 0);
+		billboardingShader.setMat4(EW_UNIFORM("_ViewProjection"), viewProjection);
+		billboardingShader.setVec3(EW_UNIFORM("_CameraPosition"), camera.position);
+		billboardBasis = qm::billBoardBasis(camera, (qm::BillboardMode)billboardMode, billboardBasis);
+		billboardingShader.setVec3(EW_UNIFORM("_BillboardRight"), billboardBasis.right);
+		billboardingShader.setVec3(EW_UNIFORM("_BillboardUp"), billboardBasis.up);
+		billboardingShader.setVec3(EW_UNIFORM("_BillboardForward"), billboardBasis.forward);
+
+		renderQueue.setMaxDepth(camera.farPlane);
+		ew::DrawItem arenaItem;
+		arenaItem.shader = &indirectShader;
+		arenaItem.texture = brickTexture;
+		//The unlit light spheres are arena draws too, so the lit and unlit passes are one multi-draw
+		arenaItem.draw = [&]() {
+			ew::ProfileScope scope(profiler, "Lit + unlit pass");
+			arena.drawAll();
+		};
+		renderQueue.submit(arenaItem);
+
+		if (wavePlane) {
+			ew::Vertex* waveVertices = waveMesh.mapVertices();
+			for (size_t i = 0; i < waveMeshData.vertices.size(); i++)
+			{
+				ew::Vertex v = waveMeshData.vertices[i];
+				float phase = v.pos.x * 2.0f + v.pos.z + time * 2.0f;
+				v.pos.y = sinf(phase) * 0.25f;
+				float slope = cosf(phase) * 0.25f; //d(height)/d(phase)
+				v.normal = ew::Normalize(ew::Vec3(-slope * 2.0f, 1.0f, -slope));
+				waveVertices[i] = v;
+			}
+			waveMesh.unmapVertices((int)waveMeshData.vertices.size());
+			ew::DrawItem waveItem;
+			waveItem.shader = &shader;
+			waveItem.texture = brickTexture;
+			waveItem.mesh = &waveMesh;
+			waveItem.model = waveTransform.getModelMatrix();
+			waveItem.depth = ew::Magnitude(waveTransform.position - camera.position);
+			renderQueue.submit(waveItem);
+		}
 
 		// draw multiple billboards - Atticus Clark
-		for(int i = 0; i < activeBillboards; i++) {
-			billboardingShader.setMat4("_Model", billboards[i].getModelMatrix(camera));
-			vertPlaneMesh.draw();
+		billboards.setCount(activeBillboards);
+		foliage.setCount(activeFoliage);
+		if (frustumCulling) {
+			cullStats += billboards.cull(frustum);
+			cullStats += foliage.cull(frustum);
+		}
+		else {
+			cullStats.visible += billboards.getCount() + foliage.getCount();
 		}
+		qm::BillboardBatch* batches[2] = { &billboards, &foliage };
+		for (int i = 0; i < 2; i++)
+		{
+			ew::DrawItem batchItem;
+			batchItem.shader = &billboardingShader;
+			batchItem.texture = spriteAtlas.getTexture();
+			batchItem.textureArray = true;
+			qm::BillboardBatch* batch = batches[i];
+			batchItem.draw = [batch, &profiler]() {
+				ew::ProfileScope scope(profiler, "Billboard pass");
+				batch->draw();
+			};
+			renderQueue.submit(batchItem);
+		}
+
+		profiler.endScope(submitScope);
 
+		{
+			//Lit wave plane draws show up as the queue's own time
+			ew::ProfileScope scope(profiler, "Render queue");
+			renderQueue.flush();
+		}
 
 		if (move)
 		{
-			billboards[0].position = billboards[0].position + (sin(time) * _Vector);
+			moveBillboard(0, billboards.getInstance(0).position + (sin(time) * _Vector));
 		}
 
 		// shader.setMat4("_Model", verPlaneTransform.getModelMatrix(camera));
 		// vertPlaneMesh.draw();
 
-		unlitShader.use();
-
-		unlitShader.setMat4("_ViewProjection", camera.ProjectionMatrix() * camera.ViewMatrix());
-
-		unlitShader.setMat4("_Model", unlitRed.getModelMatrix());
-		unlitShader.setVec3("_Color", _lights[0].color);
-		unlitsphereMeshR.draw();
-
-		unlitShader.setMat4("_Model", unlitGreen.getModelMatrix());
-		unlitShader.setVec3("_Color", _lights[1].color);
-		unlitsphereMeshG.draw();
-
-		unlitShader.setMat4("_Model", unlitYellow.getModelMatrix());
-		unlitShader.setVec3("_Color", _lights[2].color);
-		unlitsphereMeshY.draw();
-
-		unlitShader.setMat4("_Model", unlitBlue.getModelMatrix());
-		unlitShader.setVec3("_Color", _lights[3].color);
-		unlitsphereMeshB.draw();
-
 		//Render UI
 		{
+			ew::ProfileScope scope(profiler, "UI");
 			ImGui_ImplGlfw_NewFrame();
 			ImGui_ImplOpenGL3_NewFrame();
 			ImGui::NewFrame();
@@ -318,25 +554,83 @@ int main() {
 			// billboard controls - Atticus Clark
 			if(ImGui::CollapsingHeader("Billboards")) {
 				ImGui::DragInt("# of Billboards", &activeBillboards, 0.1f, 0, MAX_BILLBOARDS);
+				ImGui::Combo("Facing", &billboardMode, "Spherical\0Cylindrical\0");
+				if (selectedBillboard >= 0) {
+					ImGui::Text("Selected billboard: %d", selectedBillboard);
+					ew::Vec3 position = billboards.getInstance(selectedBillboard).position;
+					if (ImGui::DragFloat3("Selected Position", &position.x, 0.1f)) {
+						moveBillboard(selectedBillboard, position);
+					}
+				}
+				else {
+					ImGui::Text("Click a billboard to select it");
+				}
 
-				for(int i = 0; i < activeBillboards; i++) {
+				for(int i = 0; i < activeBillboards && i < EDITABLE_BILLBOARDS; i++) {
 					ImGui::PushID(i);
-					ImGui::DragFloat3("Billboard Position", &billboards[i].position.x, 0.1f);
+					ew::Vec3 position = billboards.getInstance(i).position;
+					if (ImGui::DragFloat3("Billboard Position", &position.x, 0.1f)) {
+						moveBillboard(i, position);
+					}
 					ImGui::PopID();
 				}
 			}
 
+			if (ImGui::CollapsingHeader("Foliage")) {
+				ImGui::DragInt("# of Sprites", &activeFoliage, 100.0f, 0, MAX_FOLIAGE);
+			}
+
 			ImGui::ColorEdit3("BG color", &bgColor.x);
 
+			if (ImGui::CollapsingHeader("Profiler")) {
+				profiler.drawUI();
+			}
+
+			if (ImGui::CollapsingHeader("Performance")) {
+				unsigned long long lookupsAvoided = shader.getLookupsAvoided() + indirectShader.getLookupsAvoided() + billboardingShader.getLookupsAvoided();
+				ImGui::Text("Uniform lookups avoided: %llu", lookupsAvoided);
+				ImGui::Text("Lighting buffer uploads: %u", lightingUniforms.getUploadCount());
+				const ew::LightClusterStats& clusterStats = lightClusters.getStats();
+				ImGui::Text("Light clusters: %d lights (%d culled), %d indices, max %d per cluster, %d dropped, %.2f ms",
+					clusterStats.lights, clusterStats.culledLights, clusterStats.indices, clusterStats.maxPerCluster, clusterStats.dropped, clusterStats.buildMs);
+				int vertexBytes = arena.getVertexBufferSize() + sphereMesh.getVertexBufferSize() + cylinderMesh.getVertexBufferSize();
+				ImGui::Text("Mesh vertex memory: %.1f KB", vertexBytes / 1024.0f);
+				int indexBytes = arena.getIndexBufferSize() + sphereMesh.getIndexBufferSize() + cylinderMesh.getIndexBufferSize();
+				ImGui::Text("Mesh index memory: %.1f KB", indexBytes / 1024.0f);
+				ImGui::Text("Arena: %d meshes, %d draws in one call", arena.getMeshCount(), arena.getDrawCount());
+				const ew::RenderQueueStats& queueStats = renderQueue.getStats();
+				ImGui::Text("Render queue: %d items", queueStats.items);
+				ImGui::Text("Program binds: %d (%d avoided)", queueStats.shaderChanges, queueStats.shaderChangesAvoided);
+				ImGui::Text("Texture binds: %d (%d avoided)", queueStats.textureChanges, queueStats.textureChangesAvoided);
+				bool glStateDebug = ew::GLState::getDebug();
+				if (ImGui::Checkbox("Count GL state calls", &glStateDebug)) {
+					ew::GLState::setDebug(glStateDebug);
+				}
+				if (glStateDebug) {
+					const ew::GLStateCounters& glCalls = ew::GLState::getLastFrame();
+					ImGui::Text("GL state calls: %u issued, %u skipped", glCalls.totalIssued(), glCalls.totalSkipped());
+					const char* callNames[] = { "Program", "Vertex array", "Texture", "Enable/disable", "Blend func", "Depth mask", "Cull face", "Viewport" };
+					for (int i = 0; i < (int)ew::GLStateCall::COUNT; i++) {
+						ImGui::Text("  %s: %u / %u", callNames[i], glCalls.issued[i], glCalls.skipped[i]);
+					}
+				}
+				ImGui::Checkbox("Frustum culling", &frustumCulling);
+				ImGui::Checkbox("Streaming wave plane", &wavePlane);
+				ImGui::Text("Streaming stalls: %u", waveMesh.getStallCount());
+				const ew::TextureLoaderStats& textureStats = textureLoader.getStats();
+				ImGui::Text("Textures pending: %d, uploaded last frame: %d (%.2f ms)", textureStats.pending, textureStats.uploadsLastFrame, textureStats.uploadMsLastFrame);
+				ImGui::Text("Textures loaded cooked: %d", textureStats.cooked);
+				ImGui::Text("Sprite atlas: %d layer(s) of %d, %.0f%% used, %.1f MB", spriteAtlas.getLayerCount(), spriteAtlas.getPageSize(), spriteAtlas.getOccupancy() * 100.0f, spriteAtlas.getMemorySize() / (1024.0f * 1024.0f));
+				ImGui::Text("Visible: %d Culled: %d", cullStats.visible, cullStats.culled);
+			}
+
 			if (ImGui::CollapsingHeader("Movement"))
 			{
 				ImGui::Checkbox("Move", &move);
 				ImGui::DragFloat3("Direction", &_Vector.x,0.01f, -0.1f, 0.1f);
 				if (ImGui::Button("Reset", ImVec2(100, 0)))
 				{
-					billboards[0].position.x = 0;
-					billboards[0].position.y = 0;
-					billboards[0].position.z = 0;
+					moveBillboard(0, ew::Vec3(0, 0, 0));
 				}
 			}
 			
@@ -346,14 +640,20 @@ int main() {
 			ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 		}
 
-		glfwSwapBuffers(window);
+		profiler.endFrame();
+		headlessRun.endFrame(window);
+	}
+	headlessRun.finish();
+	if (!headlessOptions.tracePath.empty()) {
+		profiler.finish();
+		profiler.writeChromeTrace(headlessOptions.tracePath.c_str());
 	}
 	printf("Shutting down...");
 }
 
 void framebufferSizeCallback(GLFWwindow* window, int width, int height)
 {
-	glViewport(0, 0, width, height);
+	ew::GLState::viewport(0, 0, width, height);
 	SCREEN_WIDTH = width;
 	SCREEN_HEIGHT = height;
 }
@@ -371,3 +671,26 @@ void resetCamera(ew::Camera& camera, ew::CameraController& cameraController) {
 	cameraController.pitch = 0.0f;
 }
 
+//World space ray through the mouse cursor
+void cursorRay(GLFWwindow* window, const ew::Camera& camera, ew::Vec3* origin, ew::Vec3* direction) {
+	double mouseX, mouseY;
+	int width, height;
+	glfwGetCursorPos(window, &mouseX, &mouseY);
+	glfwGetWindowSize(window, &width, &height);
+	float x = (float)(mouseX / width) * 2.0f - 1.0f;
+	float y = 1.0f - (float)(mouseY / height) * 2.0f;
+
+	ew::Vec3 forward = ew::Normalize(camera.target - camera.position);
+	ew::Vec3 right = ew::Normalize(ew::Cross(forward, ew::Vec3(0, 1, 0)));
+	ew::Vec3 up = ew::Cross(right, forward);
+	if (camera.orthographic) {
+		float halfHeight = camera.orthoHeight * 0.5f;
+		*origin = camera.position + right * (x * halfHeight * camera.aspectRatio) + up * (y * halfHeight);
+		*direction = forward;
+	}
+	else {
+		float tanHalfFov = tanf(ew::Radians(camera.fov) * 0.5f);
+		*origin = camera.position;
+		*direction = ew::Normalize(forward + right * (x * tanHalfFov * camera.aspectRatio) + up * (y * tanHalfFov));
+	}
+}
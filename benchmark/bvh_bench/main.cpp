@@ -0,0 +1,173 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+
+#include <ew/ewMath/ewMath.h>
+#include <ew/camera.h>
+#include <ew/bvh.h>
+
+//Compares ew::BVH frustum, ray and nearest queries against a linear scan.
+//Usage: bvh_bench [queries] [objectCount...]   (default 1000 queries at 10k, 100k and 1M objects)
+
+static double elapsedMs(std::chrono::high_resolution_clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+static float rayBox(const ew::AABB& box, const ew::Vec3& origin, const ew::Vec3& direction) {
+	float tmin = 0.0f, tmax = 1e30f;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float o = (&origin.x)[axis], d = (&direction.x)[axis];
+		float t1 = ((&box.min.x)[axis] - o) / d, t2 = ((&box.max.x)[axis] - o) / d;
+		tmin = fmaxf(tmin, fminf(t1, t2));
+		tmax = fminf(tmax, fmaxf(t1, t2));
+	}
+	return tmin <= tmax ? tmin : -1.0f;
+}
+
+static float pointBox(const ew::AABB& box, const ew::Vec3& p) {
+	float dx = fmaxf(fmaxf(box.min.x - p.x, p.x - box.max.x), 0.0f);
+	float dy = fmaxf(fmaxf(box.min.y - p.y, p.y - box.max.y), 0.0f);
+	float dz = fmaxf(fmaxf(box.min.z - p.z, p.z - box.max.z), 0.0f);
+	return sqrtf(dx * dx + dy * dy + dz * dz);
+}
+
+static void report(const char* name, double bruteMs, double bvhMs, int queries, int mismatches) {
+	printf("  %-10s brute %9.3f ms (%9.2f us/query)   bvh %8.3f ms (%7.2f us/query)   speedup %7.1fx   mismatches %d\n",
+		name, bruteMs, bruteMs * 1e3 / queries, bvhMs, bvhMs * 1e3 / queries, bruteMs / bvhMs, mismatches);
+}
+
+static void run(int count, int queries) {
+	//Keep density constant so query cost reflects tree quality, not emptiness
+	float extent = 100.0f * cbrtf(count / 10000.0f);
+	std::vector<ew::AABB> boxes(count);
+	for (int i = 0; i < count; i++)
+	{
+		ew::Vec3 center = ew::Vec3(ew::RandomRange(-extent, extent), ew::RandomRange(-extent, extent), ew::RandomRange(-extent, extent));
+		ew::Vec3 half = ew::Vec3(ew::RandomRange(0.25f, 1.0f));
+		boxes[i].min = center - half;
+		boxes[i].max = center + half;
+	}
+
+	ew::BVH bvh;
+	auto start = std::chrono::high_resolution_clock::now();
+	bvh.build(boxes.data(), count);
+	double buildMs = elapsedMs(start);
+
+	//Move 1% of the objects a little, like animated billboards
+	int moved = count / 100;
+	start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < moved; i++)
+	{
+		ew::AABB box = boxes[i];
+		box.min += ew::Vec3(0.1f, 0, 0);
+		box.max += ew::Vec3(0.1f, 0, 0);
+		boxes[i] = box;
+		bvh.refit(i, box);
+	}
+	double refitMs = elapsedMs(start);
+	printf("%d objects: build %.2f ms, %d nodes, refit of %d moved objects %.3f ms\n", count, buildMs, bvh.getNodeCount(), moved, refitMs);
+
+	//Frustum queries from cameras scattered inside the volume
+	int frustumQueries = queries / 10 > 0 ? queries / 10 : 1;
+	std::vector<ew::Frustum> frustums(frustumQueries);
+	for (int q = 0; q < frustumQueries; q++)
+	{
+		ew::Camera camera;
+		camera.position = ew::Vec3(ew::RandomRange(-extent, extent), ew::RandomRange(-extent, extent), ew::RandomRange(-extent, extent));
+		camera.target = camera.position + ew::Vec3(ew::RandomRange(-1, 1), ew::RandomRange(-1, 1), ew::RandomRange(-1, 1));
+		frustums[q] = ew::ExtractFrustum(camera.ProjectionMatrix() * camera.ViewMatrix());
+	}
+	std::vector<int> results;
+	results.reserve(count);
+	int mismatches = 0;
+	std::vector<int> bruteCounts(frustumQueries);
+	start = std::chrono::high_resolution_clock::now();
+	for (int q = 0; q < frustumQueries; q++)
+	{
+		int visible = 0;
+		for (int i = 0; i < count; i++) {
+			visible += ew::AABBInFrustum(frustums[q], boxes[i].min, boxes[i].max);
+		}
+		bruteCounts[q] = visible;
+	}
+	double bruteMs = elapsedMs(start);
+	start = std::chrono::high_resolution_clock::now();
+	for (int q = 0; q < frustumQueries; q++)
+	{
+		results.clear();
+		mismatches += bvh.queryFrustum(frustums[q], results) != bruteCounts[q];
+	}
+	report("frustum", bruteMs, elapsedMs(start), frustumQueries, mismatches);
+
+	//Rays from random points in random directions
+	std::vector<ew::Vec3> origins(queries), directions(queries);
+	for (int q = 0; q < queries; q++)
+	{
+		origins[q] = ew::Vec3(ew::RandomRange(-extent, extent), ew::RandomRange(-extent, extent), ew::RandomRange(-extent, extent));
+		directions[q] = ew::Normalize(ew::Vec3(ew::RandomRange(-1, 1), ew::RandomRange(-1, 1), ew::RandomRange(-1, 1)));
+	}
+	std::vector<float> bruteDistances(queries);
+	start = std::chrono::high_resolution_clock::now();
+	for (int q = 0; q < queries; q++)
+	{
+		float closest = -1.0f;
+		for (int i = 0; i < count; i++)
+		{
+			float t = rayBox(boxes[i], origins[q], directions[q]);
+			if (t >= 0 && (closest < 0 || t < closest)) {
+				closest = t;
+			}
+		}
+		bruteDistances[q] = closest;
+	}
+	bruteMs = elapsedMs(start);
+	mismatches = 0;
+	start = std::chrono::high_resolution_clock::now();
+	for (int q = 0; q < queries; q++)
+	{
+		ew::RayHit hit = bvh.raycast(origins[q], directions[q]);
+		float distance = hit.object >= 0 ? hit.distance : -1.0f;
+		mismatches += fabsf(distance - bruteDistances[q]) > 1e-3f;
+	}
+	report("raycast", bruteMs, elapsedMs(start), queries, mismatches);
+
+	//Nearest object to random points
+	start = std::chrono::high_resolution_clock::now();
+	for (int q = 0; q < queries; q++)
+	{
+		float closest = 1e30f;
+		for (int i = 0; i < count; i++) {
+			closest = fminf(closest, pointBox(boxes[i], origins[q]));
+		}
+		bruteDistances[q] = closest;
+	}
+	bruteMs = elapsedMs(start);
+	mismatches = 0;
+	start = std::chrono::high_resolution_clock::now();
+	for (int q = 0; q < queries; q++)
+	{
+		float distance;
+		bvh.nearest(origins[q], &distance);
+		mismatches += fabsf(distance - bruteDistances[q]) > 1e-3f;
+	}
+	report("nearest", bruteMs, elapsedMs(start), queries, mismatches);
+}
+
+int main(int argc, char** argv) {
+	int queries = argc > 1 ? atoi(argv[1]) : 1000;
+	srand(1234);
+	if (argc > 2) {
+		for (int i = 2; i < argc; i++) {
+			run(atoi(argv[i]), queries);
+		}
+	}
+	else {
+		run(10000, queries);
+		run(100000, queries);
+		run(1000000, queries);
+	}
+	return 0;
+}
@@ -0,0 +1,220 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <functional>
+
+#include <ew/ewMath/ewMath.h>
+#include <ew/ewMath/transformations.h>
+#include <ew/transform.h>
+
+//ns/op and throughput of the ewMath operations the renderer leans on, over arrays too big for cache.
+//Usage: ewmath_bench [count] [iterations] [--baseline file] [--save-baseline file] [--tolerance fraction]
+//With --baseline the run fails (exit code 1) if any op got more than tolerance (default 0.15) slower than the file.
+//Baselines are per machine and per build type: record one with --save-baseline before the change.
+//An op over the threshold is measured again up to RECHECKS times before it counts, since shared machines are noisy.
+
+constexpr int RECHECKS = 3;
+
+struct Result {
+	std::string name;
+	double nsPerOp;
+	std::function<double()> measure;
+};
+
+static double elapsedNs(std::chrono::high_resolution_clock::time_point start) {
+	return std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+//Best of iterations, so the number is the op and not whatever else the machine was doing
+template<typename Op>
+static double bestNsPerOp(int count, int iterations, Op op) {
+	double best = 1e30;
+	for (int it = 0; it < iterations; it++)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < count; i++)
+		{
+			op(i);
+		}
+		best = fmin(best, elapsedNs(start) / count);
+	}
+	return best;
+}
+
+static std::vector<Result> results;
+
+//bytesPerOp is what one op reads and writes in the arrays, for the bandwidth column
+static void run(const char* name, int bytesPerOp, std::function<double()> measure) {
+	double nsPerOp = measure();
+	printf("%-28s %8.2f ns/op %9.1f Mop/s %7.2f GB/s\n", name, nsPerOp, 1e3 / nsPerOp, bytesPerOp / nsPerOp);
+	Result result;
+	result.name = name;
+	result.nsPerOp = nsPerOp;
+	result.measure = measure;
+	results.push_back(result);
+}
+
+static bool loadBaseline(const char* filePath, std::vector<Result>& baseline) {
+	FILE* f = fopen(filePath, "r");
+	if (f == NULL) {
+		printf("Failed to open baseline %s\n", filePath);
+		return false;
+	}
+	char line[256];
+	while (fgets(line, sizeof(line), f)) {
+		char name[128];
+		double ns;
+		if (line[0] == '#' || sscanf(line, "%lf %127[^\r\n]", &ns, name) != 2) {
+			continue;
+		}
+		Result result;
+		result.name = name;
+		result.nsPerOp = ns;
+		baseline.push_back(result);
+	}
+	fclose(f);
+	return true;
+}
+
+static bool saveBaseline(const char* filePath) {
+	FILE* f = fopen(filePath, "w");
+	if (f == NULL) {
+		printf("Failed to open %s for writing\n", filePath);
+		return false;
+	}
+	fprintf(f, "# ewmath_bench baseline (%s), ns/op name\n", ew::simd::BackendName());
+	for (const Result& result : results) {
+		fprintf(f, "%.4f %s\n", result.nsPerOp, result.name.c_str());
+	}
+	fclose(f);
+	printf("Saved baseline to %s\n", filePath);
+	return true;
+}
+
+//Number of ops slower than baseline * (1 + tolerance)
+static int compareBaseline(const std::vector<Result>& baseline, double tolerance) {
+	int regressions = 0;
+	printf("\nAgainst baseline, tolerance %.0f%%\n", tolerance * 100.0);
+	for (Result& result : results) {
+		const Result* base = nullptr;
+		for (const Result& b : baseline) {
+			if (b.name == result.name) {
+				base = &b;
+			}
+		}
+		if (base == nullptr) {
+			printf("  %-28s not in baseline\n", result.name.c_str());
+			continue;
+		}
+		for (int i = 0; i < RECHECKS && result.nsPerOp > base->nsPerOp * (1.0 + tolerance); i++) {
+			result.nsPerOp = fmin(result.nsPerOp, result.measure());
+		}
+		double change = result.nsPerOp / base->nsPerOp - 1.0;
+		bool regressed = change > tolerance;
+		regressions += regressed;
+		printf("  %-28s %8.2f -> %8.2f ns/op  %+6.1f%%%s\n", result.name.c_str(), base->nsPerOp, result.nsPerOp, change * 100.0, regressed ? "  REGRESSION" : "");
+	}
+	return regressions;
+}
+
+int main(int argc, char** argv) {
+	int count = 1000000;
+	int iterations = 7;
+	const char* baselinePath = nullptr;
+	const char* savePath = nullptr;
+	double tolerance = 0.15;
+	int positional = 0;
+	for (int i = 1; i < argc; i++)
+	{
+		bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "--baseline") == 0 && hasValue) {
+			baselinePath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--save-baseline") == 0 && hasValue) {
+			savePath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--tolerance") == 0 && hasValue) {
+			tolerance = atof(argv[++i]);
+		}
+		else if (argv[i][0] != '-' && positional < 2) {
+			(positional++ == 0 ? count : iterations) = atoi(argv[i]);
+		}
+		else {
+			printf("Usage: ewmath_bench [count] [iterations] [--baseline file] [--save-baseline file] [--tolerance fraction]\n");
+			return 2;
+		}
+	}
+	if (count <= 0 || iterations <= 0) {
+		printf("count and iterations must be positive\n");
+		return 2;
+	}
+	printf("ewMath backend: %s, %d elements, best of %d runs\n\n", ew::simd::BackendName(), count, iterations);
+
+	srand(1234);
+	std::vector<ew::Vec3> a3(count), b3(count), out3(count);
+	std::vector<ew::Vec4> a4(count), b4(count), out4(count);
+	std::vector<ew::Mat4> matA(count), matB(count), outMat(count);
+	std::vector<ew::Transform> transforms(count);
+	std::vector<float> scalars(count), outScalars(count);
+	for (int i = 0; i < count; i++)
+	{
+		a3[i] = ew::Vec3(ew::RandomRange(-10, 10), ew::RandomRange(-10, 10), ew::RandomRange(-10, 10));
+		b3[i] = ew::Vec3(ew::RandomRange(-10, 10), ew::RandomRange(-10, 10), ew::RandomRange(-10, 10));
+		a4[i] = ew::Vec4(a3[i], ew::RandomRange(-10, 10));
+		b4[i] = ew::Vec4(b3[i], 1.0f);
+		scalars[i] = ew::RandomRange(0.5f, 2.0f);
+		transforms[i].position = a3[i];
+		transforms[i].rotation = ew::Vec3(ew::RandomRange(-180, 180), ew::RandomRange(-180, 180), ew::RandomRange(-180, 180));
+		transforms[i].scale = ew::Vec3(ew::RandomRange(0.1f, 4), ew::RandomRange(0.1f, 4), ew::RandomRange(0.1f, 4));
+	}
+	for (int i = 0; i < count; i++)
+	{
+		matA[i] = transforms[i].getModelMatrix();
+		matB[i] = transforms[count - 1 - i].getModelMatrix();
+	}
+	const int v3 = sizeof(ew::Vec3), v4 = sizeof(ew::Vec4), m4 = sizeof(ew::Mat4), f = sizeof(float);
+
+	run("Vec3 + Vec3", v3 * 3, [&]() { return bestNsPerOp(count, iterations, [&](int i) { out3[i] = a3[i] + b3[i]; }); });
+	run("Vec3 * float", v3 * 2 + f, [&]() { return bestNsPerOp(count, iterations, [&](int i) { out3[i] = a3[i] * scalars[i]; }); });
+	run("Dot(Vec3)", v3 * 2 + f, [&]() { return bestNsPerOp(count, iterations, [&](int i) { outScalars[i] = ew::Dot(a3[i], b3[i]); }); });
+	run("Cross", v3 * 3, [&]() { return bestNsPerOp(count, iterations, [&](int i) { out3[i] = ew::Cross(a3[i], b3[i]); }); });
+	run("Normalize(Vec3)", v3 * 2, [&]() { return bestNsPerOp(count, iterations, [&](int i) { out3[i] = ew::Normalize(a3[i]); }); });
+	run("Vec4 + Vec4", v4 * 3, [&]() { return bestNsPerOp(count, iterations, [&](int i) { out4[i] = a4[i] + b4[i]; }); });
+	run("Vec4 * float", v4 * 2 + f, [&]() { return bestNsPerOp(count, iterations, [&](int i) { out4[i] = a4[i] * scalars[i]; }); });
+	run("Dot(Vec4)", v4 * 2 + f, [&]() { return bestNsPerOp(count, iterations, [&](int i) { outScalars[i] = ew::Dot(a4[i], b4[i]); }); });
+	run("Normalize(Vec4)", v4 * 2, [&]() { return bestNsPerOp(count, iterations, [&](int i) { out4[i] = ew::Normalize(a4[i]); }); });
+	run("Mat4 * Mat4", m4 * 3, [&]() { return bestNsPerOp(count, iterations, [&](int i) { outMat[i] = matA[i] * matB[i]; }); });
+	run("Mat4 * Vec4", m4 + v4 * 2, [&]() { return bestNsPerOp(count, iterations, [&](int i) { out4[i] = matA[i] * b4[i]; }); });
+	run("LookAt", v3 * 2 + m4, [&]() { return bestNsPerOp(count, iterations, [&](int i) { outMat[i] = ew::LookAt(a3[i], b3[i], ew::Vec3(0, 1, 0)); }); });
+	run("Perspective", f + m4, [&]() { return bestNsPerOp(count, iterations, [&](int i) { outMat[i] = ew::Perspective(scalars[i], 1.5f, 0.1f, 100.0f); }); });
+	run("Transform::getModelMatrix", (int)sizeof(ew::Transform) + m4, [&]() { return bestNsPerOp(count, iterations, [&](int i) { outMat[i] = transforms[i].getModelMatrix(); }); });
+
+	//Reading the outputs keeps the compiler from dropping the loops
+	double checksum = 0;
+	for (int i = 0; i < count; i++)
+	{
+		checksum += out3[i].x + out4[i].y + outMat[i][3][2] + outScalars[i];
+	}
+	printf("\nchecksum %g\n", checksum);
+
+	if (savePath != nullptr && !saveBaseline(savePath)) {
+		return 2;
+	}
+	if (baselinePath != nullptr) {
+		std::vector<Result> baseline;
+		if (!loadBaseline(baselinePath, baseline)) {
+			return 2;
+		}
+		int regressions = compareBaseline(baseline, tolerance);
+		if (regressions > 0) {
+			printf("%d op(s) regressed\n", regressions);
+			return 1;
+		}
+		printf("No regressions\n");
+	}
+	return 0;
+}
@@ -0,0 +1,143 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+
+#include <ew/ewMath/ewMath.h>
+#include <ew/ewMath/transformations.h>
+
+//Compares the selected ewMath SIMD backend against the scalar reference on batches of transforms.
+//Usage: mat4_bench [transformCount] [iterations]
+
+struct TransformInput {
+	ew::Vec3 position;
+	ew::Vec3 rotation; //Radians
+	ew::Vec3 scale;
+};
+
+static double elapsedMs(std::chrono::high_resolution_clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+static float maxDifference(const std::vector<ew::Mat4>& a, const std::vector<ew::Mat4>& b) {
+	float maxDiff = 0.0f;
+	for (size_t i = 0; i < a.size(); i++)
+	{
+		for (int c = 0; c < 4; c++)
+		{
+			for (int r = 0; r < 4; r++)
+			{
+				maxDiff = fmaxf(maxDiff, fabsf(a[i][c][r] - b[i][c][r]));
+			}
+		}
+	}
+	return maxDiff;
+}
+
+static void report(const char* name, double scalarMs, double simdMs, int count, float maxDiff) {
+	printf("%-24s scalar %8.2f ms (%6.2f ns/op)   %s %8.2f ms (%6.2f ns/op)   speedup %.2fx   max diff %g\n",
+		name, scalarMs, scalarMs * 1e6 / count, ew::simd::BackendName(), simdMs, simdMs * 1e6 / count, scalarMs / simdMs, maxDiff);
+}
+
+int main(int argc, char** argv) {
+	int count = argc > 1 ? atoi(argv[1]) : 1000000;
+	int iterations = argc > 2 ? atoi(argv[2]) : 5;
+	printf("ewMath backend: %s, %d transforms, best of %d runs\n", ew::simd::BackendName(), count, iterations);
+
+	srand(1234);
+	std::vector<TransformInput> inputs(count);
+	std::vector<ew::Mat4> viewProjections(count);
+	std::vector<ew::Vec4> points(count);
+	for (int i = 0; i < count; i++)
+	{
+		inputs[i].position = ew::Vec3(ew::RandomRange(-100, 100), ew::RandomRange(-100, 100), ew::RandomRange(-100, 100));
+		inputs[i].rotation = ew::Vec3(ew::RandomRange(-ew::PI, ew::PI), ew::RandomRange(-ew::PI, ew::PI), ew::RandomRange(-ew::PI, ew::PI));
+		inputs[i].scale = ew::Vec3(ew::RandomRange(0.1f, 4), ew::RandomRange(0.1f, 4), ew::RandomRange(0.1f, 4));
+		points[i] = ew::Vec4(ew::RandomRange(-1, 1), ew::RandomRange(-1, 1), ew::RandomRange(-1, 1), 1.0f);
+	}
+
+	//Rotation/scale matrices are built once so the timings only measure the multiplies
+	std::vector<ew::Mat4> translate(count), rotateY(count), rotateX(count), rotateZ(count), scale(count);
+	for (int i = 0; i < count; i++)
+	{
+		translate[i] = ew::Translate(inputs[i].position);
+		rotateY[i] = ew::RotateY(inputs[i].rotation.y);
+		rotateX[i] = ew::RotateX(inputs[i].rotation.x);
+		rotateZ[i] = ew::RotateZ(inputs[i].rotation.z);
+		scale[i] = ew::Scale(inputs[i].scale);
+	}
+	ew::Mat4 viewProjection = ew::Perspective(ew::Radians(60.0f), 1.5f, 0.1f, 100.0f) * ew::LookAt(ew::Vec3(0, 0, 5), ew::Vec3(0), ew::Vec3(0, 1, 0));
+
+	std::vector<ew::Mat4> scalarModels(count), simdModels(count);
+	std::vector<ew::Vec4> scalarPoints(count), simdPoints(count);
+	double scalarMs = 1e30, simdMs = 1e30;
+
+	//Translate * RotateY * RotateX * RotateZ * Scale, as in ew::Transform::getModelMatrix
+	for (int it = 0; it < iterations; it++)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < count; i++)
+		{
+			scalarModels[i] = ew::MulScalar(ew::MulScalar(ew::MulScalar(ew::MulScalar(translate[i], rotateY[i]), rotateX[i]), rotateZ[i]), scale[i]);
+		}
+		scalarMs = fmin(scalarMs, elapsedMs(start));
+
+		start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < count; i++)
+		{
+			simdModels[i] = translate[i] * rotateY[i] * rotateX[i] * rotateZ[i] * scale[i];
+		}
+		simdMs = fmin(simdMs, elapsedMs(start));
+	}
+	report("Model matrix (4 muls)", scalarMs, simdMs, count, maxDifference(scalarModels, simdModels));
+
+	//ViewProjection * Model
+	scalarMs = simdMs = 1e30;
+	for (int it = 0; it < iterations; it++)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < count; i++)
+		{
+			viewProjections[i] = ew::MulScalar(viewProjection, scalarModels[i]);
+		}
+		scalarMs = fmin(scalarMs, elapsedMs(start));
+
+		start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < count; i++)
+		{
+			simdModels[i] = viewProjection * scalarModels[i];
+		}
+		simdMs = fmin(simdMs, elapsedMs(start));
+	}
+	report("Mat4 * Mat4", scalarMs, simdMs, count, maxDifference(viewProjections, simdModels));
+
+	//Model * point
+	scalarMs = simdMs = 1e30;
+	for (int it = 0; it < iterations; it++)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < count; i++)
+		{
+			scalarPoints[i] = ew::MulScalar(scalarModels[i], points[i]);
+		}
+		scalarMs = fmin(scalarMs, elapsedMs(start));
+
+		start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < count; i++)
+		{
+			simdPoints[i] = scalarModels[i] * points[i];
+		}
+		simdMs = fmin(simdMs, elapsedMs(start));
+	}
+	float pointDiff = 0.0f;
+	for (int i = 0; i < count; i++)
+	{
+		for (int c = 0; c < 4; c++)
+		{
+			pointDiff = fmaxf(pointDiff, fabsf(scalarPoints[i][c] - simdPoints[i][c]));
+		}
+	}
+	report("Mat4 * Vec4", scalarMs, simdMs, count, pointDiff);
+	return 0;
+}
@@ -0,0 +1,53 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+
+#include <ew/procGen.h>
+#include <ew/meshOptimizer.h>
+#include <qm/procGen.h>
+
+//Prints post transform cache statistics for every generator in ew/procGen.cpp and qm/procGen.h,
+//as generated and after each optimizer stage.
+//Usage: mesh_optimizer_stats [cacheSize]
+
+static int cacheSize = 32;
+
+static void report(const char* name, const ew::MeshData& source) {
+	ew::MeshData mesh = source;
+	ew::VertexCacheStats before = ew::AnalyzeVertexCache(mesh, cacheSize);
+
+	auto start = std::chrono::high_resolution_clock::now();
+	ew::OptimizeVertexCache(mesh, cacheSize);
+	ew::VertexCacheStats cache = ew::AnalyzeVertexCache(mesh, cacheSize);
+	int clusters = ew::OptimizeOverdraw(mesh, 1.05f, cacheSize);
+	ew::VertexCacheStats overdraw = ew::AnalyzeVertexCache(mesh, cacheSize);
+	ew::OptimizeVertexFetch(mesh);
+	ew::VertexCacheStats fetch = ew::AnalyzeVertexCache(mesh, cacheSize);
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	int triangles = mesh.topology == ew::Topology::TRIANGLES ? (int)mesh.indices.size() / 3 : (int)(before.transformed / before.acmr + 0.5f);
+	printf("%-26s %8d tris | ACMR %.3f -> %.3f -> %.3f (%5d clusters) | ATVR %.3f -> %.3f | overfetch %.2f -> %.2f | %8.2f ms\n",
+		name, triangles, before.acmr, cache.acmr, overdraw.acmr, clusters, before.atvr, fetch.atvr, before.overfetch, fetch.overfetch, ms);
+}
+
+int main(int argc, char** argv) {
+	cacheSize = argc > 1 ? atoi(argv[1]) : 32;
+	printf("FIFO cache of %d vertices. ACMR: original -> vertex cache -> overdraw sort (clusters sorted, 0 if kept). ATVR/overfetch: original -> final\n\n", cacheSize);
+	report("ew::createCube", ew::createCube(1.0f));
+	report("ew::createPlane 10", ew::createPlane(8, 8, 10));
+	report("ew::createPlane 256", ew::createPlane(8, 8, 256));
+	report("ew::createSphere 32", ew::createSphere(0.125f, 32));
+	report("ew::createSphere 64", ew::createSphere(0.5f, 64));
+	report("ew::createSphere 256", ew::createSphere(1.0f, 256));
+	report("ew::createCylinder 32", ew::createCylinder(0.5f, 1.0f, 32));
+	report("ew::createCylinder 256", ew::createCylinder(0.5f, 1.0f, 256));
+	report("qm::createSphere 64", qm::createSphere(0.5f, 64));
+	report("qm::createSphere 256", qm::createSphere(1.0f, 256));
+	report("qm::createCylinder 64", qm::createCylinder(1.0f, 0.5f, 64));
+	report("qm::createPlane 256", qm::createPlane(8.0f, 256));
+	report("qm::createVertPlane 256", qm::createVertPlane(8.0f, 256));
+	//Strips are not reordered, only renumbered for fetch
+	report("ew::createPlane 256 strip", ew::createPlane(8, 8, 256, nullptr, ew::Topology::TRIANGLE_STRIP));
+	report("qm::createPlane 256 strip", qm::createPlane(8.0f, 256, ew::Topology::TRIANGLE_STRIP));
+	return 0;
+}
@@ -0,0 +1,145 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+
+#include <ew/procGen.h>
+#include <ew/threadPool.h>
+
+//Times ew::createPlane and ew::createSphere from 64 to 4096 subdivisions:
+//the original push_back generators, the presized/table driven ones, and the same on a thread pool.
+//Usage: procgen_bench [maxSubdivisions] [threads]
+
+static double elapsedMs(std::chrono::high_resolution_clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+//Generators as they were before presizing, kept as the baseline
+static ew::MeshData legacyCreatePlane(float width, float height, int subdivisions) {
+	ew::MeshData mesh;
+	int columns = subdivisions + 1;
+	for (size_t row = 0; row <= subdivisions; row++)
+	{
+		for (size_t col = 0; col <= subdivisions; col++)
+		{
+			ew::Vertex v;
+			v.uv.x = ((float)col / subdivisions);
+			v.uv.y = ((float)row / subdivisions);
+			v.pos.x = -width / 2 + width * v.uv.x;
+			v.pos.y = 0;
+			v.pos.z = height / 2 - height * v.uv.y;
+			v.normal = ew::Vec3(0, 1, 0);
+			mesh.vertices.push_back(v);
+		}
+	}
+	for (size_t row = 0; row < subdivisions; row++)
+	{
+		for (size_t col = 0; col < subdivisions; col++)
+		{
+			int start = row * columns + col;
+			mesh.indices.push_back(start);
+			mesh.indices.push_back(start + 1);
+			mesh.indices.push_back(start + columns + 1);
+			mesh.indices.push_back(start + columns + 1);
+			mesh.indices.push_back(start + columns);
+			mesh.indices.push_back(start);
+		}
+	}
+	return mesh;
+}
+
+static ew::MeshData legacyCreateSphere(float radius, int subdivisions) {
+	ew::MeshData mesh;
+	float thetaStep = ew::TAU / subdivisions;
+	float phiStep = ew::PI / subdivisions;
+	for (size_t row = 0; row <= subdivisions; row++)
+	{
+		float phi = row * phiStep;
+		for (size_t col = 0; col <= subdivisions; col++)
+		{
+			float theta = thetaStep * col;
+			ew::Vertex v;
+			v.normal.x = cosf(theta) * sinf(phi);
+			v.normal.y = cosf(phi);
+			v.normal.z = sinf(theta) * sinf(phi);
+			v.pos = v.normal * radius;
+			v.uv.x = (float)col / subdivisions;
+			v.uv.y = 1.0 - ((float)row / subdivisions);
+			mesh.vertices.push_back(v);
+		}
+	}
+	unsigned int columns = subdivisions + 1;
+	unsigned int sideStart = columns;
+	unsigned int poleStart = 0;
+	for (size_t i = 0; i < subdivisions; i++)
+	{
+		mesh.indices.push_back(sideStart + i);
+		mesh.indices.push_back(poleStart + i);
+		mesh.indices.push_back(sideStart + i + 1);
+	}
+	for (size_t row = 1; row < subdivisions - 1; row++)
+	{
+		for (size_t col = 0; col < subdivisions; col++)
+		{
+			int start = row * columns + col;
+			mesh.indices.push_back(start);
+			mesh.indices.push_back(start + 1);
+			mesh.indices.push_back(start + columns);
+			mesh.indices.push_back(start + columns);
+			mesh.indices.push_back(start + 1);
+			mesh.indices.push_back(start + columns + 1);
+		}
+	}
+	poleStart = (columns * columns) - columns;
+	sideStart = poleStart - columns;
+	for (size_t i = 0; i < subdivisions; i++)
+	{
+		mesh.indices.push_back(sideStart + i);
+		mesh.indices.push_back(sideStart + i + 1);
+		mesh.indices.push_back(poleStart + i);
+	}
+	return mesh;
+}
+
+static bool sameMesh(const ew::MeshData& a, const ew::MeshData& b) {
+	return a.vertices.size() == b.vertices.size() && a.indices.size() == b.indices.size()
+		&& memcmp(a.vertices.data(), b.vertices.data(), sizeof(ew::Vertex) * a.vertices.size()) == 0
+		&& memcmp(a.indices.data(), b.indices.data(), sizeof(unsigned int) * a.indices.size()) == 0;
+}
+
+int main(int argc, char** argv) {
+	int maxSubdivisions = argc > 1 ? atoi(argv[1]) : 4096;
+	int threads = argc > 2 ? atoi(argv[2]) : -1;
+	ew::ThreadPool pool(threads);
+	printf("%d worker threads (+ calling thread)\n", pool.getNumWorkers());
+	printf("%-7s %6s %12s %12s %12s %12s %10s %10s %s\n", "mesh", "subdiv", "vertices", "legacy ms", "presized ms", "pooled ms", "speedup", "pooled", "output");
+
+	for (int subdivisions = 64; subdivisions <= maxSubdivisions; subdivisions *= 2)
+	{
+		for (int shape = 0; shape < 2; shape++)
+		{
+			const char* name = shape == 0 ? "plane" : "sphere";
+			double legacyMs, presizedMs, pooledMs;
+			bool identical;
+			size_t vertices;
+			{
+				auto start = std::chrono::high_resolution_clock::now();
+				ew::MeshData legacy = shape == 0 ? legacyCreatePlane(8, 8, subdivisions) : legacyCreateSphere(1, subdivisions);
+				legacyMs = elapsedMs(start);
+				start = std::chrono::high_resolution_clock::now();
+				ew::MeshData presized = shape == 0 ? ew::createPlane(8, 8, subdivisions) : ew::createSphere(1, subdivisions);
+				presizedMs = elapsedMs(start);
+				identical = sameMesh(legacy, presized);
+				vertices = presized.vertices.size();
+			}
+			auto start = std::chrono::high_resolution_clock::now();
+			ew::MeshData pooled = shape == 0 ? ew::createPlane(8, 8, subdivisions, &pool) : ew::createSphere(1, subdivisions, &pool);
+			pooledMs = elapsedMs(start);
+			printf("%-7s %6d %12zu %12.2f %12.2f %12.2f %9.2fx %9.2fx %s\n", name, subdivisions, vertices,
+				legacyMs, presizedMs, pooledMs, legacyMs / presizedMs, legacyMs / pooledMs, identical ? "identical" : "DIFFERENT");
+		}
+	}
+	return 0;
+}
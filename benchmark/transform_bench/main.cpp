@@ -0,0 +1,89 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+
+#include <ew/transform.h>
+#include <ew/transformSystem.h>
+
+//Compares ew::TransformSystem::update against calling ew::Transform::getModelMatrix per object,
+//with every transform moving and with only a fraction of them moving each frame.
+//Usage: transform_bench [transformCount] [iterations]
+
+static double elapsedMs(std::chrono::high_resolution_clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+static float maxDifference(const std::vector<ew::Mat4>& perObject, const ew::TransformSystem& system) {
+	float maxDiff = 0.0f;
+	for (size_t i = 0; i < perObject.size(); i++)
+	{
+		const ew::Mat4& m = system.getModelMatrix((int)i);
+		for (int c = 0; c < 4; c++)
+		{
+			for (int r = 0; r < 4; r++)
+			{
+				maxDiff = fmaxf(maxDiff, fabsf(perObject[i][c][r] - m[c][r]));
+			}
+		}
+	}
+	return maxDiff;
+}
+
+static void report(const char* name, double perObjectMs, double systemMs, int count, float maxDiff) {
+	printf("%-28s per-object %8.2f ms (%6.2f ns/transform)   TransformSystem %8.2f ms (%6.2f ns/transform)   speedup %.2fx   max diff %g\n",
+		name, perObjectMs, perObjectMs * 1e6 / count, systemMs, systemMs * 1e6 / count, perObjectMs / systemMs, maxDiff);
+}
+
+int main(int argc, char** argv) {
+	int count = argc > 1 ? atoi(argv[1]) : 100000;
+	int iterations = argc > 2 ? atoi(argv[2]) : 10;
+	printf("ewMath backend: %s, %d transforms, best of %d runs\n", ew::simd::BackendName(), count, iterations);
+
+	srand(1234);
+	std::vector<ew::Transform> transforms(count);
+	ew::TransformSystem system;
+	for (int i = 0; i < count; i++)
+	{
+		transforms[i].position = ew::Vec3(ew::RandomRange(-100, 100), ew::RandomRange(-100, 100), ew::RandomRange(-100, 100));
+		transforms[i].rotation = ew::Vec3(ew::RandomRange(-180, 180), ew::RandomRange(-180, 180), ew::RandomRange(-180, 180));
+		transforms[i].scale = ew::Vec3(ew::RandomRange(0.1f, 4), ew::RandomRange(0.1f, 4), ew::RandomRange(0.1f, 4));
+		system.add(transforms[i]);
+	}
+	std::vector<ew::Mat4> models(count);
+
+	//Each frame moves every moveEvery-th transform, then rebuilds matrices. The per-object path
+	//rebuilds everything, as the demo's draw loops do; TransformSystem only rebuilds dirty blocks.
+	const int moveEveryCases[] = { 1, 10, 100 };
+	const char* caseNames[] = { "All moving", "1 in 10 moving", "1 in 100 moving" };
+	for (int c = 0; c < 3; c++)
+	{
+		int moveEvery = moveEveryCases[c];
+		double perObjectMs = 1e30, systemMs = 1e30;
+		for (int it = 0; it < iterations; it++)
+		{
+			float offset = (float)(it + 1);
+			auto start = std::chrono::high_resolution_clock::now();
+			for (int i = 0; i < count; i += moveEvery)
+			{
+				transforms[i].rotation.y = offset * 3.0f + i;
+			}
+			for (int i = 0; i < count; i++)
+			{
+				models[i] = transforms[i].getModelMatrix();
+			}
+			perObjectMs = fmin(perObjectMs, elapsedMs(start));
+
+			start = std::chrono::high_resolution_clock::now();
+			for (int i = 0; i < count; i += moveEvery)
+			{
+				system.setRotation(i, transforms[i].rotation);
+			}
+			system.update();
+			systemMs = fmin(systemMs, elapsedMs(start));
+		}
+		report(caseNames[c], perObjectMs, systemMs, count, maxDifference(models, system));
+	}
+	return 0;
+}
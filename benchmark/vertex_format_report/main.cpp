@@ -0,0 +1,45 @@
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+
+#include <ew/procGen.h>
+#include <ew/vertexFormat.h>
+
+//Encodes generated meshes as ew::CompactVertex, decodes them again and reports the error against the float data.
+
+static void report(const char* name, const ew::MeshData& mesh) {
+	double positionSquared = 0, normalAngleSum = 0;
+	float positionMax = 0, normalAngleMax = 0, uvMax = 0;
+	for (size_t i = 0; i < mesh.vertices.size(); i++)
+	{
+		const ew::Vertex& reference = mesh.vertices[i];
+		ew::Vertex decoded = ew::DecodeVertex(ew::EncodeVertex(reference));
+		float positionError = ew::Magnitude(decoded.pos - reference.pos);
+		positionMax = fmaxf(positionMax, positionError);
+		positionSquared += positionError * positionError;
+		float cosAngle = ew::Dot(decoded.normal, ew::Normalize(reference.normal));
+		float angle = acosf(fminf(fmaxf(cosAngle, -1.0f), 1.0f)) * ew::RAD2DEG;
+		normalAngleMax = fmaxf(normalAngleMax, angle);
+		normalAngleSum += angle;
+		uvMax = fmaxf(uvMax, fmaxf(fabsf(decoded.uv.x - reference.uv.x), fabsf(decoded.uv.y - reference.uv.y)));
+	}
+	int count = (int)mesh.vertices.size();
+	printf("%-22s %9d %6.2f MB -> %6.2f MB   pos max %.2e rms %.2e (%.4f%% of radius)   normal max %.4f deg mean %.4f deg   uv max %.2e\n",
+		name, count, count * sizeof(ew::Vertex) / 1048576.0, count * sizeof(ew::CompactVertex) / 1048576.0,
+		positionMax, sqrt(positionSquared / count), 100.0f * positionMax / mesh.bounds.radius,
+		normalAngleMax, normalAngleSum / count, uvMax);
+}
+
+int main() {
+	printf("ew::Vertex %d bytes, ew::CompactVertex %d bytes\n\n", (int)sizeof(ew::Vertex), (int)sizeof(ew::CompactVertex));
+	report("sphere r0.125 x32", ew::createSphere(0.125f, 32));
+	report("sphere r0.5 x64", ew::createSphere(0.5f, 64));
+	report("sphere r1 x512", ew::createSphere(1.0f, 512));
+	report("sphere r10 x1024", ew::createSphere(10.0f, 1024));
+	report("plane 8x8 x10", ew::createPlane(8, 8, 10));
+	report("plane 8x8 x1024", ew::createPlane(8, 8, 1024));
+	report("plane 200x200 x1024", ew::createPlane(200, 200, 1024));
+	report("cylinder r0.5 x32", ew::createCylinder(0.5f, 1.0f, 32));
+	report("cube 0.5", ew::createCube(0.5f));
+	return 0;
+}
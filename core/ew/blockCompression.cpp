@@ -0,0 +1,336 @@
+#include "blockCompression.h"
+#include <string.h>
+#include <math.h>
+
+namespace ew {
+	namespace {
+		inline int clampByte(float v) {
+			return v <= 0.0f ? 0 : (v >= 255.0f ? 255 : (int)(v + 0.5f));
+		}
+		inline unsigned short packColor565(const float* color) {
+			int r = (clampByte(color[0]) * 31 + 127) / 255;
+			int g = (clampByte(color[1]) * 63 + 127) / 255;
+			int b = (clampByte(color[2]) * 31 + 127) / 255;
+			return (unsigned short)((r << 11) | (g << 5) | b);
+		}
+		inline void unpackColor565(unsigned short c, int* color) {
+			int r = (c >> 11) & 31;
+			int g = (c >> 5) & 63;
+			int b = c & 31;
+			color[0] = (r << 3) | (r >> 2);
+			color[1] = (g << 2) | (g >> 4);
+			color[2] = (b << 3) | (b >> 2);
+		}
+		//Four color palette of a BC1 block. threeColor is the c0 <= c1 mode, where index 3 is transparent black.
+		void colorPalette(unsigned short c0, unsigned short c1, bool threeColor, int palette[4][4]) {
+			unpackColor565(c0, palette[0]);
+			unpackColor565(c1, palette[1]);
+			palette[0][3] = palette[1][3] = 255;
+			for (int i = 0; i < 3; i++) {
+				if (threeColor) {
+					palette[2][i] = (palette[0][i] + palette[1][i]) / 2;
+					palette[3][i] = 0;
+				}
+				else {
+					palette[2][i] = (2 * palette[0][i] + palette[1][i]) / 3;
+					palette[3][i] = (palette[0][i] + 2 * palette[1][i]) / 3;
+				}
+			}
+			palette[2][3] = 255;
+			palette[3][3] = threeColor ? 0 : 255;
+		}
+		//Picks the nearest of the four colors for each pixel. Returns the packed indices and the total squared error.
+		unsigned int colorIndices(const unsigned char* rgba, unsigned short c0, unsigned short c1, int* error) {
+			int palette[4][4];
+			colorPalette(c0, c1, false, palette);
+			unsigned int indices = 0;
+			*error = 0;
+			for (int i = 0; i < 16; i++) {
+				const unsigned char* p = rgba + i * 4;
+				int best = 0;
+				int bestDistance = 0x7FFFFFFF;
+				for (int j = 0; j < 4; j++) {
+					int dr = p[0] - palette[j][0];
+					int dg = p[1] - palette[j][1];
+					int db = p[2] - palette[j][2];
+					int distance = dr * dr + dg * dg + db * db;
+					if (distance < bestDistance) {
+						bestDistance = distance;
+						best = j;
+					}
+				}
+				indices |= best << (i * 2);
+				*error += bestDistance;
+			}
+			return indices;
+		}
+		//Order the endpoints so the block decodes in four color mode
+		unsigned int orderEndpoints(unsigned short& c0, unsigned short& c1, unsigned int indices) {
+			if (c0 >= c1) {
+				return indices;
+			}
+			unsigned short t = c0;
+			c0 = c1;
+			c1 = t;
+			//Swapping endpoints maps index 0<->1 and 2<->3
+			return indices ^ 0x55555555;
+		}
+		//Least squares fit of both endpoints to the pixels, given which palette entry each one uses
+		bool refitEndpoints(const unsigned char* rgba, unsigned int indices, float* start, float* end) {
+			const float weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+			float aa = 0, bb = 0, ab = 0;
+			float ax[3] = {}, bx[3] = {};
+			for (int i = 0; i < 16; i++) {
+				float a = weights[(indices >> (i * 2)) & 3];
+				float b = 1.0f - a;
+				aa += a * a;
+				bb += b * b;
+				ab += a * b;
+				for (int c = 0; c < 3; c++) {
+					ax[c] += a * rgba[i * 4 + c];
+					bx[c] += b * rgba[i * 4 + c];
+				}
+			}
+			float determinant = aa * bb - ab * ab;
+			if (fabsf(determinant) < 1e-6f) {
+				return false;
+			}
+			for (int c = 0; c < 3; c++) {
+				start[c] = (ax[c] * bb - bx[c] * ab) / determinant;
+				end[c] = (bx[c] * aa - ax[c] * ab) / determinant;
+			}
+			return true;
+		}
+		//Endpoints from the extremes along the principal axis, then one least squares refinement
+		void encodeColor(const unsigned char* rgba, unsigned char* block) {
+			float mean[3] = {};
+			for (int i = 0; i < 16; i++) {
+				for (int c = 0; c < 3; c++) {
+					mean[c] += rgba[i * 4 + c];
+				}
+			}
+			for (int c = 0; c < 3; c++) {
+				mean[c] /= 16.0f;
+			}
+			float covariance[6] = {}; //rr rg rb gg gb bb
+			for (int i = 0; i < 16; i++) {
+				float r = rgba[i * 4 + 0] - mean[0];
+				float g = rgba[i * 4 + 1] - mean[1];
+				float b = rgba[i * 4 + 2] - mean[2];
+				covariance[0] += r * r;
+				covariance[1] += r * g;
+				covariance[2] += r * b;
+				covariance[3] += g * g;
+				covariance[4] += g * b;
+				covariance[5] += b * b;
+			}
+			//Power iteration converges on the principal axis in a handful of steps
+			float axis[3] = { 1.0f, 1.0f, 1.0f };
+			for (int iteration = 0; iteration < 4; iteration++) {
+				float x = covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2];
+				float y = covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2];
+				float z = covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2];
+				float length = fmaxf(fabsf(x), fmaxf(fabsf(y), fabsf(z)));
+				if (length < 1e-6f) {
+					break;
+				}
+				axis[0] = x / length;
+				axis[1] = y / length;
+				axis[2] = z / length;
+			}
+			float axisLengthSquared = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+			float minT = 0, maxT = 0;
+			for (int i = 0; i < 16; i++) {
+				float t = (rgba[i * 4 + 0] - mean[0]) * axis[0] + (rgba[i * 4 + 1] - mean[1]) * axis[1] + (rgba[i * 4 + 2] - mean[2]) * axis[2];
+				minT = t < minT ? t : minT;
+				maxT = t > maxT ? t : maxT;
+			}
+			float start[3], end[3];
+			for (int c = 0; c < 3; c++) {
+				start[c] = mean[c] + axis[c] * maxT / axisLengthSquared;
+				end[c] = mean[c] + axis[c] * minT / axisLengthSquared;
+			}
+			unsigned short c0 = packColor565(start);
+			unsigned short c1 = packColor565(end);
+			int error;
+			unsigned int indices = colorIndices(rgba, c0, c1, &error);
+
+			if (error > 0 && refitEndpoints(rgba, indices, start, end)) {
+				unsigned short r0 = packColor565(start);
+				unsigned short r1 = packColor565(end);
+				int refitError;
+				unsigned int refitIndices = colorIndices(rgba, r0, r1, &refitError);
+				if (refitError < error) {
+					c0 = r0;
+					c1 = r1;
+					indices = refitIndices;
+				}
+			}
+			if (c0 == c1) {
+				//Equal endpoints decode in three color mode, where index 0 is still c0
+				indices = 0;
+			}
+			indices = orderEndpoints(c0, c1, indices);
+			block[0] = c0 & 0xFF;
+			block[1] = c0 >> 8;
+			block[2] = c1 & 0xFF;
+			block[3] = c1 >> 8;
+			for (int i = 0; i < 4; i++) {
+				block[4 + i] = (indices >> (i * 8)) & 0xFF;
+			}
+		}
+		void decodeColor(const unsigned char* block, bool allowThreeColor, unsigned char* rgba) {
+			unsigned short c0 = block[0] | (block[1] << 8);
+			unsigned short c1 = block[2] | (block[3] << 8);
+			unsigned int indices = block[4] | (block[5] << 8) | (block[6] << 16) | ((unsigned int)block[7] << 24);
+			int palette[4][4];
+			colorPalette(c0, c1, allowThreeColor && c0 <= c1, palette);
+			for (int i = 0; i < 16; i++) {
+				const int* color = palette[(indices >> (i * 2)) & 3];
+				for (int c = 0; c < 4; c++) {
+					rgba[i * 4 + c] = (unsigned char)color[c];
+				}
+			}
+		}
+		void alphaPalette(int a0, int a1, int palette[8]) {
+			palette[0] = a0;
+			palette[1] = a1;
+			if (a0 > a1) {
+				for (int i = 2; i < 8; i++) {
+					palette[i] = ((8 - i) * a0 + (i - 1) * a1) / 7;
+				}
+			}
+			else {
+				for (int i = 2; i < 6; i++) {
+					palette[i] = ((6 - i) * a0 + (i - 1) * a1) / 5;
+				}
+				palette[6] = 0;
+				palette[7] = 255;
+			}
+		}
+		//Always the eight value mode, spanning the block's alpha range
+		void encodeAlpha(const unsigned char* rgba, unsigned char* block) {
+			int minA = 255, maxA = 0;
+			for (int i = 0; i < 16; i++) {
+				int a = rgba[i * 4 + 3];
+				minA = a < minA ? a : minA;
+				maxA = a > maxA ? a : maxA;
+			}
+			block[0] = (unsigned char)maxA;
+			block[1] = (unsigned char)minA;
+			unsigned long long indices = 0;
+			if (maxA > minA) {
+				int palette[8];
+				alphaPalette(maxA, minA, palette);
+				for (int i = 0; i < 16; i++) {
+					int a = rgba[i * 4 + 3];
+					int best = 0;
+					int bestDistance = 256;
+					for (int j = 0; j < 8; j++) {
+						int distance = a > palette[j] ? a - palette[j] : palette[j] - a;
+						if (distance < bestDistance) {
+							bestDistance = distance;
+							best = j;
+						}
+					}
+					indices |= (unsigned long long)best << (i * 3);
+				}
+			}
+			for (int i = 0; i < 6; i++) {
+				block[2 + i] = (indices >> (i * 8)) & 0xFF;
+			}
+		}
+		void decodeAlpha(const unsigned char* block, unsigned char* rgba) {
+			int palette[8];
+			alphaPalette(block[0], block[1], palette);
+			unsigned long long indices = 0;
+			for (int i = 0; i < 6; i++) {
+				indices |= (unsigned long long)block[2 + i] << (i * 8);
+			}
+			for (int i = 0; i < 16; i++) {
+				rgba[i * 4 + 3] = (unsigned char)palette[(indices >> (i * 3)) & 7];
+			}
+		}
+		//Copies the 4x4 block at (x, y), clamping reads at the image edges
+		void readBlock(const unsigned char* rgba, int width, int height, int x, int y, unsigned char* block) {
+			for (int row = 0; row < 4; row++) {
+				int sy = y + row < height ? y + row : height - 1;
+				for (int col = 0; col < 4; col++) {
+					int sx = x + col < width ? x + col : width - 1;
+					memcpy(block + (row * 4 + col) * 4, rgba + ((size_t)sy * width + sx) * 4, 4);
+				}
+			}
+		}
+		void writeBlock(const unsigned char* block, int width, int height, int x, int y, unsigned char* rgba) {
+			for (int row = 0; row < 4 && y + row < height; row++) {
+				for (int col = 0; col < 4 && x + col < width; col++) {
+					memcpy(rgba + ((size_t)(y + row) * width + x + col) * 4, block + (row * 4 + col) * 4, 4);
+				}
+			}
+		}
+	}
+
+	void EncodeBC1Block(const unsigned char* rgba, unsigned char* block)
+	{
+		encodeColor(rgba, block);
+	}
+	void EncodeBC3Block(const unsigned char* rgba, unsigned char* block)
+	{
+		encodeAlpha(rgba, block);
+		encodeColor(rgba, block + 8);
+	}
+	void DecodeBC1Block(const unsigned char* block, unsigned char* rgba)
+	{
+		decodeColor(block, true, rgba);
+	}
+	void DecodeBC3Block(const unsigned char* block, unsigned char* rgba)
+	{
+		//BC3 color blocks are always four color
+		decodeColor(block + 8, false, rgba);
+		decodeAlpha(block, rgba);
+	}
+	void EncodeBC1(const unsigned char* rgba, int width, int height, unsigned char* blocks)
+	{
+		unsigned char pixels[64];
+		for (int y = 0; y < height; y += 4) {
+			for (int x = 0; x < width; x += 4) {
+				readBlock(rgba, width, height, x, y, pixels);
+				EncodeBC1Block(pixels, blocks);
+				blocks += BC1_BLOCK_BYTES;
+			}
+		}
+	}
+	void EncodeBC3(const unsigned char* rgba, int width, int height, unsigned char* blocks)
+	{
+		unsigned char pixels[64];
+		for (int y = 0; y < height; y += 4) {
+			for (int x = 0; x < width; x += 4) {
+				readBlock(rgba, width, height, x, y, pixels);
+				EncodeBC3Block(pixels, blocks);
+				blocks += BC3_BLOCK_BYTES;
+			}
+		}
+	}
+	void DecodeBC1(const unsigned char* blocks, int width, int height, unsigned char* rgba)
+	{
+		unsigned char pixels[64];
+		for (int y = 0; y < height; y += 4) {
+			for (int x = 0; x < width; x += 4) {
+				DecodeBC1Block(blocks, pixels);
+				writeBlock(pixels, width, height, x, y, rgba);
+				blocks += BC1_BLOCK_BYTES;
+			}
+		}
+	}
+	void DecodeBC3(const unsigned char* blocks, int width, int height, unsigned char* rgba)
+	{
+		unsigned char pixels[64];
+		for (int y = 0; y < height; y += 4) {
+			for (int x = 0; x < width; x += 4) {
+				DecodeBC3Block(blocks, pixels);
+				writeBlock(pixels, width, height, x, y, rgba);
+				blocks += BC3_BLOCK_BYTES;
+			}
+		}
+	}
+}
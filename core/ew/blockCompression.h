@@ -0,0 +1,18 @@
+#pragma once
+
+namespace ew {
+	constexpr int BC1_BLOCK_BYTES = 8;
+	constexpr int BC3_BLOCK_BYTES = 16;
+
+	//Blocks are 4x4 RGBA8 pixels, row major (64 bytes)
+	void EncodeBC1Block(const unsigned char* rgba, unsigned char* block);
+	void EncodeBC3Block(const unsigned char* rgba, unsigned char* block);
+	void DecodeBC1Block(const unsigned char* block, unsigned char* rgba);
+	void DecodeBC3Block(const unsigned char* block, unsigned char* rgba);
+
+	//Whole images. Edge blocks of sizes that aren't a multiple of 4 repeat the last row/column.
+	void EncodeBC1(const unsigned char* rgba, int width, int height, unsigned char* blocks);
+	void EncodeBC3(const unsigned char* rgba, int width, int height, unsigned char* blocks);
+	void DecodeBC1(const unsigned char* blocks, int width, int height, unsigned char* rgba);
+	void DecodeBC3(const unsigned char* blocks, int width, int height, unsigned char* rgba);
+}
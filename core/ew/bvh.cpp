@@ -0,0 +1,417 @@
+#include "bvh.h"
+#include <utility>
+
+namespace ew {
+	static const int BVH_BINS = 16; //SAH candidate splits per axis
+	static const int BVH_MAX_LEAF_OBJECTS = 4;
+	static const int BVH_MAX_DEPTH = 100; //Deeper nodes stay leaves, so traversal stacks can be fixed size
+	static const int BVH_STACK_SIZE = BVH_MAX_DEPTH + 2;
+
+	//fminf/fmaxf handle NaN and may not inline, these compile to single min/max instructions
+	static inline float minf(float a, float b) { return a < b ? a : b; }
+	static inline float maxf(float a, float b) { return a > b ? a : b; }
+
+	static inline void grow(AABB& box, const AABB& other) {
+		box.min = ew::Vec3(minf(box.min.x, other.min.x), minf(box.min.y, other.min.y), minf(box.min.z, other.min.z));
+		box.max = ew::Vec3(maxf(box.max.x, other.max.x), maxf(box.max.y, other.max.y), maxf(box.max.z, other.max.z));
+	}
+	static inline AABB emptyBox() {
+		AABB box;
+		box.min = ew::Vec3(1e30f);
+		box.max = ew::Vec3(-1e30f);
+		return box;
+	}
+	static inline float surfaceArea(const AABB& box) {
+		ew::Vec3 e = box.max - box.min;
+		if (e.x < 0) {
+			return 0;
+		}
+		return e.x * e.y + e.y * e.z + e.z * e.x;
+	}
+	//-1 outside, 0 intersecting, 1 fully inside
+	static inline int classify(const Frustum& frustum, const AABB& box) {
+		int result = 1;
+		for (int i = 0; i < 6; i++)
+		{
+			const ew::Vec3& n = frustum.planes[i].normal;
+			ew::Vec3 p = ew::Vec3(n.x >= 0 ? box.max.x : box.min.x, n.y >= 0 ? box.max.y : box.min.y, n.z >= 0 ? box.max.z : box.min.z);
+			ew::Vec3 q = ew::Vec3(n.x >= 0 ? box.min.x : box.max.x, n.y >= 0 ? box.min.y : box.max.y, n.z >= 0 ? box.min.z : box.max.z);
+			if (ew::Dot(n, p) + frustum.planes[i].distance < 0) {
+				return -1;
+			}
+			if (ew::Dot(n, q) + frustum.planes[i].distance < 0) {
+				result = 0;
+			}
+		}
+		return result;
+	}
+	//Slab test. Returns the entry distance, or a negative number on a miss.
+	static inline float intersectRay(const AABB& box, const ew::Vec3& origin, const ew::Vec3& inverseDirection, float maxDistance) {
+		float tx1 = (box.min.x - origin.x) * inverseDirection.x, tx2 = (box.max.x - origin.x) * inverseDirection.x;
+		float ty1 = (box.min.y - origin.y) * inverseDirection.y, ty2 = (box.max.y - origin.y) * inverseDirection.y;
+		float tz1 = (box.min.z - origin.z) * inverseDirection.z, tz2 = (box.max.z - origin.z) * inverseDirection.z;
+		float tmin = fmaxf(fmaxf(fminf(tx1, tx2), fminf(ty1, ty2)), fmaxf(fminf(tz1, tz2), 0.0f));
+		float tmax = fminf(fminf(fmaxf(tx1, tx2), fmaxf(ty1, ty2)), fminf(fmaxf(tz1, tz2), maxDistance));
+		return tmin <= tmax ? tmin : -1.0f;
+	}
+	static inline float distanceSquared(const AABB& box, const ew::Vec3& p) {
+		float dx = maxf(maxf(box.min.x - p.x, p.x - box.max.x), 0.0f);
+		float dy = maxf(maxf(box.min.y - p.y, p.y - box.max.y), 0.0f);
+		float dz = maxf(maxf(box.min.z - p.z, p.z - box.max.z), 0.0f);
+		return dx * dx + dy * dy + dz * dz;
+	}
+
+	/// <summary>
+	/// Builds the tree from scratch. Object i keeps index i in every query result.
+	/// </summary>
+	void BVH::build(const AABB* bounds, int count)
+	{
+		clear();
+		if (count <= 0) {
+			return;
+		}
+		m_objectBounds.assign(bounds, bounds + count);
+		m_objects.resize(count);
+		m_centroids.resize(count);
+		for (int i = 0; i < count; i++) {
+			m_objects[i] = i;
+			m_centroids[i] = (bounds[i].min + bounds[i].max) * 0.5f;
+		}
+		m_nodes.reserve(count * 2);
+		m_parents.reserve(count * 2);
+		Node root;
+		root.first = 0;
+		root.count = count;
+		m_nodes.push_back(root);
+		m_parents.push_back(-1);
+		updateNodeBounds(0);
+
+		//Node index, depth
+		std::vector<std::pair<int, int>> stack;
+		stack.push_back(std::make_pair(0, 0));
+		while (!stack.empty()) {
+			int nodeIndex = stack.back().first;
+			int depth = stack.back().second;
+			stack.pop_back();
+			if (depth >= BVH_MAX_DEPTH) {
+				continue;
+			}
+			subdivide(nodeIndex);
+			if (m_nodes[nodeIndex].count == 0) {
+				stack.push_back(std::make_pair(m_nodes[nodeIndex].first, depth + 1));
+				stack.push_back(std::make_pair(m_nodes[nodeIndex].first + 1, depth + 1));
+			}
+		}
+
+		m_centroids.clear();
+		m_centroids.shrink_to_fit();
+
+		m_objectLeaves.resize(count);
+		for (int i = 0; i < (int)m_nodes.size(); i++)
+		{
+			const Node& node = m_nodes[i];
+			for (int j = 0; j < node.count; j++) {
+				m_objectLeaves[m_objects[node.first + j]] = i;
+			}
+		}
+	}
+	void BVH::clear()
+	{
+		m_nodes.clear();
+		m_objects.clear();
+		m_parents.clear();
+		m_objectLeaves.clear();
+		m_objectBounds.clear();
+	}
+	void BVH::updateNodeBounds(int nodeIndex)
+	{
+		Node& node = m_nodes[nodeIndex];
+		if (node.count == 0) {
+			node.bounds = m_nodes[node.first].bounds;
+			grow(node.bounds, m_nodes[node.first + 1].bounds);
+			return;
+		}
+		node.bounds = emptyBox();
+		for (int i = 0; i < node.count; i++) {
+			grow(node.bounds, m_objectBounds[m_objects[node.first + i]]);
+		}
+	}
+	//Splits a leaf along the cheapest binned SAH plane, or leaves it alone if splitting costs more
+	void BVH::subdivide(int nodeIndex)
+	{
+		Node node = m_nodes[nodeIndex];
+		if (node.count <= BVH_MAX_LEAF_OBJECTS) {
+			return;
+		}
+		//Bin on centroids, whose bounds can be much smaller than the node's
+		AABB centroids = emptyBox();
+		for (int i = 0; i < node.count; i++)
+		{
+			AABB point;
+			point.min = point.max = m_centroids[m_objects[node.first + i]];
+			grow(centroids, point);
+		}
+
+		//All three axes are binned in one pass, objects are scattered in memory
+		AABB binBounds[3][BVH_BINS];
+		int binCounts[3][BVH_BINS] = { 0 };
+		float binScale[3];
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float extent = (&centroids.max.x)[axis] - (&centroids.min.x)[axis];
+			binScale[axis] = extent > 0 ? BVH_BINS / extent : 0;
+			for (int b = 0; b < BVH_BINS; b++) {
+				binBounds[axis][b] = emptyBox();
+			}
+		}
+		for (int i = 0; i < node.count; i++)
+		{
+			int object = m_objects[node.first + i];
+			const AABB& box = m_objectBounds[object];
+			const ew::Vec3& c = m_centroids[object];
+			for (int axis = 0; axis < 3; axis++)
+			{
+				int b = (int)(((&c.x)[axis] - (&centroids.min.x)[axis]) * binScale[axis]);
+				b = b < BVH_BINS - 1 ? b : BVH_BINS - 1;
+				binCounts[axis][b]++;
+				grow(binBounds[axis][b], box);
+			}
+		}
+
+		int bestAxis = -1;
+		int bestSplit = 0;
+		float bestCost = 1e30f;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			if (binScale[axis] == 0) {
+				continue;
+			}
+			//Sweep from both sides so each split plane costs O(1)
+			float leftArea[BVH_BINS - 1], rightArea[BVH_BINS - 1];
+			int leftCount[BVH_BINS - 1], rightCount[BVH_BINS - 1];
+			AABB leftBox = emptyBox(), rightBox = emptyBox();
+			int leftSum = 0, rightSum = 0;
+			for (int b = 0; b < BVH_BINS - 1; b++)
+			{
+				leftSum += binCounts[axis][b];
+				grow(leftBox, binBounds[axis][b]);
+				leftCount[b] = leftSum;
+				leftArea[b] = surfaceArea(leftBox);
+				rightSum += binCounts[axis][BVH_BINS - 1 - b];
+				grow(rightBox, binBounds[axis][BVH_BINS - 1 - b]);
+				rightCount[BVH_BINS - 2 - b] = rightSum;
+				rightArea[BVH_BINS - 2 - b] = surfaceArea(rightBox);
+			}
+			for (int b = 0; b < BVH_BINS - 1; b++)
+			{
+				if (leftCount[b] == 0 || rightCount[b] == 0) {
+					continue;
+				}
+				float cost = leftCount[b] * leftArea[b] + rightCount[b] * rightArea[b];
+				if (cost < bestCost) {
+					bestCost = cost;
+					bestAxis = axis;
+					bestSplit = b;
+				}
+			}
+		}
+		if (bestAxis < 0 || bestCost >= node.count * surfaceArea(node.bounds)) {
+			return;
+		}
+
+		//Partition in place
+		float lo = (&centroids.min.x)[bestAxis];
+		float scale = binScale[bestAxis];
+		int i = node.first;
+		int j = node.first + node.count - 1;
+		while (i <= j) {
+			int b = (int)(((&m_centroids[m_objects[i]].x)[bestAxis] - lo) * scale);
+			b = b < BVH_BINS - 1 ? b : BVH_BINS - 1;
+			if (b <= bestSplit) {
+				i++;
+			}
+			else {
+				int temp = m_objects[i];
+				m_objects[i] = m_objects[j];
+				m_objects[j--] = temp;
+			}
+		}
+		int leftCount = i - node.first;
+
+		int leftIndex = (int)m_nodes.size();
+		Node left, right;
+		left.first = node.first;
+		left.count = leftCount;
+		right.first = i;
+		right.count = node.count - leftCount;
+		m_nodes.push_back(left);
+		m_nodes.push_back(right);
+		m_parents.push_back(nodeIndex);
+		m_parents.push_back(nodeIndex);
+		updateNodeBounds(leftIndex);
+		updateNodeBounds(leftIndex + 1);
+		m_nodes[nodeIndex].first = leftIndex;
+		m_nodes[nodeIndex].count = 0;
+	}
+	/// <summary>
+	/// Moves one object and fixes the bounds of its leaf and ancestors
+	/// </summary>
+	void BVH::refit(int object, const AABB& bounds)
+	{
+		m_objectBounds[object] = bounds;
+		for (int nodeIndex = m_objectLeaves[object]; nodeIndex >= 0; nodeIndex = m_parents[nodeIndex]) {
+			updateNodeBounds(nodeIndex);
+		}
+	}
+	/// <summary>
+	/// Replaces every object's bounds and refits the whole tree bottom up
+	/// </summary>
+	void BVH::refitAll(const AABB* bounds)
+	{
+		m_objectBounds.assign(bounds, bounds + m_objectBounds.size());
+		//Children are always stored after their parent
+		for (int i = (int)m_nodes.size() - 1; i >= 0; i--) {
+			updateNodeBounds(i);
+		}
+	}
+	void BVH::addSubtree(int nodeIndex, std::vector<int>& results) const
+	{
+		const Node& node = m_nodes[nodeIndex];
+		if (node.count > 0) {
+			results.insert(results.end(), m_objects.begin() + node.first, m_objects.begin() + node.first + node.count);
+			return;
+		}
+		addSubtree(node.first, results);
+		addSubtree(node.first + 1, results);
+	}
+	/// <summary>
+	/// Appends every object whose bounds touch the frustum to results
+	/// </summary>
+	/// <returns>Number of objects appended</returns>
+	int BVH::queryFrustum(const Frustum& frustum, std::vector<int>& results) const
+	{
+		size_t start = results.size();
+		if (m_nodes.empty()) {
+			return 0;
+		}
+		int stack[BVH_STACK_SIZE];
+		int stackSize = 0;
+		stack[stackSize++] = 0;
+		while (stackSize > 0) {
+			int nodeIndex = stack[--stackSize];
+			const Node& node = m_nodes[nodeIndex];
+			int result = classify(frustum, node.bounds);
+			if (result < 0) {
+				continue;
+			}
+			if (result > 0) {
+				//Fully inside, no need to test anything below
+				addSubtree(nodeIndex, results);
+				continue;
+			}
+			if (node.count > 0) {
+				for (int i = 0; i < node.count; i++)
+				{
+					int object = m_objects[node.first + i];
+					if (classify(frustum, m_objectBounds[object]) >= 0) {
+						results.push_back(object);
+					}
+				}
+				continue;
+			}
+			stack[stackSize++] = node.first;
+			stack[stackSize++] = node.first + 1;
+		}
+		return (int)(results.size() - start);
+	}
+	/// <summary>
+	/// Finds the closest object bounds along a ray
+	/// </summary>
+	RayHit BVH::raycast(const ew::Vec3& origin, const ew::Vec3& direction, float maxDistance) const
+	{
+		RayHit hit;
+		if (m_nodes.empty()) {
+			return hit;
+		}
+		ew::Vec3 inverseDirection = ew::Vec3(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+		float closest = maxDistance;
+		int stack[BVH_STACK_SIZE];
+		int stackSize = 0;
+		if (intersectRay(m_nodes[0].bounds, origin, inverseDirection, closest) >= 0) {
+			stack[stackSize++] = 0;
+		}
+		while (stackSize > 0) {
+			const Node& node = m_nodes[stack[--stackSize]];
+			if (node.count > 0) {
+				for (int i = 0; i < node.count; i++)
+				{
+					int object = m_objects[node.first + i];
+					float t = intersectRay(m_objectBounds[object], origin, inverseDirection, closest);
+					if (t >= 0 && (hit.object < 0 || t < closest)) {
+						closest = t;
+						hit.object = object;
+						hit.distance = t;
+					}
+				}
+				continue;
+			}
+			//Visit the nearer child first so the far one is more likely to be skipped
+			int nearChild = node.first, farChild = node.first + 1;
+			float tNear = intersectRay(m_nodes[nearChild].bounds, origin, inverseDirection, closest);
+			float tFar = intersectRay(m_nodes[farChild].bounds, origin, inverseDirection, closest);
+			if (tFar >= 0 && tNear >= 0 && tFar < tNear) {
+				int temp = nearChild; nearChild = farChild; farChild = temp;
+			}
+			if (tFar >= 0) {
+				stack[stackSize++] = farChild;
+			}
+			if (tNear >= 0) {
+				stack[stackSize++] = nearChild;
+			}
+		}
+		return hit;
+	}
+	/// <summary>
+	/// Finds the object whose bounds are closest to a point. 0 distance when the point is inside them.
+	/// </summary>
+	/// <returns>Object index, or -1 if the tree is empty</returns>
+	int BVH::nearest(const ew::Vec3& point, float* outDistance) const
+	{
+		int best = -1;
+		float bestDistance = 1e30f;
+		if (!m_nodes.empty()) {
+			int stack[BVH_STACK_SIZE];
+			int stackSize = 0;
+			stack[stackSize++] = 0;
+			while (stackSize > 0) {
+				const Node& node = m_nodes[stack[--stackSize]];
+				if (distanceSquared(node.bounds, point) >= bestDistance) {
+					continue;
+				}
+				if (node.count > 0) {
+					for (int i = 0; i < node.count; i++)
+					{
+						int object = m_objects[node.first + i];
+						float d = distanceSquared(m_objectBounds[object], point);
+						if (d < bestDistance) {
+							bestDistance = d;
+							best = object;
+						}
+					}
+					continue;
+				}
+				int nearChild = node.first, farChild = node.first + 1;
+				if (distanceSquared(m_nodes[farChild].bounds, point) < distanceSquared(m_nodes[nearChild].bounds, point)) {
+					nearChild = node.first + 1;
+					farChild = node.first;
+				}
+				stack[stackSize++] = farChild;
+				stack[stackSize++] = nearChild;
+			}
+		}
+		if (outDistance) {
+			*outDistance = best >= 0 ? sqrtf(bestDistance) : 0;
+		}
+		return best;
+	}
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <vector>
+#include "ewMath/ewMath.h"
+#include "frustum.h"
+
+namespace ew {
+	struct AABB {
+		ew::Vec3 min = ew::Vec3(0);
+		ew::Vec3 max = ew::Vec3(0);
+	};
+
+	struct RayHit {
+		int object = -1; //-1 when nothing was hit
+		float distance = 0; //Along the ray direction, in units of its length
+	};
+
+	/// <summary>
+	/// Bounding volume hierarchy over object AABBs. Built with the surface area heuristic,
+	/// then kept valid with refit() as objects move. Rebuild when objects are added or removed,
+	/// or after a lot of movement, since refitting does not change the tree's shape.
+	/// </summary>
+	class BVH {
+	public:
+		void build(const AABB* bounds, int count);
+		void refit(int object, const AABB& bounds);
+		void refitAll(const AABB* bounds);
+		void clear();
+		int queryFrustum(const Frustum& frustum, std::vector<int>& results) const;
+		RayHit raycast(const ew::Vec3& origin, const ew::Vec3& direction, float maxDistance = 1e30f) const;
+		int nearest(const ew::Vec3& point, float* outDistance = nullptr) const;
+		inline int getObjectCount()const { return (int)m_objectBounds.size(); }
+		inline int getNodeCount()const { return (int)m_nodes.size(); }
+	private:
+		struct Node {
+			AABB bounds;
+			int first; //Leaf: first entry in m_objects. Inner: index of the left child, the right child follows it.
+			int count; //Objects in a leaf, 0 for inner nodes
+		};
+		void subdivide(int nodeIndex);
+		void updateNodeBounds(int nodeIndex);
+		void addSubtree(int nodeIndex, std::vector<int>& results) const;
+		std::vector<Node> m_nodes;
+		std::vector<int> m_objects; //Object indices, grouped by leaf
+		std::vector<int> m_parents; //Parent of each node, -1 for the root
+		std::vector<int> m_objectLeaves; //Leaf holding each object
+		std::vector<AABB> m_objectBounds;
+		std::vector<ew::Vec3> m_centroids; //Only used while building
+	};
+}
@@ -0,0 +1,254 @@
+#include "cookedTexture.h"
+#include "blockCompression.h"
+#include <stdio.h>
+#include <string.h>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ew {
+	namespace {
+		int getBlockBytes(CookedFormat format) {
+			switch (format) {
+			case CookedFormat::BC1:
+				return BC1_BLOCK_BYTES;
+			case CookedFormat::BC3:
+				return BC3_BLOCK_BYTES;
+			default:
+				return 0;
+			}
+		}
+		unsigned int alignOffset(unsigned int offset) {
+			return (offset + COOKED_TEXTURE_ALIGNMENT - 1) / COOKED_TEXTURE_ALIGNMENT * COOKED_TEXTURE_ALIGNMENT;
+		}
+	}
+
+	const char* GetCookedFormatName(CookedFormat format)
+	{
+		switch (format) {
+		case CookedFormat::BC1:
+			return "BC1";
+		case CookedFormat::BC3:
+			return "BC3";
+		default:
+			return "RGBA8";
+		}
+	}
+	/// <summary>
+	/// Bytes in one mip. Compressed mips round up to whole 4x4 blocks, so 2x2 and 1x1 still take a block.
+	/// </summary>
+	unsigned int GetCookedMipSize(CookedFormat format, int width, int height)
+	{
+		int blockBytes = getBlockBytes(format);
+		if (blockBytes == 0) {
+			return (unsigned int)width * height * 4;
+		}
+		return (unsigned int)((width + 3) / 4) * ((height + 3) / 4) * blockBytes;
+	}
+	std::string GetCookedTexturePath(const char* sourcePath)
+	{
+		std::string path = sourcePath;
+		size_t dot = path.find_last_of('.');
+		size_t slash = path.find_last_of("/\\");
+		if (dot != std::string::npos && (slash == std::string::npos || dot > slash)) {
+			path.erase(dot);
+		}
+		return path + ".ewtex";
+	}
+	CookedFormat ChooseCookedFormat(const unsigned char* rgba, int width, int height)
+	{
+		size_t numPixels = (size_t)width * height;
+		for (size_t i = 0; i < numPixels; i++) {
+			if (rgba[i * 4 + 3] != 255) {
+				return CookedFormat::BC3;
+			}
+		}
+		return CookedFormat::BC1;
+	}
+	/// <summary>
+	/// Halves both dimensions (down to 1) with a box filter. Odd sizes reuse the last row/column.
+	/// </summary>
+	std::vector<unsigned char> DownsampleRGBA(const unsigned char* rgba, int width, int height)
+	{
+		int outWidth = width > 1 ? width / 2 : 1;
+		int outHeight = height > 1 ? height / 2 : 1;
+		std::vector<unsigned char> out((size_t)outWidth * outHeight * 4);
+		for (int y = 0; y < outHeight; y++) {
+			int y0 = y * 2 < height ? y * 2 : height - 1;
+			int y1 = y * 2 + 1 < height ? y * 2 + 1 : height - 1;
+			for (int x = 0; x < outWidth; x++) {
+				int x0 = x * 2 < width ? x * 2 : width - 1;
+				int x1 = x * 2 + 1 < width ? x * 2 + 1 : width - 1;
+				const unsigned char* p00 = rgba + ((size_t)y0 * width + x0) * 4;
+				const unsigned char* p01 = rgba + ((size_t)y0 * width + x1) * 4;
+				const unsigned char* p10 = rgba + ((size_t)y1 * width + x0) * 4;
+				const unsigned char* p11 = rgba + ((size_t)y1 * width + x1) * 4;
+				unsigned char* o = &out[((size_t)y * outWidth + x) * 4];
+				for (int c = 0; c < 4; c++) {
+					o[c] = (unsigned char)((p00[c] + p01[c] + p10[c] + p11[c] + 2) / 4);
+				}
+			}
+		}
+		return out;
+	}
+	/// <summary>
+	/// Builds a whole .ewtex file in memory: header, then every mip down to 1x1 encoded in format.
+	/// </summary>
+	/// <param name="rgba">Mip 0, 4 bytes per pixel</param>
+	/// <param name="flags">COOKED_TEXTURE_ flags to record in the header</param>
+	bool CookTexture(const unsigned char* rgba, int width, int height, CookedFormat format, unsigned int flags, std::vector<unsigned char>& file)
+	{
+		if (width <= 0 || height <= 0) {
+			printf("Can't cook a %dx%d texture\n", width, height);
+			return false;
+		}
+		CookedTextureHeader header = {};
+		header.magic = COOKED_TEXTURE_MAGIC;
+		header.version = COOKED_TEXTURE_VERSION;
+		header.format = format;
+		header.width = width;
+		header.height = height;
+		header.flags = flags;
+
+		unsigned int offset = sizeof(CookedTextureHeader);
+		int mipWidth = width, mipHeight = height;
+		while (header.mipCount < COOKED_TEXTURE_MAX_MIPS) {
+			CookedMip& mip = header.mips[header.mipCount++];
+			mip.offset = offset;
+			mip.size = GetCookedMipSize(format, mipWidth, mipHeight);
+			mip.width = mipWidth;
+			mip.height = mipHeight;
+			offset = alignOffset(offset + mip.size);
+			if (mipWidth == 1 && mipHeight == 1) {
+				break;
+			}
+			mipWidth = mipWidth > 1 ? mipWidth / 2 : 1;
+			mipHeight = mipHeight > 1 ? mipHeight / 2 : 1;
+		}
+
+		file.assign(offset, 0);
+		memcpy(file.data(), &header, sizeof(header));
+		std::vector<unsigned char> level(rgba, rgba + (size_t)width * height * 4);
+		for (unsigned int i = 0; i < header.mipCount; i++) {
+			const CookedMip& mip = header.mips[i];
+			if (i > 0) {
+				level = DownsampleRGBA(level.data(), header.mips[i - 1].width, header.mips[i - 1].height);
+			}
+			unsigned char* out = &file[mip.offset];
+			switch (format) {
+			case CookedFormat::BC1:
+				EncodeBC1(level.data(), mip.width, mip.height, out);
+				break;
+			case CookedFormat::BC3:
+				EncodeBC3(level.data(), mip.width, mip.height, out);
+				break;
+			default:
+				memcpy(out, level.data(), mip.size);
+				break;
+			}
+		}
+		return true;
+	}
+	bool WriteCookedTexture(const char* filePath, const std::vector<unsigned char>& file)
+	{
+		FILE* f = fopen(filePath, "wb");
+		if (f == NULL) {
+			printf("Failed to open %s for writing\n", filePath);
+			return false;
+		}
+		bool written = fwrite(file.data(), 1, file.size(), f) == file.size();
+		fclose(f);
+		if (!written) {
+			printf("Failed to write %s\n", filePath);
+		}
+		return written;
+	}
+
+	CookedTextureFile::~CookedTextureFile()
+	{
+		close();
+	}
+	/// <summary>
+	/// Maps the file read only and checks the header and mip table against its size.
+	/// </summary>
+	bool CookedTextureFile::open(const char* filePath)
+	{
+		close();
+#ifdef _WIN32
+		HANDLE file = CreateFileA(filePath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file == INVALID_HANDLE_VALUE) {
+			return false;
+		}
+		LARGE_INTEGER size;
+		GetFileSizeEx(file, &size);
+		HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		CloseHandle(file);
+		if (mapping == NULL) {
+			printf("Failed to map %s\n", filePath);
+			return false;
+		}
+		m_data = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (m_data == NULL) {
+			CloseHandle(mapping);
+			printf("Failed to map %s\n", filePath);
+			return false;
+		}
+		m_mapping = mapping;
+		m_size = (size_t)size.QuadPart;
+#else
+		int file = ::open(filePath, O_RDONLY);
+		if (file < 0) {
+			return false;
+		}
+		struct stat info;
+		if (fstat(file, &info) != 0 || info.st_size == 0) {
+			::close(file);
+			printf("Failed to map %s\n", filePath);
+			return false;
+		}
+		void* data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+		::close(file);
+		if (data == MAP_FAILED) {
+			printf("Failed to map %s\n", filePath);
+			return false;
+		}
+		m_data = (const unsigned char*)data;
+		m_size = (size_t)info.st_size;
+#endif
+		const CookedTextureHeader* header = getHeader();
+		bool valid = m_size >= sizeof(CookedTextureHeader) && header->magic == COOKED_TEXTURE_MAGIC && header->version == COOKED_TEXTURE_VERSION
+			&& header->format <= CookedFormat::BC3 && header->mipCount > 0 && header->mipCount <= COOKED_TEXTURE_MAX_MIPS;
+		for (unsigned int i = 0; valid && i < header->mipCount; i++) {
+			const CookedMip& mip = header->mips[i];
+			valid = (size_t)mip.offset + mip.size <= m_size && mip.size == GetCookedMipSize(header->format, mip.width, mip.height);
+		}
+		if (!valid) {
+			printf("%s is not a version %u cooked texture\n", filePath, COOKED_TEXTURE_VERSION);
+			close();
+			return false;
+		}
+		return true;
+	}
+	void CookedTextureFile::close()
+	{
+		if (m_data == nullptr) {
+			return;
+		}
+#ifdef _WIN32
+		UnmapViewOfFile(m_data);
+		CloseHandle((HANDLE)m_mapping);
+#else
+		munmap((void*)m_data, m_size);
+#endif
+		m_data = nullptr;
+		m_mapping = nullptr;
+		m_size = 0;
+	}
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <vector>
+#include <string>
+
+namespace ew {
+	constexpr unsigned int COOKED_TEXTURE_MAGIC = 0x58545745; //"EWTX"
+	constexpr unsigned int COOKED_TEXTURE_VERSION = 1;
+	constexpr int COOKED_TEXTURE_MAX_MIPS = 16;
+	constexpr int COOKED_TEXTURE_ALIGNMENT = 16; //Every mip starts on this many bytes
+	constexpr unsigned int COOKED_TEXTURE_FLIPPED = 1; //Rows were flipped when cooked, as qm::loadTexture does
+
+	enum class CookedFormat : unsigned int {
+		RGBA8 = 0, //Uncompressed fallback
+		BC1, //RGB, 4 bits per pixel
+		BC3 //RGBA, 8 bits per pixel
+	};
+
+	struct CookedMip {
+		unsigned int offset; //From the start of the file
+		unsigned int size;
+		unsigned int width;
+		unsigned int height;
+	};
+
+	/// <summary>
+	/// Start of a .ewtex file. Mip 0 is the full image; the data for each mip is laid out exactly as
+	/// glCompressedTexImage2D (or glTexImage2D for RGBA8) expects it. Little endian.
+	/// </summary>
+	struct CookedTextureHeader {
+		unsigned int magic;
+		unsigned int version;
+		CookedFormat format;
+		unsigned int width;
+		unsigned int height;
+		unsigned int mipCount;
+		unsigned int flags;
+		unsigned int reserved;
+		CookedMip mips[COOKED_TEXTURE_MAX_MIPS];
+	};
+	static_assert(sizeof(CookedTextureHeader) % COOKED_TEXTURE_ALIGNMENT == 0, "Mip data must start aligned");
+
+	const char* GetCookedFormatName(CookedFormat format);
+	unsigned int GetCookedMipSize(CookedFormat format, int width, int height);
+	std::string GetCookedTexturePath(const char* sourcePath); //Same path with a .ewtex extension
+	CookedFormat ChooseCookedFormat(const unsigned char* rgba, int width, int height); //BC1 if opaque, otherwise BC3
+
+	//Offline side, used by texcook
+	std::vector<unsigned char> DownsampleRGBA(const unsigned char* rgba, int width, int height);
+	bool CookTexture(const unsigned char* rgba, int width, int height, CookedFormat format, unsigned int flags, std::vector<unsigned char>& file);
+	bool WriteCookedTexture(const char* filePath, const std::vector<unsigned char>& file);
+
+	/// <summary>
+	/// A .ewtex file mapped into memory. The header and mips point straight into the mapping.
+	/// </summary>
+	class CookedTextureFile {
+	public:
+		CookedTextureFile() {}
+		~CookedTextureFile();
+		CookedTextureFile(const CookedTextureFile&) = delete;
+		CookedTextureFile& operator=(const CookedTextureFile&) = delete;
+		bool open(const char* filePath); //False without printing if the file doesn't exist
+		void close();
+		inline const CookedTextureHeader* getHeader()const { return (const CookedTextureHeader*)m_data; }
+		inline const unsigned char* getMipData(int mip)const { return m_data + getHeader()->mips[mip].offset; }
+		inline size_t getFileSize()const { return m_size; }
+	private:
+		const unsigned char* m_data = nullptr;
+		size_t m_size = 0;
+		void* m_mapping = nullptr; //Windows file mapping handle
+	};
+
+	//GL side, in cookedTextureUpload.cpp so texcook doesn't need GL
+	unsigned int uploadCookedTexture(const CookedTextureFile& file, int wrapMode, int filterMode);
+	unsigned int loadCookedTexture(const char* filePath, int wrapMode, int filterMode);
+}
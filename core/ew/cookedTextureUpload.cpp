@@ -0,0 +1,97 @@
+#include "cookedTexture.h"
+#include "blockCompression.h"
+#include "glState.h"
+#include "external/glad.h"
+#include <stdio.h>
+#include <string.h>
+
+//S3TC is an extension everywhere desktop GL runs, so glad's core profile header doesn't define it
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+namespace ew {
+	namespace {
+		bool supportsS3TC() {
+			static int supported = -1;
+			if (supported < 0) {
+				supported = 0;
+				int numExtensions = 0;
+				glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
+				for (int i = 0; i < numExtensions; i++) {
+					const char* name = (const char*)glGetStringi(GL_EXTENSIONS, i);
+					if (name && strcmp(name, "GL_EXT_texture_compression_s3tc") == 0) {
+						supported = 1;
+						break;
+					}
+				}
+			}
+			return supported == 1;
+		}
+	}
+
+	/// <summary>
+	/// Creates a texture straight from the mapped mips. Compressed mips go to glCompressedTexImage2D untouched;
+	/// on drivers without S3TC they are decoded to RGBA8 first.
+	/// </summary>
+	unsigned int uploadCookedTexture(const CookedTextureFile& file, int wrapMode, int filterMode)
+	{
+		const CookedTextureHeader* header = file.getHeader();
+		if (header == nullptr) {
+			return 0;
+		}
+		bool compressed = header->format != CookedFormat::RGBA8;
+		bool decode = compressed && !supportsS3TC();
+		GLenum internalFormat = header->format == CookedFormat::BC1 ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+
+		unsigned int texture;
+		glGenTextures(1, &texture);
+		GLState::bindTexture(GL_TEXTURE_2D, texture);
+		std::vector<unsigned char> decoded;
+		for (unsigned int i = 0; i < header->mipCount; i++) {
+			const CookedMip& mip = header->mips[i];
+			const unsigned char* data = file.getMipData(i);
+			if (compressed && !decode) {
+				glCompressedTexImage2D(GL_TEXTURE_2D, i, internalFormat, mip.width, mip.height, 0, mip.size, data);
+				continue;
+			}
+			if (decode) {
+				decoded.resize((size_t)mip.width * mip.height * 4);
+				if (header->format == CookedFormat::BC1) {
+					DecodeBC1(data, mip.width, mip.height, decoded.data());
+				}
+				else {
+					DecodeBC3(data, mip.width, mip.height, decoded.data());
+				}
+				data = decoded.data();
+			}
+			glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA, mip.width, mip.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+		}
+		//The chain is complete without glGenerateMipmap, as long as GL knows where it ends
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, header->mipCount - 1);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapMode);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrapMode);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filterMode);
+		float borderColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+		glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
+		GLState::bindTexture(GL_TEXTURE_2D, 0);
+		return texture;
+	}
+	/// <summary>
+	/// Maps a .ewtex written by texcook, uploads it and unmaps it.
+	/// </summary>
+	/// <returns>The texture, or 0 if the file is missing or invalid</returns>
+	unsigned int loadCookedTexture(const char* filePath, int wrapMode, int filterMode)
+	{
+		CookedTextureFile file;
+		if (!file.open(filePath)) {
+			printf("Failed to load cooked texture %s\n", filePath);
+			return 0;
+		}
+		return uploadCookedTexture(file, wrapMode, filterMode);
+	}
+}
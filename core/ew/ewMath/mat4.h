@@ -4,12 +4,13 @@
 
 #pragma once
 #include "vec4.h"
+#include "simd.h"
 #include <cstddef>
 
 namespace ew {
 	struct Mat4 {
 	private:
-		float n[4][4];
+		alignas(16) float n[4][4]; //Column major, one 16 byte aligned column per n[i]
 	public:
 		Mat4() = default;
 		Mat4(float n00)
@@ -41,39 +42,97 @@ namespace ew {
 		inline const Vec4& operator[](int i) const{
 			return (*reinterpret_cast<const Vec4*>(n[i]));
 		}
-		inline friend Vec4 operator * (const Mat4& m, const Vec4& v) {
-			return Vec4(
-				m[0][0] * v.x + m[1][0] * v.y + m[2][0] * v.z + m[3][0] * v.w,
-				m[0][1] * v.x + m[1][1] * v.y + m[2][1] * v.z + m[3][1] * v.w,
-				m[0][2] * v.x + m[1][2] * v.y + m[2][2] * v.z + m[3][2] * v.w,
-				m[0][3] * v.x + m[1][3] * v.y + m[2][3] * v.z + m[3][3] * v.w
-			);
+	};
+
+	//Reference implementations, used by the scalar backend and for comparison in benchmarks
+	inline Vec4 MulScalar(const Mat4& m, const Vec4& v) {
+		return Vec4(
+			m[0][0] * v.x + m[1][0] * v.y + m[2][0] * v.z + m[3][0] * v.w,
+			m[0][1] * v.x + m[1][1] * v.y + m[2][1] * v.z + m[3][1] * v.w,
+			m[0][2] * v.x + m[1][2] * v.y + m[2][2] * v.z + m[3][2] * v.w,
+			m[0][3] * v.x + m[1][3] * v.y + m[2][3] * v.z + m[3][3] * v.w
+		);
+	}
+	inline Mat4 MulScalar(const Mat4& l, const Mat4& r) {
+		Mat4 m;
+		//Row 0
+		m[0][0] = l[0][0] * r[0][0] + l[1][0] * r[0][1] + l[2][0] * r[0][2] + l[3][0] * r[0][3];//dot(l_row_0,r_col_0)
+		m[1][0] = l[0][0] * r[1][0] + l[1][0] * r[1][1] + l[2][0] * r[1][2] + l[3][0] * r[1][3];//dot(l_row_0,r_col_1)
+		m[2][0] = l[0][0] * r[2][0] + l[1][0] * r[2][1] + l[2][0] * r[2][2] + l[3][0] * r[2][3];//dot(l_row_0,r_col_2)
+		m[3][0] = l[0][0] * r[3][0] + l[1][0] * r[3][1] + l[2][0] * r[3][2] + l[3][0] * r[3][3];//dot(l_row_0,r_col_3)
+		// Row 1		  		    		  		    		  		    		  
+		m[0][1] = l[0][1] * r[0][0] + l[1][1] * r[0][1] + l[2][1] * r[0][2] + l[3][1] * r[0][3];//dot(l_row_1,r_col_0)
+		m[1][1] = l[0][1] * r[1][0] + l[1][1] * r[1][1] + l[2][1] * r[1][2] + l[3][1] * r[1][3];//dot(l_row_1,r_col_1)
+		m[2][1] = l[0][1] * r[2][0] + l[1][1] * r[2][1] + l[2][1] * r[2][2] + l[3][1] * r[2][3];//dot(l_row_1,r_col_2)
+		m[3][1] = l[0][1] * r[3][0] + l[1][1] * r[3][1] + l[2][1] * r[3][2] + l[3][1] * r[3][3];//dot(l_row_1,r_col_3)
+		// Row  2		  		    		  		    		  		    		  
+		m[0][2] = l[0][2] * r[0][0] + l[1][2] * r[0][1] + l[2][2] * r[0][2] + l[3][2] * r[0][3];//dot(l_row_2,r_col_0)
+		m[1][2] = l[0][2] * r[1][0] + l[1][2] * r[1][1] + l[2][2] * r[1][2] + l[3][2] * r[1][3];//dot(l_row_2,r_col_1)
+		m[2][2] = l[0][2] * r[2][0] + l[1][2] * r[2][1] + l[2][2] * r[2][2] + l[3][2] * r[2][3];//dot(l_row_2,r_col_2)
+		m[3][2] = l[0][2] * r[3][0] + l[1][2] * r[3][1] + l[2][2] * r[3][2] + l[3][2] * r[3][3];//dot(l_row_2,r_col_3)
+		// Row  3		 			 		 			 		 			 		    
+		m[0][3] = l[0][3] * r[0][0] + l[1][3] * r[0][1] + l[2][3] * r[0][2] + l[3][3] * r[0][3];//dot(l_row_3,r_col_0)
+		m[1][3] = l[0][3] * r[1][0] + l[1][3] * r[1][1] + l[2][3] * r[1][2] + l[3][3] * r[1][3];//dot(l_row_3,r_col_1)
+		m[2][3] = l[0][3] * r[2][0] + l[1][3] * r[2][1] + l[2][3] * r[2][2] + l[3][3] * r[2][3];//dot(l_row_3,r_col_2)
+		m[3][3] = l[0][3] * r[3][0] + l[1][3] * r[3][1] + l[2][3] * r[3][2] + l[3][3] * r[3][3];//dot(l_row_3,r_col_3)
+		return m;
+	}
+
+	inline Vec4 operator * (const Mat4& m, const Vec4& v) {
+#if defined(EW_SIMD_SCALAR)
+		return MulScalar(m, v);
+#else
+		//Columns scaled by each component of v and summed
+		simd::float4 c = simd::Load(&v.x);
+		simd::float4 result = simd::Mul(simd::Load(&m[0][0]), simd::Splat<0>(c));
+		result = simd::MulAdd(simd::Load(&m[1][0]), simd::Splat<1>(c), result);
+		result = simd::MulAdd(simd::Load(&m[2][0]), simd::Splat<2>(c), result);
+		result = simd::MulAdd(simd::Load(&m[3][0]), simd::Splat<3>(c), result);
+		Vec4 out;
+		simd::Store(&out.x, result);
+		return out;
+#endif
+	}
+
+	inline Mat4 operator * (const Mat4& l, const Mat4& r) {
+#if defined(EW_SIMD_SCALAR)
+		return MulScalar(l, r);
+#elif defined(EW_SIMD_AVX)
+		//Two result columns per iteration. Each 128 bit lane holds one column of r.
+		Mat4 m;
+		__m256 l0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&l[0][0]));
+		__m256 l1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&l[1][0]));
+		__m256 l2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&l[2][0]));
+		__m256 l3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&l[3][0]));
+		for (int i = 0; i < 4; i += 2)
+		{
+			__m256 rc = _mm256_loadu_ps(&r[i][0]);
+			__m256 result = _mm256_mul_ps(l0, _mm256_shuffle_ps(rc, rc, _MM_SHUFFLE(0, 0, 0, 0)));
+			result = _mm256_add_ps(result, _mm256_mul_ps(l1, _mm256_shuffle_ps(rc, rc, _MM_SHUFFLE(1, 1, 1, 1))));
+			result = _mm256_add_ps(result, _mm256_mul_ps(l2, _mm256_shuffle_ps(rc, rc, _MM_SHUFFLE(2, 2, 2, 2))));
+			result = _mm256_add_ps(result, _mm256_mul_ps(l3, _mm256_shuffle_ps(rc, rc, _MM_SHUFFLE(3, 3, 3, 3))));
+			_mm256_storeu_ps(&m[i][0], result);
 		}
-		inline friend Mat4 operator * (const Mat4& l, const Mat4& r) {
-			Mat4 m;
-			//Row 0
-			m[0][0] = l[0][0] * r[0][0] + l[1][0] * r[0][1] + l[2][0] * r[0][2] + l[3][0] * r[0][3];//dot(l_row_0,r_col_0)
-			m[1][0] = l[0][0] * r[1][0] + l[1][0] * r[1][1] + l[2][0] * r[1][2] + l[3][0] * r[1][3];//dot(l_row_0,r_col_1)
-			m[2][0] = l[0][0] * r[2][0] + l[1][0] * r[2][1] + l[2][0] * r[2][2] + l[3][0] * r[2][3];//dot(l_row_0,r_col_2)
-			m[3][0] = l[0][0] * r[3][0] + l[1][0] * r[3][1] + l[2][0] * r[3][2] + l[3][0] * r[3][3];//dot(l_row_0,r_col_3)
-			// Row 1		  		    		  		    		  		    		  
-			m[0][1] = l[0][1] * r[0][0] + l[1][1] * r[0][1] + l[2][1] * r[0][2] + l[3][1] * r[0][3];//dot(l_row_1,r_col_0)
-			m[1][1] = l[0][1] * r[1][0] + l[1][1] * r[1][1] + l[2][1] * r[1][2] + l[3][1] * r[1][3];//dot(l_row_1,r_col_1)
-			m[2][1] = l[0][1] * r[2][0] + l[1][1] * r[2][1] + l[2][1] * r[2][2] + l[3][1] * r[2][3];//dot(l_row_1,r_col_2)
-			m[3][1] = l[0][1] * r[3][0] + l[1][1] * r[3][1] + l[2][1] * r[3][2] + l[3][1] * r[3][3];//dot(l_row_1,r_col_3)
-			// Row  2		  		    		  		    		  		    		  
-			m[0][2] = l[0][2] * r[0][0] + l[1][2] * r[0][1] + l[2][2] * r[0][2] + l[3][2] * r[0][3];//dot(l_row_2,r_col_0)
-			m[1][2] = l[0][2] * r[1][0] + l[1][2] * r[1][1] + l[2][2] * r[1][2] + l[3][2] * r[1][3];//dot(l_row_2,r_col_1)
-			m[2][2] = l[0][2] * r[2][0] + l[1][2] * r[2][1] + l[2][2] * r[2][2] + l[3][2] * r[2][3];//dot(l_row_2,r_col_2)
-			m[3][2] = l[0][2] * r[3][0] + l[1][2] * r[3][1] + l[2][2] * r[3][2] + l[3][2] * r[3][3];//dot(l_row_2,r_col_3)
-			// Row  3		 			 		 			 		 			 		    
-			m[0][3] = l[0][3] * r[0][0] + l[1][3] * r[0][1] + l[2][3] * r[0][2] + l[3][3] * r[0][3];//dot(l_row_3,r_col_0)
-			m[1][3] = l[0][3] * r[1][0] + l[1][3] * r[1][1] + l[2][3] * r[1][2] + l[3][3] * r[1][3];//dot(l_row_3,r_col_1)
-			m[2][3] = l[0][3] * r[2][0] + l[1][3] * r[2][1] + l[2][3] * r[2][2] + l[3][3] * r[2][3];//dot(l_row_3,r_col_2)
-			m[3][3] = l[0][3] * r[3][0] + l[1][3] * r[3][1] + l[2][3] * r[3][2] + l[3][3] * r[3][3];//dot(l_row_3,r_col_3)
-			return m;		  
+		return m;
+#else
+		//Column i of the result is l * (column i of r)
+		Mat4 m;
+		simd::float4 l0 = simd::Load(&l[0][0]);
+		simd::float4 l1 = simd::Load(&l[1][0]);
+		simd::float4 l2 = simd::Load(&l[2][0]);
+		simd::float4 l3 = simd::Load(&l[3][0]);
+		for (int i = 0; i < 4; i++)
+		{
+			simd::float4 rc = simd::Load(&r[i][0]);
+			simd::float4 result = simd::Mul(l0, simd::Splat<0>(rc));
+			result = simd::MulAdd(l1, simd::Splat<1>(rc), result);
+			result = simd::MulAdd(l2, simd::Splat<2>(rc), result);
+			result = simd::MulAdd(l3, simd::Splat<3>(rc), result);
+			simd::Store(&m[i][0], result);
 		}
-	};
+		return m;
+#endif
+	}
 	inline Mat4 IdentityMatrix() {
 		return Mat4(
 			1.0f, 0.0f, 0.0f, 0.0f,
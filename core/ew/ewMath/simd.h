@@ -0,0 +1,164 @@
+/*
+	SIMD backend for ewMath.
+	Pick one at compile time with EW_SIMD_SCALAR, EW_SIMD_SSE2, EW_SIMD_AVX or EW_SIMD_NEON
+	(the EW_MATH_SIMD CMake option sets these). With none defined the best one the compiler targets is used.
+*/
+
+#pragma once
+
+#if !defined(EW_SIMD_SCALAR) && !defined(EW_SIMD_SSE2) && !defined(EW_SIMD_AVX) && !defined(EW_SIMD_NEON)
+#if defined(__AVX__)
+#define EW_SIMD_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define EW_SIMD_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define EW_SIMD_NEON
+#else
+#define EW_SIMD_SCALAR
+#endif
+#endif
+
+#if defined(EW_SIMD_AVX)
+#include <immintrin.h>
+#elif defined(EW_SIMD_SSE2)
+#include <emmintrin.h>
+#elif defined(EW_SIMD_NEON)
+#include <arm_neon.h>
+#endif
+#include <math.h>
+
+namespace ew {
+	namespace simd {
+		inline const char* BackendName() {
+#if defined(EW_SIMD_AVX)
+			return "AVX";
+#elif defined(EW_SIMD_SSE2)
+			return "SSE2";
+#elif defined(EW_SIMD_NEON)
+			return "NEON";
+#else
+			return "Scalar";
+#endif
+		}
+
+		//4 floats processed together. Loads and stores are unaligned so they are safe on any float array,
+		//they cost the same as aligned ones when the data is 16 byte aligned.
+#if defined(EW_SIMD_AVX) || defined(EW_SIMD_SSE2)
+		typedef __m128 float4;
+		inline float4 Load(const float* p) { return _mm_loadu_ps(p); }
+		inline void Store(float* p, float4 v) { _mm_storeu_ps(p, v); }
+		inline float4 Set1(float x) { return _mm_set1_ps(x); }
+		inline float4 Set(float x, float y, float z, float w) { return _mm_setr_ps(x, y, z, w); }
+		inline float4 Add(float4 a, float4 b) { return _mm_add_ps(a, b); }
+		inline float4 Sub(float4 a, float4 b) { return _mm_sub_ps(a, b); }
+		inline float4 Mul(float4 a, float4 b) { return _mm_mul_ps(a, b); }
+		inline float4 Min(float4 a, float4 b) { return _mm_min_ps(a, b); }
+		inline float4 Max(float4 a, float4 b) { return _mm_max_ps(a, b); }
+		inline float4 And(float4 a, float4 b) { return _mm_and_ps(a, b); }
+		inline float4 Or(float4 a, float4 b) { return _mm_or_ps(a, b); }
+		inline float4 CmpLt(float4 a, float4 b) { return _mm_cmplt_ps(a, b); }
+		//Bit i is set when lane i of a comparison result is true
+		inline int MoveMask(float4 cmp) { return _mm_movemask_ps(cmp); }
+		//Round to nearest integer. Valid for |x| < 2^31.
+		inline float4 Round(float4 x) { return _mm_cvtepi32_ps(_mm_cvtps_epi32(x)); }
+		template<int i> inline float4 Splat(float4 v) { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(i, i, i, i)); }
+		inline void Transpose(float4& a, float4& b, float4& c, float4& d) { _MM_TRANSPOSE4_PS(a, b, c, d); }
+#elif defined(EW_SIMD_NEON)
+		typedef float32x4_t float4;
+		inline float4 Load(const float* p) { return vld1q_f32(p); }
+		inline void Store(float* p, float4 v) { vst1q_f32(p, v); }
+		inline float4 Set1(float x) { return vdupq_n_f32(x); }
+		inline float4 Set(float x, float y, float z, float w) { float v[4] = { x, y, z, w }; return vld1q_f32(v); }
+		inline float4 Add(float4 a, float4 b) { return vaddq_f32(a, b); }
+		inline float4 Sub(float4 a, float4 b) { return vsubq_f32(a, b); }
+		inline float4 Mul(float4 a, float4 b) { return vmulq_f32(a, b); }
+		inline float4 Min(float4 a, float4 b) { return vminq_f32(a, b); }
+		inline float4 Max(float4 a, float4 b) { return vmaxq_f32(a, b); }
+		inline float4 And(float4 a, float4 b) { return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b))); }
+		inline float4 Or(float4 a, float4 b) { return vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b))); }
+		inline float4 CmpLt(float4 a, float4 b) { return vreinterpretq_f32_u32(vcltq_f32(a, b)); }
+		inline int MoveMask(float4 cmp) {
+			uint32x4_t bits = vshrq_n_u32(vreinterpretq_u32_f32(cmp), 31);
+			return (int)(vgetq_lane_u32(bits, 0) | (vgetq_lane_u32(bits, 1) << 1) | (vgetq_lane_u32(bits, 2) << 2) | (vgetq_lane_u32(bits, 3) << 3));
+		}
+#if defined(__aarch64__) || defined(_M_ARM64)
+		inline float4 Round(float4 x) { return vrndnq_f32(x); }
+#else
+		inline float4 Round(float4 x) {
+			float4 half = vreinterpretq_f32_u32(vorrq_u32(vandq_u32(vreinterpretq_u32_f32(x), vdupq_n_u32(0x80000000u)), vreinterpretq_u32_f32(vdupq_n_f32(0.5f))));
+			return vcvtq_f32_s32(vcvtq_s32_f32(vaddq_f32(x, half)));
+		}
+#endif
+		template<int i> inline float4 Splat(float4 v) { return vdupq_n_f32(vgetq_lane_f32(v, i)); }
+		inline void Transpose(float4& a, float4& b, float4& c, float4& d) {
+			float32x4x2_t ab = vtrnq_f32(a, b);
+			float32x4x2_t cd = vtrnq_f32(c, d);
+			a = vcombine_f32(vget_low_f32(ab.val[0]), vget_low_f32(cd.val[0]));
+			b = vcombine_f32(vget_low_f32(ab.val[1]), vget_low_f32(cd.val[1]));
+			c = vcombine_f32(vget_high_f32(ab.val[0]), vget_high_f32(cd.val[0]));
+			d = vcombine_f32(vget_high_f32(ab.val[1]), vget_high_f32(cd.val[1]));
+		}
+#else
+		struct float4 {
+			float v[4];
+		};
+		inline float4 Load(const float* p) { return float4{ { p[0], p[1], p[2], p[3] } }; }
+		inline void Store(float* p, float4 v) { p[0] = v.v[0]; p[1] = v.v[1]; p[2] = v.v[2]; p[3] = v.v[3]; }
+		inline float4 Set1(float x) { return float4{ { x, x, x, x } }; }
+		inline float4 Set(float x, float y, float z, float w) { return float4{ { x, y, z, w } }; }
+		inline float4 Add(float4 a, float4 b) { return float4{ { a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3] } }; }
+		inline float4 Sub(float4 a, float4 b) { return float4{ { a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3] } }; }
+		inline float4 Mul(float4 a, float4 b) { return float4{ { a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3] } }; }
+		inline float4 Min(float4 a, float4 b) { return float4{ { a.v[0] < b.v[0] ? a.v[0] : b.v[0], a.v[1] < b.v[1] ? a.v[1] : b.v[1], a.v[2] < b.v[2] ? a.v[2] : b.v[2], a.v[3] < b.v[3] ? a.v[3] : b.v[3] } }; }
+		inline float4 Max(float4 a, float4 b) { return float4{ { a.v[0] > b.v[0] ? a.v[0] : b.v[0], a.v[1] > b.v[1] ? a.v[1] : b.v[1], a.v[2] > b.v[2] ? a.v[2] : b.v[2], a.v[3] > b.v[3] ? a.v[3] : b.v[3] } }; }
+		//Comparison results are 1.0f for true and 0.0f for false in the scalar backend
+		inline float4 And(float4 a, float4 b) { return Mul(a, b); }
+		inline float4 Or(float4 a, float4 b) { return Max(a, b); }
+		inline float4 CmpLt(float4 a, float4 b) { return float4{ { a.v[0] < b.v[0] ? 1.0f : 0.0f, a.v[1] < b.v[1] ? 1.0f : 0.0f, a.v[2] < b.v[2] ? 1.0f : 0.0f, a.v[3] < b.v[3] ? 1.0f : 0.0f } }; }
+		inline int MoveMask(float4 cmp) { return (cmp.v[0] != 0.0f) | ((cmp.v[1] != 0.0f) << 1) | ((cmp.v[2] != 0.0f) << 2) | ((cmp.v[3] != 0.0f) << 3); }
+		inline float4 Round(float4 x) { return float4{ { floorf(x.v[0] + 0.5f), floorf(x.v[1] + 0.5f), floorf(x.v[2] + 0.5f), floorf(x.v[3] + 0.5f) } }; }
+		template<int i> inline float4 Splat(float4 v) { return Set1(v.v[i]); }
+		inline void Transpose(float4& a, float4& b, float4& c, float4& d) {
+			float4 t[4] = { a, b, c, d };
+			a = float4{ { t[0].v[0], t[1].v[0], t[2].v[0], t[3].v[0] } };
+			b = float4{ { t[0].v[1], t[1].v[1], t[2].v[1], t[3].v[1] } };
+			c = float4{ { t[0].v[2], t[1].v[2], t[2].v[2], t[3].v[2] } };
+			d = float4{ { t[0].v[3], t[1].v[3], t[2].v[3], t[3].v[3] } };
+		}
+#endif
+		//a * b + c. Kept as a separate multiply and add so every backend rounds the same way.
+		inline float4 MulAdd(float4 a, float4 b, float4 c) { return Add(Mul(a, b), c); }
+
+		/// <summary>
+		/// Sine and cosine of 4 angles (radians) at once. Cephes style minimax polynomials on [-PI/4, PI/4],
+		/// max error around 1e-7 for angles within a few thousand radians.
+		/// </summary>
+		inline void SinCos(float4 x, float4& sinOut, float4& cosOut) {
+			//Reduce to r in [-PI/4, PI/4] with x = j * PI/2 + r
+			float4 j = Round(Mul(x, Set1(0.636619772367581f)));
+			float4 r = Sub(x, Mul(j, Set1(1.5703125f)));
+			r = Sub(r, Mul(j, Set1(4.837512969970703125e-4f)));
+			r = Sub(r, Mul(j, Set1(7.54978995489188216e-8f)));
+			float4 r2 = Mul(r, r);
+
+			float4 s = MulAdd(r2, Set1(-1.9515295891e-4f), Set1(8.3321608736e-3f));
+			s = MulAdd(s, r2, Set1(-1.6666654611e-1f));
+			s = MulAdd(Mul(s, r2), r, r);
+
+			float4 c = MulAdd(r2, Set1(2.443315711809948e-5f), Set1(-1.388731625493765e-3f));
+			c = MulAdd(c, r2, Set1(4.166664568298827e-2f));
+			c = MulAdd(Mul(c, r2), r2, Sub(Set1(1.0f), Mul(r2, Set1(0.5f))));
+
+			//Quadrant q = j mod 4, then odd = q & 1 and high = q >> 1, all kept as 0/1 floats
+			float4 q = Sub(j, Mul(Set1(4.0f), Round(Sub(Mul(j, Set1(0.25f)), Set1(0.375f)))));
+			float4 high = Round(Sub(Mul(q, Set1(0.5f)), Set1(0.25f)));
+			float4 odd = Sub(q, Mul(high, Set1(2.0f)));
+			float4 cosNegative = Sub(Add(odd, high), Mul(Set1(2.0f), Mul(odd, high)));
+
+			float4 sinBase = MulAdd(odd, Sub(c, s), s);
+			float4 cosBase = MulAdd(odd, Sub(s, c), c);
+			sinOut = Mul(sinBase, Sub(Set1(1.0f), Mul(high, Set1(2.0f))));
+			cosOut = Mul(cosBase, Sub(Set1(1.0f), Mul(cosNegative, Set1(2.0f))));
+		}
+	}
+}
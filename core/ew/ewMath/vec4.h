@@ -7,7 +7,7 @@
 #include "vec3.h"
 
 namespace ew {
-	struct Vec4 {
+	struct alignas(16) Vec4 {
 		float x, y, z, w;
 
 		Vec4() :x(0), y(0), z(0), w(0) {};
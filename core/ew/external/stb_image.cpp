@@ -1,2 +1,16 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
+
+namespace ew {
+	//Not part of stb, which can set this thread's flip flag but not read it back. Used to put it back after a load.
+	void GetStbiFlipThread(int& flip, int& set)
+	{
+		flip = stbi__vertically_flip_on_load_local;
+		set = stbi__vertically_flip_on_load_set;
+	}
+	void RestoreStbiFlipThread(int flip, int set)
+	{
+		stbi__vertically_flip_on_load_local = flip;
+		stbi__vertically_flip_on_load_set = set;
+	}
+}
@@ -0,0 +1,111 @@
+#include "frustum.h"
+#include "ewMath/simd.h"
+
+namespace ew {
+	/// <summary>
+	/// Extracts the 6 clip planes from a view projection matrix (Gribb/Hartmann).
+	/// Pass camera.ProjectionMatrix() * camera.ViewMatrix() for world space planes.
+	/// </summary>
+	Frustum ExtractFrustum(const ew::Mat4& m)
+	{
+		//Mat4 is column major, so row r is m[0][r], m[1][r], m[2][r], m[3][r]
+		float rows[4][4];
+		for (int r = 0; r < 4; r++) {
+			for (int c = 0; c < 4; c++) {
+				rows[r][c] = m[c][r];
+			}
+		}
+		Frustum frustum;
+		for (int i = 0; i < 6; i++)
+		{
+			const float* row = rows[i / 2];
+			float sign = (i % 2 == 0) ? 1.0f : -1.0f;
+			ew::Vec3 normal = ew::Vec3(rows[3][0] + sign * row[0], rows[3][1] + sign * row[1], rows[3][2] + sign * row[2]);
+			float distance = rows[3][3] + sign * row[3];
+			float length = ew::Magnitude(normal);
+			frustum.planes[i].normal = normal / length;
+			frustum.planes[i].distance = distance / length;
+		}
+		return frustum;
+	}
+	bool SphereInFrustum(const Frustum& frustum, const ew::Vec3& center, float radius)
+	{
+		for (int i = 0; i < 6; i++)
+		{
+			if (ew::Dot(frustum.planes[i].normal, center) + frustum.planes[i].distance < -radius) {
+				return false;
+			}
+		}
+		return true;
+	}
+	bool AABBInFrustum(const Frustum& frustum, const ew::Vec3& min, const ew::Vec3& max)
+	{
+		for (int i = 0; i < 6; i++)
+		{
+			//Corner furthest along the plane normal
+			const ew::Vec3& n = frustum.planes[i].normal;
+			ew::Vec3 p = ew::Vec3(n.x >= 0 ? max.x : min.x, n.y >= 0 ? max.y : min.y, n.z >= 0 ? max.z : min.z);
+			if (ew::Dot(n, p) + frustum.planes[i].distance < 0) {
+				return false;
+			}
+		}
+		return true;
+	}
+	/// <summary>
+	/// Tests mesh bounds placed with a model matrix. The sphere is scaled by the largest axis scale.
+	/// </summary>
+	bool IsVisible(const Frustum& frustum, const Bounds& bounds, const ew::Mat4& model)
+	{
+		ew::Vec4 center = model * ew::Vec4(bounds.center.x, bounds.center.y, bounds.center.z, 1.0f);
+		float scaleX = ew::Magnitude(ew::Vec3(model[0][0], model[0][1], model[0][2]));
+		float scaleY = ew::Magnitude(ew::Vec3(model[1][0], model[1][1], model[1][2]));
+		float scaleZ = ew::Magnitude(ew::Vec3(model[2][0], model[2][1], model[2][2]));
+		float scale = fmaxf(scaleX, fmaxf(scaleY, scaleZ));
+		return SphereInFrustum(frustum, ew::Vec3(center.x, center.y, center.z), bounds.radius * scale);
+	}
+	/// <summary>
+	/// Tests count spheres stored as separate x, y, z, radius arrays, 4 at a time.
+	/// </summary>
+	/// <param name="visible">Receives 1 for each visible sphere, 0 otherwise</param>
+	CullStats CullSpheres(const Frustum& frustum, const float* x, const float* y, const float* z, const float* radius, int count, unsigned char* visible)
+	{
+		using namespace ew::simd;
+		CullStats stats;
+		float4 planeX[6], planeY[6], planeZ[6], planeD[6];
+		for (int p = 0; p < 6; p++)
+		{
+			planeX[p] = Set1(frustum.planes[p].normal.x);
+			planeY[p] = Set1(frustum.planes[p].normal.y);
+			planeZ[p] = Set1(frustum.planes[p].normal.z);
+			planeD[p] = Set1(frustum.planes[p].distance);
+		}
+		float4 zero = Set1(0.0f);
+		int i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			float4 px = Load(x + i);
+			float4 py = Load(y + i);
+			float4 pz = Load(z + i);
+			float4 negRadius = Sub(zero, Load(radius + i));
+			float4 outside = zero;
+			for (int p = 0; p < 6; p++)
+			{
+				float4 d = MulAdd(planeX[p], px, MulAdd(planeY[p], py, MulAdd(planeZ[p], pz, planeD[p])));
+				outside = Or(outside, CmpLt(d, negRadius));
+			}
+			int mask = MoveMask(outside);
+			for (int e = 0; e < 4; e++)
+			{
+				visible[i + e] = ((mask >> e) & 1) ? 0 : 1;
+			}
+			stats.visible += 4 - ((mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + ((mask >> 3) & 1));
+		}
+		for (; i < count; i++)
+		{
+			visible[i] = SphereInFrustum(frustum, ew::Vec3(x[i], y[i], z[i]), radius[i]) ? 1 : 0;
+			stats.visible += visible[i];
+		}
+		stats.culled = count - stats.visible;
+		return stats;
+	}
+}
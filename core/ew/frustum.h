@@ -0,0 +1,29 @@
+#pragma once
+#include "ewMath/ewMath.h"
+#include "mesh.h"
+
+namespace ew {
+	//Plane: dot(normal, p) + distance >= 0 inside
+	struct Plane {
+		ew::Vec3 normal;
+		float distance;
+	};
+
+	//Left, right, bottom, top, near, far. Normals point inward and are normalized.
+	struct Frustum {
+		Plane planes[6];
+	};
+
+	//Visible and culled counts for one or more culling passes
+	struct CullStats {
+		int visible = 0;
+		int culled = 0;
+		inline CullStats& operator+=(const CullStats& rhs) { visible += rhs.visible; culled += rhs.culled; return *this; }
+	};
+
+	Frustum ExtractFrustum(const ew::Mat4& viewProjection);
+	bool SphereInFrustum(const Frustum& frustum, const ew::Vec3& center, float radius);
+	bool AABBInFrustum(const Frustum& frustum, const ew::Vec3& min, const ew::Vec3& max);
+	bool IsVisible(const Frustum& frustum, const Bounds& bounds, const ew::Mat4& model);
+	CullStats CullSpheres(const Frustum& frustum, const float* x, const float* y, const float* z, const float* radius, int count, unsigned char* visible);
+}
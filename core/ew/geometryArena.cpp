@@ -0,0 +1,163 @@
+#include "geometryArena.h"
+#include "meshCache.h"
+#include "external/glad.h"
+#include "glState.h"
+#include <stdio.h>
+
+namespace ew {
+	/// <summary>
+	/// Allocates both buffers up front. They are immutable, so the capacities are final.
+	/// </summary>
+	/// <param name="vertexCapacity">Vertices across every mesh</param>
+	/// <param name="indexCapacity">Indices across every mesh, after strips are expanded to triangles</param>
+	GeometryArena::GeometryArena(int vertexCapacity, int indexCapacity, VertexFormat format, IndexType indexType)
+	{
+		m_format = format;
+		m_indexType = indexType;
+		m_vertexCapacity = vertexCapacity > 0 ? vertexCapacity : 1;
+		m_indexCapacity = indexCapacity > 0 ? indexCapacity : 1;
+
+		glGenVertexArrays(1, &m_vao);
+		GLState::bindVertexArray(m_vao);
+
+		glGenBuffers(1, &m_vbo);
+		glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+		glBufferStorage(GL_ARRAY_BUFFER, (GLsizeiptr)m_vertexCapacity * GetVertexSize(format), NULL, GL_DYNAMIC_STORAGE_BIT);
+
+		glGenBuffers(1, &m_ebo);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+		glBufferStorage(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)m_indexCapacity * GetIndexSize(indexType), NULL, GL_DYNAMIC_STORAGE_BIT);
+
+		SetupVertexFormat(format);
+		glBindVertexBuffer(0, m_vbo, 0, GetVertexSize(format));
+		GLState::bindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		glGenBuffers(1, &m_commandBuffer);
+		glGenBuffers(1, &m_drawDataBuffer);
+	}
+	/// <summary>
+	/// Copies meshData into the arena. Identical meshes are only stored once.
+	/// </summary>
+	/// <returns>Mesh id for addDraw and getBounds, or -1 if it doesn't fit</returns>
+	int GeometryArena::add(const MeshData& meshData)
+	{
+		unsigned long long hash = HashMeshData(meshData);
+		auto matches = m_meshByHash.equal_range(hash);
+		for (auto it = matches.first; it != matches.second; ++it) {
+			if (SameMeshData(it->second.meshData, meshData)) {
+				return it->second.id;
+			}
+		}
+		//One multi draw has one primitive mode
+		std::vector<unsigned int> triangleList;
+		const std::vector<unsigned int>* indices = &meshData.indices;
+		if (meshData.topology == Topology::TRIANGLE_STRIP) {
+			triangleList = TriangulateStrips(meshData.indices);
+			indices = &triangleList;
+		}
+		int numVertices = (int)meshData.vertices.size();
+		int numIndices = (int)indices->size();
+		if (m_numVertices + numVertices > m_vertexCapacity || m_numIndices + numIndices > m_indexCapacity) {
+			printf("GeometryArena is full, needs %d vertices and %d indices\n", m_numVertices + numVertices, m_numIndices + numIndices);
+			return -1;
+		}
+		if (m_indexType == IndexType::UINT16 && ChooseIndexType(numVertices) != IndexType::UINT16) {
+			printf("GeometryArena uses 16 bit indices, a mesh of %d vertices needs 32\n", numVertices);
+			return -1;
+		}
+
+		glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+		int vertexSize = GetVertexSize(m_format);
+		if (m_format == VertexFormat::COMPACT) {
+			std::vector<CompactVertex> compact(numVertices);
+			EncodeVertices(meshData.vertices.data(), numVertices, compact.data());
+			glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)m_numVertices * vertexSize, (GLsizeiptr)numVertices * vertexSize, compact.data());
+		}
+		else {
+			glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)m_numVertices * vertexSize, (GLsizeiptr)numVertices * vertexSize, meshData.vertices.data());
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		//The VAO owns the element binding, so bind it rather than touching whatever VAO is current
+		GLState::bindVertexArray(m_vao);
+		int indexSize = GetIndexSize(m_indexType);
+		if (m_indexType == IndexType::UINT16) {
+			std::vector<unsigned short> narrow(indices->begin(), indices->end());
+			glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, (GLintptr)m_numIndices * indexSize, (GLsizeiptr)numIndices * indexSize, narrow.data());
+		}
+		else {
+			glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, (GLintptr)m_numIndices * indexSize, (GLsizeiptr)numIndices * indexSize, indices->data());
+		}
+		GLState::bindVertexArray(0);
+
+		MeshRange range;
+		range.firstIndex = m_numIndices;
+		range.count = numIndices;
+		range.baseVertex = m_numVertices;
+		range.bounds = (meshData.bounds.radius > 0 || meshData.vertices.empty()) ? meshData.bounds : ComputeBounds(meshData.vertices);
+		m_meshes.push_back(range);
+		m_numVertices += numVertices;
+		m_numIndices += numIndices;
+
+		int id = (int)m_meshes.size() - 1;
+		m_meshByHash.insert({ hash, StoredMesh{ id, meshData } });
+		return id;
+	}
+	void GeometryArena::clearDraws()
+	{
+		m_commands.clear();
+		m_drawData.clear();
+	}
+	/// <summary>
+	/// Queues one draw of mesh for the next drawAll. Only touches CPU memory.
+	/// </summary>
+	/// <param name="color">Drawn unlit in this color when alpha > 0</param>
+	void GeometryArena::addDraw(int mesh, const ew::Mat4& model, const ew::Vec4& color)
+	{
+		if (mesh < 0 || mesh >= (int)m_meshes.size()) {
+			return;
+		}
+		const MeshRange& range = m_meshes[mesh];
+		DrawElementsIndirectCommand command;
+		command.count = range.count;
+		command.instanceCount = 1;
+		command.firstIndex = range.firstIndex;
+		command.baseVertex = range.baseVertex;
+		command.baseInstance = (unsigned int)m_commands.size();
+		m_commands.push_back(command);
+
+		IndirectDrawData data;
+		data.model = model;
+		data.color = color;
+		m_drawData.push_back(data);
+	}
+	/// <summary>
+	/// Uploads the queued commands and per draw data, then draws all of them with one glMultiDrawElementsIndirect.
+	/// Expects indirectLit.vert (or another shader reading DrawBlock with gl_DrawID) to be bound.
+	/// The queue is kept, so unchanged frames can call drawAll again without re-adding.
+	/// </summary>
+	void GeometryArena::drawAll()
+	{
+		if (m_commands.empty()) {
+			return;
+		}
+		int count = (int)m_commands.size();
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_drawDataBuffer);
+		if (count > m_commandCapacity) {
+			while (m_commandCapacity < count) {
+				m_commandCapacity = m_commandCapacity > 0 ? m_commandCapacity * 2 : 64;
+			}
+			glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(DrawElementsIndirectCommand) * m_commandCapacity, NULL, GL_DYNAMIC_DRAW);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(IndirectDrawData) * m_commandCapacity, NULL, GL_DYNAMIC_DRAW);
+		}
+		glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, sizeof(DrawElementsIndirectCommand) * count, m_commands.data());
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(IndirectDrawData) * count, m_drawData.data());
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_BLOCK_BINDING, m_drawDataBuffer);
+
+		GLState::bindVertexArray(m_vao);
+		glMultiDrawElementsIndirect(GL_TRIANGLES, GetIndexGLType(m_indexType), NULL, count, 0);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	}
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include "ewMath/ewMath.h"
+#include "mesh.h"
+
+namespace ew {
+	constexpr unsigned int DRAW_BLOCK_BINDING = 2; //layout(binding) of the DrawBlock shader storage block
+
+	//Layout glMultiDrawElementsIndirect reads from GL_DRAW_INDIRECT_BUFFER
+	struct DrawElementsIndirectCommand {
+		unsigned int count; //Indices
+		unsigned int instanceCount;
+		unsigned int firstIndex;
+		int baseVertex;
+		unsigned int baseInstance;
+	};
+
+	//std430 mirror of DrawData in indirectLit.vert, indexed by gl_DrawID
+	struct IndirectDrawData {
+		ew::Mat4 model;
+		ew::Vec4 color; //Unlit color when alpha > 0, otherwise the draw is lit
+	};
+
+	/// <summary>
+	/// Static meshes suballocated from one vertex buffer and one index buffer behind a single VAO.
+	/// Draws are queued on the CPU with addDraw and submitted together with one glMultiDrawElementsIndirect.
+	/// Every mesh uses the arena's vertex format, and indices are relative to the mesh (see baseVertex),
+	/// so 16 bit indices work for any mesh under 65536 vertices regardless of arena size.
+	/// </summary>
+	class GeometryArena {
+	public:
+		GeometryArena(int vertexCapacity, int indexCapacity, VertexFormat format = VertexFormat::COMPACT, IndexType indexType = IndexType::UINT16);
+		int add(const MeshData& meshData);
+		void clearDraws();
+		void addDraw(int mesh, const ew::Mat4& model, const ew::Vec4& color = ew::Vec4(0));
+		void drawAll();
+		inline const Bounds& getBounds(int mesh)const { return m_meshes[mesh].bounds; }
+		inline int getMeshCount()const { return (int)m_meshes.size(); }
+		inline int getDrawCount()const { return (int)m_commands.size(); }
+		inline int getVertexBufferSize()const { return m_numVertices * GetVertexSize(m_format); } //Bytes in use
+		inline int getIndexBufferSize()const { return m_numIndices * GetIndexSize(m_indexType); }
+	private:
+		struct MeshRange {
+			unsigned int firstIndex;
+			unsigned int count;
+			int baseVertex;
+			Bounds bounds;
+		};
+		unsigned int m_vao = 0;
+		unsigned int m_vbo = 0;
+		unsigned int m_ebo = 0;
+		unsigned int m_commandBuffer = 0;
+		unsigned int m_drawDataBuffer = 0;
+		int m_commandCapacity = 0; //Draws the GPU side buffers hold
+		VertexFormat m_format;
+		IndexType m_indexType;
+		int m_vertexCapacity = 0;
+		int m_indexCapacity = 0;
+		int m_numVertices = 0;
+		int m_numIndices = 0;
+		std::vector<MeshRange> m_meshes;
+		struct StoredMesh {
+			int id;
+			MeshData meshData; //CPU copy, so a hash collision can't alias two different meshes
+		};
+		std::unordered_multimap<unsigned long long, StoredMesh> m_meshByHash; //Identical MeshData is stored once, see HashMeshData
+		std::vector<DrawElementsIndirectCommand> m_commands;
+		std::vector<IndirectDrawData> m_drawData;
+	};
+}
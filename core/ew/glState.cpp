@@ -0,0 +1,219 @@
+#include "glState.h"
+#include "external/glad.h"
+
+namespace ew {
+	namespace {
+		const unsigned int UNKNOWN = 0xFFFFFFFF;
+		//Capabilities shadowed by setEnabled. Others go straight through.
+		const GLenum CAPABILITIES[] = { GL_BLEND, GL_DEPTH_TEST, GL_CULL_FACE, GL_SCISSOR_TEST, GL_PRIMITIVE_RESTART_FIXED_INDEX };
+		const int NUM_CAPABILITIES = sizeof(CAPABILITIES) / sizeof(CAPABILITIES[0]);
+		//Texture targets shadowed per unit
+		const GLenum TEXTURE_TARGETS[] = { GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY };
+		const int NUM_TEXTURE_TARGETS = sizeof(TEXTURE_TARGETS) / sizeof(TEXTURE_TARGETS[0]);
+
+		struct Shadow {
+			unsigned int program;
+			unsigned int vao;
+			unsigned int activeUnit;
+			unsigned int textures[GLState::MAX_TEXTURE_UNITS][NUM_TEXTURE_TARGETS];
+			int capabilities[NUM_CAPABILITIES]; //-1 unknown, otherwise 0 or 1
+			unsigned int blendSource;
+			unsigned int blendDestination;
+			int depthMask;
+			unsigned int cullFace;
+			int viewport[4];
+		};
+		Shadow shadow;
+		bool shadowValid = false;
+		bool debug = false;
+		GLStateCounters frame;
+		GLStateCounters lastFrame;
+
+		void reset() {
+			shadow.program = shadow.vao = shadow.activeUnit = UNKNOWN;
+			for (int unit = 0; unit < GLState::MAX_TEXTURE_UNITS; unit++) {
+				for (int target = 0; target < NUM_TEXTURE_TARGETS; target++) {
+					shadow.textures[unit][target] = UNKNOWN;
+				}
+			}
+			for (int i = 0; i < NUM_CAPABILITIES; i++) {
+				shadow.capabilities[i] = -1;
+			}
+			shadow.blendSource = shadow.blendDestination = UNKNOWN;
+			shadow.depthMask = -1;
+			shadow.cullFace = UNKNOWN;
+			shadow.viewport[0] = shadow.viewport[1] = shadow.viewport[2] = shadow.viewport[3] = -1;
+			shadowValid = true;
+		}
+		//Returns true when the call has to be issued, and counts it either way
+		inline bool changed(GLStateCall call, bool differs) {
+			if (!shadowValid) {
+				reset();
+				differs = true;
+			}
+			if (debug) {
+				(differs ? frame.issued : frame.skipped)[(int)call]++;
+			}
+			return differs;
+		}
+		int capabilityIndex(GLenum capability) {
+			for (int i = 0; i < NUM_CAPABILITIES; i++) {
+				if (CAPABILITIES[i] == capability) {
+					return i;
+				}
+			}
+			return -1;
+		}
+		int textureTargetIndex(GLenum target) {
+			for (int i = 0; i < NUM_TEXTURE_TARGETS; i++) {
+				if (TEXTURE_TARGETS[i] == target) {
+					return i;
+				}
+			}
+			return -1;
+		}
+	}
+
+	unsigned int GLStateCounters::totalIssued()const
+	{
+		unsigned int total = 0;
+		for (int i = 0; i < (int)GLStateCall::COUNT; i++) {
+			total += issued[i];
+		}
+		return total;
+	}
+	unsigned int GLStateCounters::totalSkipped()const
+	{
+		unsigned int total = 0;
+		for (int i = 0; i < (int)GLStateCall::COUNT; i++) {
+			total += skipped[i];
+		}
+		return total;
+	}
+
+	void GLState::useProgram(unsigned int program)
+	{
+		if (changed(GLStateCall::PROGRAM, shadow.program != program)) {
+			glUseProgram(program);
+			shadow.program = program;
+		}
+	}
+	void GLState::bindVertexArray(unsigned int vao)
+	{
+		if (changed(GLStateCall::VERTEX_ARRAY, shadow.vao != vao)) {
+			glBindVertexArray(vao);
+			shadow.vao = vao;
+		}
+	}
+	/// <summary>
+	/// Binds texture to target on unit. GL_TEXTURE_2D and GL_TEXTURE_2D_ARRAY are shadowed, other targets always bind.
+	/// </summary>
+	void GLState::bindTexture(unsigned int target, unsigned int texture, int unit)
+	{
+		int targetIndex = textureTargetIndex(target);
+		bool cached = targetIndex >= 0 && unit >= 0 && unit < MAX_TEXTURE_UNITS;
+		if (!changed(GLStateCall::TEXTURE, !cached || shadow.textures[unit][targetIndex] != texture)) {
+			return;
+		}
+		if (shadow.activeUnit != (unsigned int)unit) {
+			glActiveTexture(GL_TEXTURE0 + unit);
+			shadow.activeUnit = unit;
+		}
+		glBindTexture(target, texture);
+		if (cached) {
+			shadow.textures[unit][targetIndex] = texture;
+		}
+	}
+	/// <summary>
+	/// Deletes a texture. GL unbinds it from every unit, so the shadow does too, and a later texture reusing the name still binds.
+	/// </summary>
+	void GLState::deleteTexture(unsigned int texture)
+	{
+		if (texture == 0) {
+			return;
+		}
+		if (shadowValid) {
+			for (int unit = 0; unit < MAX_TEXTURE_UNITS; unit++) {
+				for (int target = 0; target < NUM_TEXTURE_TARGETS; target++) {
+					if (shadow.textures[unit][target] == texture) {
+						shadow.textures[unit][target] = 0;
+					}
+				}
+			}
+		}
+		glDeleteTextures(1, &texture);
+	}
+	void GLState::setEnabled(unsigned int capability, bool enabled)
+	{
+		int index = capabilityIndex(capability);
+		if (!changed(GLStateCall::CAPABILITY, index < 0 || shadow.capabilities[index] != (int)enabled)) {
+			return;
+		}
+		if (enabled) {
+			glEnable(capability);
+		}
+		else {
+			glDisable(capability);
+		}
+		if (index >= 0) {
+			shadow.capabilities[index] = enabled;
+		}
+	}
+	void GLState::blendFunc(unsigned int source, unsigned int destination)
+	{
+		if (changed(GLStateCall::BLEND_FUNC, shadow.blendSource != source || shadow.blendDestination != destination)) {
+			glBlendFunc(source, destination);
+			shadow.blendSource = source;
+			shadow.blendDestination = destination;
+		}
+	}
+	void GLState::depthMask(bool write)
+	{
+		if (changed(GLStateCall::DEPTH_MASK, shadow.depthMask != (int)write)) {
+			glDepthMask(write ? GL_TRUE : GL_FALSE);
+			shadow.depthMask = write;
+		}
+	}
+	void GLState::cullFace(unsigned int face)
+	{
+		if (changed(GLStateCall::CULL_FACE, shadow.cullFace != face)) {
+			glCullFace(face);
+			shadow.cullFace = face;
+		}
+	}
+	void GLState::viewport(int x, int y, int width, int height)
+	{
+		bool differs = shadow.viewport[0] != x || shadow.viewport[1] != y || shadow.viewport[2] != width || shadow.viewport[3] != height;
+		if (changed(GLStateCall::VIEWPORT, differs)) {
+			glViewport(x, y, width, height);
+			shadow.viewport[0] = x;
+			shadow.viewport[1] = y;
+			shadow.viewport[2] = width;
+			shadow.viewport[3] = height;
+		}
+	}
+	/// <summary>
+	/// Forgets the shadow, so the next call of each kind is issued
+	/// </summary>
+	void GLState::invalidate()
+	{
+		shadowValid = false;
+	}
+	void GLState::setDebug(bool enabled)
+	{
+		debug = enabled;
+	}
+	bool GLState::getDebug()
+	{
+		return debug;
+	}
+	void GLState::beginFrame()
+	{
+		lastFrame = frame;
+		frame = GLStateCounters();
+	}
+	const GLStateCounters& GLState::getLastFrame()
+	{
+		return lastFrame;
+	}
+}
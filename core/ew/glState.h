@@ -0,0 +1,50 @@
+#pragma once
+
+namespace ew {
+	enum class GLStateCall {
+		PROGRAM = 0,
+		VERTEX_ARRAY,
+		TEXTURE,
+		CAPABILITY, //glEnable / glDisable
+		BLEND_FUNC,
+		DEPTH_MASK,
+		CULL_FACE,
+		VIEWPORT,
+		COUNT
+	};
+
+	struct GLStateCounters {
+		unsigned int issued[(int)GLStateCall::COUNT] = {};
+		unsigned int skipped[(int)GLStateCall::COUNT] = {};
+		unsigned int totalIssued()const;
+		unsigned int totalSkipped()const;
+	};
+
+	/// <summary>
+	/// Shadow copy of the GL state the renderer touches. Each setter only calls GL when the value changes.
+	/// Everything that binds programs, vertex arrays or textures should go through here, or the shadow goes stale;
+	/// call invalidate() after code that doesn't (third party renderers that don't restore state).
+	/// Single context, main thread only.
+	/// </summary>
+	class GLState {
+	public:
+		static constexpr int MAX_TEXTURE_UNITS = 16;
+
+		static void useProgram(unsigned int program);
+		static void bindVertexArray(unsigned int vao);
+		static void bindTexture(unsigned int target, unsigned int texture, int unit = 0);
+		static void deleteTexture(unsigned int texture); //Use instead of glDeleteTextures, which unbinds it behind the shadow's back
+		static void setEnabled(unsigned int capability, bool enabled);
+		static void blendFunc(unsigned int source, unsigned int destination);
+		static void depthMask(bool write);
+		static void cullFace(unsigned int face);
+		static void viewport(int x, int y, int width, int height);
+		static void invalidate();
+
+		//Debug counters. Off by default so release frames don't pay for them.
+		static void setDebug(bool debug);
+		static bool getDebug();
+		static void beginFrame(); //Moves this frame's counters to getLastFrame() and starts again
+		static const GLStateCounters& getLastFrame();
+	};
+}
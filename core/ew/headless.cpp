@@ -0,0 +1,341 @@
+#include "headless.h"
+#include "glState.h"
+#include "external/glad.h"
+#include <GLFW/glfw3.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <algorithm>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+namespace ew {
+	namespace {
+		double nowMs() {
+			return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now().time_since_epoch()).count();
+		}
+		void makeDirectory(const char* path) {
+#ifdef _WIN32
+			_mkdir(path);
+#else
+			mkdir(path, 0755);
+#endif
+		}
+		void printUsage() {
+			printf("Options: --headless --frames N [--size WxH] [--dump dir] [--dump-every N] [--timings file.csv] [--trace file.json] [--dt seconds] [--scene name]\n");
+		}
+	}
+
+	/// <summary>
+	/// Reads the headless flags. Anything it doesn't know is an error, so typos don't silently open a window.
+	/// </summary>
+	/// <returns>False, after printing usage, if the command line is invalid</returns>
+	bool ParseHeadlessOptions(int argc, char** argv, HeadlessOptions& options)
+	{
+		for (int i = 1; i < argc; i++) {
+			const char* arg = argv[i];
+			const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+			if (strcmp(arg, "--headless") == 0) {
+				options.enabled = true;
+				continue;
+			}
+			if (value == nullptr) {
+				printf("Unknown option or missing value: %s\n", arg);
+				printUsage();
+				return false;
+			}
+			if (strcmp(arg, "--frames") == 0) {
+				options.frames = atoi(value);
+			}
+			else if (strcmp(arg, "--size") == 0) {
+				if (sscanf(value, "%dx%d", &options.width, &options.height) != 2) {
+					printf("--size expects WxH, got %s\n", value);
+					return false;
+				}
+			}
+			else if (strcmp(arg, "--dump") == 0) {
+				options.dumpDirectory = value;
+			}
+			else if (strcmp(arg, "--dump-every") == 0) {
+				options.dumpInterval = atoi(value);
+			}
+			else if (strcmp(arg, "--timings") == 0) {
+				options.timingsPath = value;
+			}
+			else if (strcmp(arg, "--trace") == 0) {
+				options.tracePath = value;
+			}
+			else if (strcmp(arg, "--scene") == 0) {
+				options.scene = value;
+			}
+			else if (strcmp(arg, "--dt") == 0) {
+				options.deltaTime = (float)atof(value);
+			}
+			else {
+				printf("Unknown option %s\n", arg);
+				printUsage();
+				return false;
+			}
+			i++;
+		}
+		if (options.frames <= 0 || options.width <= 0 || options.height <= 0 || options.dumpInterval <= 0) {
+			printf("--frames, --size and --dump-every must be positive\n");
+			return false;
+		}
+		return true;
+	}
+	/// <summary>
+	/// Initializes GLFW and creates a hidden window whose context needs no display. Tries GLFW's null platform with a
+	/// surfaceless EGL context, then OSMesa (both work on Mesa llvmpipe), then an invisible window on the desktop.
+	/// </summary>
+	/// <returns>The window, or NULL with GLFW terminated</returns>
+	GLFWwindow* CreateHeadlessWindow(int width, int height)
+	{
+		const int contextApis[] = { GLFW_EGL_CONTEXT_API, GLFW_OSMESA_CONTEXT_API };
+		glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+		if (glfwInit()) {
+			for (int i = 0; i < 2; i++) {
+				glfwDefaultWindowHints();
+				glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+				glfwWindowHint(GLFW_CONTEXT_CREATION_API, contextApis[i]);
+				GLFWwindow* window = glfwCreateWindow(width, height, "Headless", NULL, NULL);
+				if (window != NULL) {
+					return window;
+				}
+			}
+			glfwTerminate();
+		}
+		glfwInitHint(GLFW_PLATFORM, GLFW_ANY_PLATFORM);
+		if (!glfwInit()) {
+			printf("GLFW failed to init!\n");
+			return NULL;
+		}
+		glfwDefaultWindowHints();
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		GLFWwindow* window = glfwCreateWindow(width, height, "Headless", NULL, NULL);
+		if (window == NULL) {
+			printf("GLFW failed to create a headless context\n");
+			glfwTerminate();
+		}
+		return window;
+	}
+
+	HeadlessTarget::HeadlessTarget(int width, int height)
+	{
+		m_width = width;
+		m_height = height;
+		glGenRenderbuffers(1, &m_color);
+		glBindRenderbuffer(GL_RENDERBUFFER, m_color);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+		glGenRenderbuffers(1, &m_depth);
+		glBindRenderbuffer(GL_RENDERBUFFER, m_depth);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+		glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+		glGenFramebuffers(1, &m_fbo);
+		glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_color);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depth);
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+			printf("Headless framebuffer is incomplete\n");
+		}
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+	HeadlessTarget::~HeadlessTarget()
+	{
+		glDeleteFramebuffers(1, &m_fbo);
+		glDeleteRenderbuffers(1, &m_color);
+		glDeleteRenderbuffers(1, &m_depth);
+	}
+	/// <summary>
+	/// Draws go here until another framebuffer is bound. Also sets the viewport to cover it.
+	/// </summary>
+	void HeadlessTarget::bind()
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+		GLState::viewport(0, 0, m_width, m_height);
+	}
+	/// <summary>
+	/// Reads the color buffer back and writes it as a binary PPM. Blocks until the frame is finished.
+	/// The directory is created if it doesn't exist (one level only).
+	/// </summary>
+	bool HeadlessTarget::dumpFrame(const char* filePath)
+	{
+		std::vector<unsigned char> pixels((size_t)m_width * m_height * 3);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, m_fbo);
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glReadPixels(0, 0, m_width, m_height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+		glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+		std::string path = filePath;
+		size_t slash = path.find_last_of("/\\");
+		if (slash != std::string::npos) {
+			makeDirectory(path.substr(0, slash).c_str());
+		}
+		FILE* f = fopen(filePath, "wb");
+		if (f == NULL) {
+			printf("Failed to open %s for writing\n", filePath);
+			return false;
+		}
+		fprintf(f, "P6\n%d %d\n255\n", m_width, m_height);
+		//GL rows start at the bottom, PPM rows at the top
+		size_t rowBytes = (size_t)m_width * 3;
+		for (int y = m_height - 1; y >= 0; y--) {
+			fwrite(pixels.data() + rowBytes * y, 1, rowBytes, f);
+		}
+		fclose(f);
+		return true;
+	}
+
+	FrameTimer::FrameTimer()
+	{
+		glGenQueries(FRAME_TIMER_LATENCY, m_queries);
+		for (int i = 0; i < FRAME_TIMER_LATENCY; i++) {
+			m_pending[i] = -1;
+		}
+	}
+	FrameTimer::~FrameTimer()
+	{
+		glDeleteQueries(FRAME_TIMER_LATENCY, m_queries);
+	}
+	void FrameTimer::collect(int slot)
+	{
+		if (m_pending[slot] < 0) {
+			return;
+		}
+		GLuint64 elapsedNs = 0;
+		glGetQueryObjectui64v(m_queries[slot], GL_QUERY_RESULT, &elapsedNs);
+		m_timings[m_pending[slot]].gpuMs = elapsedNs / 1e6;
+		m_pending[slot] = -1;
+	}
+	void FrameTimer::beginFrame()
+	{
+		int frame = (int)m_timings.size();
+		int slot = frame % FRAME_TIMER_LATENCY;
+		//The query from FRAME_TIMER_LATENCY frames ago is almost certainly done by now
+		collect(slot);
+		FrameTiming timing;
+		timing.frame = frame;
+		timing.gpuMs = -1;
+		m_timings.push_back(timing);
+		m_pending[slot] = frame;
+		glBeginQuery(GL_TIME_ELAPSED, m_queries[slot]);
+		m_cpuStart = nowMs();
+	}
+	void FrameTimer::endFrame()
+	{
+		m_timings.back().cpuMs = nowMs() - m_cpuStart;
+		glEndQuery(GL_TIME_ELAPSED);
+	}
+	void FrameTimer::finish()
+	{
+		for (int i = 0; i < FRAME_TIMER_LATENCY; i++) {
+			collect(i);
+		}
+	}
+	/// <summary>
+	/// One header line, then frame,cpu_ms,gpu_ms per frame. Call finish() first or the last GPU times are -1.
+	/// </summary>
+	bool FrameTimer::writeCSV(const char* filePath)const
+	{
+		bool toStdout = filePath == nullptr || filePath[0] == '\0';
+		FILE* f = toStdout ? stdout : fopen(filePath, "w");
+		if (f == NULL) {
+			printf("Failed to open %s for writing\n", filePath);
+			return false;
+		}
+		//Start on a fresh line, the executables print progress without newlines
+		fprintf(f, toStdout ? "\nframe,cpu_ms,gpu_ms\n" : "frame,cpu_ms,gpu_ms\n");
+		for (size_t i = 0; i < m_timings.size(); i++) {
+			fprintf(f, "%d,%.4f,%.4f\n", m_timings[i].frame, m_timings[i].cpuMs, m_timings[i].gpuMs);
+		}
+		if (!toStdout) {
+			fclose(f);
+		}
+		return true;
+	}
+	void FrameTimer::printSummary()const
+	{
+		if (m_timings.empty()) {
+			return;
+		}
+		std::vector<double> cpu, gpu;
+		for (size_t i = 0; i < m_timings.size(); i++) {
+			cpu.push_back(m_timings[i].cpuMs);
+			if (m_timings[i].gpuMs >= 0) {
+				gpu.push_back(m_timings[i].gpuMs);
+			}
+		}
+		auto report = [](const char* name, std::vector<double>& times) {
+			if (times.empty()) {
+				return;
+			}
+			double total = 0;
+			for (size_t i = 0; i < times.size(); i++) {
+				total += times[i];
+			}
+			std::sort(times.begin(), times.end());
+			printf("%s ms: mean %.3f, median %.3f, max %.3f\n", name, total / times.size(), times[times.size() / 2], times.back());
+		};
+		printf("\n%d frames\n", (int)m_timings.size());
+		report("CPU", cpu);
+		report("GPU", gpu);
+	}
+
+	HeadlessRun::HeadlessRun(const HeadlessOptions& options)
+	{
+		m_options = options;
+		if (options.enabled) {
+			m_target.reset(new HeadlessTarget(options.width, options.height));
+			m_timer.reset(new FrameTimer());
+		}
+	}
+	bool HeadlessRun::isRunning(GLFWwindow* window)const
+	{
+		return m_options.enabled ? m_frame < m_options.frames : !glfwWindowShouldClose(window);
+	}
+	float HeadlessRun::getTime()const
+	{
+		return m_options.enabled ? m_frame * m_options.deltaTime : (float)glfwGetTime();
+	}
+	void HeadlessRun::beginFrame()
+	{
+		if (!m_options.enabled) {
+			return;
+		}
+		m_target->bind();
+		m_timer->beginFrame();
+	}
+	void HeadlessRun::endFrame(GLFWwindow* window)
+	{
+		if (!m_options.enabled) {
+			glfwSwapBuffers(window);
+			return;
+		}
+		m_timer->endFrame();
+		if (!m_options.dumpDirectory.empty() && m_frame % m_options.dumpInterval == 0) {
+			char path[512];
+			snprintf(path, sizeof(path), "%s/frame_%05d.ppm", m_options.dumpDirectory.c_str(), m_frame);
+			m_target->dumpFrame(path);
+		}
+		m_frame++;
+	}
+	/// <summary>
+	/// Writes the timings once the loop is done. Does nothing for interactive runs.
+	/// </summary>
+	void HeadlessRun::finish()
+	{
+		if (!m_options.enabled) {
+			return;
+		}
+		m_timer->finish();
+		m_timer->writeCSV(m_options.timingsPath.c_str());
+		if (!m_options.timingsPath.empty()) {
+			m_timer->printSummary();
+		}
+	}
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+
+struct GLFWwindow;
+
+namespace ew {
+	constexpr int FRAME_TIMER_LATENCY = 4; //Frames a GPU timer query gets before its result is read
+
+	//Batch performance runs: --headless --frames N [--size WxH] [--dump dir] [--dump-every N] [--timings file.csv] [--trace file.json] [--dt seconds] [--scene name]
+	struct HeadlessOptions {
+		bool enabled = false;
+		int frames = 300;
+		int width = 1080;
+		int height = 720;
+		std::string dumpDirectory; //Frames are written here as PPM, empty disables dumps
+		int dumpInterval = 1; //Dump every Nth frame
+		std::string timingsPath; //CSV of per frame timings, empty prints it to stdout
+		std::string tracePath; //Chrome trace from the executable's ew::Profiler, empty skips it
+		float deltaTime = 1.0f / 60.0f; //Fixed step instead of wall time, so runs are repeatable
+		std::string scene; //Generated benchmark scene, see ew::GetScenePath. Also works without --headless.
+	};
+
+	bool ParseHeadlessOptions(int argc, char** argv, HeadlessOptions& options);
+	GLFWwindow* CreateHeadlessWindow(int width, int height);
+
+	/// <summary>
+	/// Offscreen color and depth target. Headless contexts may have no default framebuffer at all.
+	/// </summary>
+	class HeadlessTarget {
+	public:
+		HeadlessTarget(int width, int height);
+		~HeadlessTarget();
+		HeadlessTarget(const HeadlessTarget&) = delete;
+		HeadlessTarget& operator=(const HeadlessTarget&) = delete;
+		void bind();
+		bool dumpFrame(const char* filePath);
+		inline int getWidth()const { return m_width; }
+		inline int getHeight()const { return m_height; }
+	private:
+		int m_width;
+		int m_height;
+		unsigned int m_fbo = 0;
+		unsigned int m_color = 0;
+		unsigned int m_depth = 0;
+	};
+
+	struct FrameTiming {
+		int frame = 0;
+		double cpuMs = 0; //beginFrame to endFrame on the calling thread
+		double gpuMs = 0; //GL_TIME_ELAPSED between the same two points, -1 if the query failed
+	};
+
+	/// <summary>
+	/// Per frame CPU and GPU times. GPU queries rotate through FRAME_TIMER_LATENCY slots and are read
+	/// a few frames late, so measuring doesn't stall the pipeline.
+	/// </summary>
+	class FrameTimer {
+	public:
+		FrameTimer();
+		~FrameTimer();
+		FrameTimer(const FrameTimer&) = delete;
+		FrameTimer& operator=(const FrameTimer&) = delete;
+		void beginFrame();
+		void endFrame();
+		void finish(); //Waits for the outstanding queries
+		bool writeCSV(const char* filePath)const; //nullptr or "" writes to stdout
+		void printSummary()const;
+		inline const std::vector<FrameTiming>& getTimings()const { return m_timings; }
+	private:
+		void collect(int slot);
+		unsigned int m_queries[FRAME_TIMER_LATENCY] = {};
+		int m_pending[FRAME_TIMER_LATENCY]; //Index into m_timings waiting on each query, -1 if none
+		double m_cpuStart = 0;
+		std::vector<FrameTiming> m_timings;
+	};
+
+	/// <summary>
+	/// Drives a main loop either way: interactive runs poll the window and swap, headless runs render a fixed
+	/// number of frames into a HeadlessTarget on a fixed time step, time them and optionally dump them.
+	/// </summary>
+	class HeadlessRun {
+	public:
+		HeadlessRun(const HeadlessOptions& options);
+		bool isRunning(GLFWwindow* window)const;
+		float getTime()const;
+		void beginFrame();
+		void endFrame(GLFWwindow* window); //Swaps buffers when interactive
+		void finish();
+		inline bool isHeadless()const { return m_options.enabled; }
+	private:
+		HeadlessOptions m_options;
+		int m_frame = 0;
+		std::unique_ptr<HeadlessTarget> m_target;
+		std::unique_ptr<FrameTimer> m_timer;
+	};
+}
@@ -0,0 +1,211 @@
+#include "lightClusters.h"
+#include "external/glad.h"
+#include <math.h>
+#include <chrono>
+
+namespace ew {
+	namespace {
+		constexpr int NUM_CLUSTERS = CLUSTER_GRID_X * CLUSTER_GRID_Y * CLUSTER_GRID_Z;
+
+		//NDC coordinate in [-1, 1] to a tile index in [0, tiles)
+		int ndcToTile(float ndc, int tiles) {
+			int tile = (int)floorf((ndc * 0.5f + 0.5f) * tiles);
+			return tile < 0 ? 0 : (tile >= tiles ? tiles - 1 : tile);
+		}
+	}
+
+	LightClusters::LightClusters()
+	{
+		glGenBuffers(1, &m_ubo);
+		glBindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(ClusterBlock), NULL, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+		glGenBuffers(1, &m_clusterBuffer);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_clusterBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(unsigned int) * 2 * NUM_CLUSTERS, NULL, GL_DYNAMIC_DRAW);
+		glGenBuffers(1, &m_indexBuffer);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+		m_clusters.assign(NUM_CLUSTERS * 2, 0);
+	}
+	LightClusters::~LightClusters()
+	{
+		glDeleteBuffers(1, &m_ubo);
+		glDeleteBuffers(1, &m_clusterBuffer);
+		glDeleteBuffers(1, &m_indexBuffer);
+	}
+	int LightClusters::depthSlice(float depth, float nearPlane, float sliceScale)const
+	{
+		if (depth <= nearPlane) {
+			return 0;
+		}
+		int slice = (int)(logf(depth / nearPlane) * sliceScale);
+		return slice >= CLUSTER_GRID_Z ? CLUSTER_GRID_Z - 1 : slice;
+	}
+	/// <summary>
+	/// Clusters a light's bounding sphere touches, from its view space bounding box.
+	/// </summary>
+	/// <returns>False if the light can't reach the view volume</returns>
+	bool LightClusters::getRange(const LightData& light, const ew::Mat4& view, const ew::Mat4& projection, float nearPlane, float farPlane, LightRange& range)const
+	{
+		range.minX = range.minY = range.minZ = 0;
+		range.maxX = CLUSTER_GRID_X - 1;
+		range.maxY = CLUSTER_GRID_Y - 1;
+		range.maxZ = CLUSTER_GRID_Z - 1;
+		if (light.radius <= 0.0f) {
+			return true;
+		}
+		ew::Vec4 center = view * ew::Vec4(light.position, 1.0f);
+		float radius = light.radius;
+		float depth = -center.z;
+		if (depth + radius < nearPlane || depth - radius > farPlane) {
+			return false;
+		}
+		float sliceScale = m_block.depth[2];
+		range.minZ = depthSlice(depth - radius, nearPlane, sliceScale);
+		range.maxZ = depthSlice(depth + radius, nearPlane, sliceScale);
+
+		//Project the box corners. A box reaching behind the eye could land anywhere on screen.
+		float minX = 1e30f, minY = 1e30f, maxX = -1e30f, maxY = -1e30f;
+		for (int i = 0; i < 8; i++) {
+			ew::Vec4 corner(center.x + ((i & 1) ? radius : -radius), center.y + ((i & 2) ? radius : -radius), center.z + ((i & 4) ? radius : -radius), 1.0f);
+			ew::Vec4 clip = projection * corner;
+			if (clip.w <= 1e-5f) {
+				return true;
+			}
+			float x = clip.x / clip.w;
+			float y = clip.y / clip.w;
+			minX = x < minX ? x : minX;
+			maxX = x > maxX ? x : maxX;
+			minY = y < minY ? y : minY;
+			maxY = y > maxY ? y : maxY;
+		}
+		if (maxX < -1.0f || minX > 1.0f || maxY < -1.0f || minY > 1.0f) {
+			return false;
+		}
+		range.minX = ndcToTile(minX, CLUSTER_GRID_X);
+		range.maxX = ndcToTile(maxX, CLUSTER_GRID_X);
+		range.minY = ndcToTile(minY, CLUSTER_GRID_Y);
+		range.maxY = ndcToTile(maxY, CLUSTER_GRID_Y);
+		return true;
+	}
+	/// <summary>
+	/// Bins the lights for this frame's camera. Call after the lights and camera are final, then bind().
+	/// </summary>
+	/// <param name="lights">Same order as the LightBuffer, see LightingUniforms::getLights</param>
+	void LightClusters::build(const LightData* lights, int numLights, const Camera& camera, int viewportWidth, int viewportHeight)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		m_stats = LightClusterStats();
+		m_stats.lights = numLights;
+
+		float nearPlane = camera.nearPlane > 0.01f ? camera.nearPlane : 0.01f;
+		float farPlane = camera.farPlane > nearPlane * 1.01f ? camera.farPlane : nearPlane * 1.01f;
+		ew::Mat4 view = camera.ViewMatrix();
+		ew::Mat4 projection = camera.ProjectionMatrix();
+		m_block.view = view;
+		m_block.grid[0] = CLUSTER_GRID_X;
+		m_block.grid[1] = CLUSTER_GRID_Y;
+		m_block.grid[2] = CLUSTER_GRID_Z;
+		m_block.grid[3] = numLights;
+		m_block.depth[0] = nearPlane;
+		m_block.depth[1] = farPlane;
+		m_block.depth[2] = CLUSTER_GRID_Z / logf(farPlane / nearPlane);
+		m_block.depth[3] = 0.0f;
+		m_block.tileSize[0] = viewportWidth / (float)CLUSTER_GRID_X;
+		m_block.tileSize[1] = viewportHeight / (float)CLUSTER_GRID_Y;
+		m_block.tileSize[2] = m_block.tileSize[3] = 0.0f;
+
+		//Lights that reach everything go first, so a full cluster drops local lights instead
+		m_ranges.clear();
+		for (int pass = 0; pass < 2; pass++) {
+			for (int i = 0; i < numLights; i++) {
+				if ((lights[i].radius <= 0.0f) != (pass == 0)) {
+					continue;
+				}
+				LightRange range;
+				range.light = i;
+				if (getRange(lights[i], view, projection, nearPlane, farPlane, range)) {
+					m_ranges.push_back(range);
+				}
+				else {
+					m_stats.culledLights++;
+				}
+			}
+		}
+
+		//Count, then prefix sum into offsets, then fill in the same order so the cap keeps the same lights
+		for (int c = 0; c < NUM_CLUSTERS; c++) {
+			m_clusters[c * 2 + 1] = 0;
+		}
+		for (const LightRange& range : m_ranges) {
+			for (int z = range.minZ; z <= range.maxZ; z++) {
+				for (int y = range.minY; y <= range.maxY; y++) {
+					for (int x = range.minX; x <= range.maxX; x++) {
+						unsigned int& count = m_clusters[((z * CLUSTER_GRID_Y + y) * CLUSTER_GRID_X + x) * 2 + 1];
+						if (count < MAX_LIGHTS_PER_CLUSTER) {
+							count++;
+						}
+						else {
+							m_stats.dropped++;
+						}
+					}
+				}
+			}
+		}
+		unsigned int offset = 0;
+		for (int c = 0; c < NUM_CLUSTERS; c++) {
+			unsigned int count = m_clusters[c * 2 + 1];
+			m_clusters[c * 2] = offset;
+			offset += count;
+			m_stats.maxPerCluster = (int)count > m_stats.maxPerCluster ? (int)count : m_stats.maxPerCluster;
+			//Counts become fill cursors and end up back where they started
+			m_clusters[c * 2 + 1] = 0;
+		}
+		m_indices.resize(offset);
+		m_stats.indices = (int)offset;
+		for (const LightRange& range : m_ranges) {
+			for (int z = range.minZ; z <= range.maxZ; z++) {
+				for (int y = range.minY; y <= range.maxY; y++) {
+					for (int x = range.minX; x <= range.maxX; x++) {
+						int c = (z * CLUSTER_GRID_Y + y) * CLUSTER_GRID_X + x;
+						unsigned int& count = m_clusters[c * 2 + 1];
+						if (count < MAX_LIGHTS_PER_CLUSTER) {
+							m_indices[m_clusters[c * 2] + count] = range.light;
+							count++;
+						}
+					}
+				}
+			}
+		}
+		m_stats.buildMs = (float)std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+	/// <summary>
+	/// Uploads the last build() and binds ClusterBlock, ClusterBuffer and LightIndexBuffer
+	/// </summary>
+	void LightClusters::bind()
+	{
+		glBindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(ClusterBlock), &m_block);
+		glBindBufferBase(GL_UNIFORM_BUFFER, CLUSTER_BLOCK_BINDING, m_ubo);
+
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_clusterBuffer);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(unsigned int) * m_clusters.size(), m_clusters.data());
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CLUSTER_BUFFER_BINDING, m_clusterBuffer);
+
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_indexBuffer);
+		int numIndices = (int)m_indices.size();
+		if (numIndices > m_indexCapacity || m_indexCapacity == 0) {
+			while (m_indexCapacity < numIndices || m_indexCapacity == 0) {
+				m_indexCapacity = m_indexCapacity > 0 ? m_indexCapacity * 2 : 1024;
+			}
+			glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(unsigned int) * m_indexCapacity, NULL, GL_DYNAMIC_DRAW);
+		}
+		if (numIndices > 0) {
+			glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(unsigned int) * numIndices, m_indices.data());
+		}
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_INDEX_BUFFER_BINDING, m_indexBuffer);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <vector>
+#include "ewMath/ewMath.h"
+#include "camera.h"
+#include "lightingUniforms.h"
+
+namespace ew {
+	constexpr int CLUSTER_GRID_X = 16; //Screen tiles across
+	constexpr int CLUSTER_GRID_Y = 9; //Screen tiles down
+	constexpr int CLUSTER_GRID_Z = 24; //Depth slices, logarithmic between the near and far planes
+	constexpr int MAX_LIGHTS_PER_CLUSTER = 128; //Caps a fragment's light loop. Lights with radius 0 fill a cluster first.
+	constexpr unsigned int CLUSTER_BLOCK_BINDING = 2; //layout(binding) of the ClusterBlock uniform block
+	constexpr unsigned int CLUSTER_BUFFER_BINDING = 4; //layout(binding) of the ClusterBuffer shader storage block
+	constexpr unsigned int LIGHT_INDEX_BUFFER_BINDING = 5; //layout(binding) of the LightIndexBuffer shader storage block
+
+	//std140 mirror of the ClusterBlock uniform block
+	struct ClusterBlock {
+		ew::Mat4 view; //World to view space, for the fragment's depth
+		unsigned int grid[4]; //Clusters in x, y and z, and the number of lights
+		float depth[4]; //Near plane, far plane, slices / log(far / near)
+		float tileSize[4]; //Pixels per cluster in x and y
+	};
+
+	struct LightClusterStats {
+		int lights = 0;
+		int culledLights = 0; //Outside the view volume, in no cluster
+		int indices = 0; //Entries in the light index buffer
+		int maxPerCluster = 0;
+		int dropped = 0; //Light/cluster pairs over MAX_LIGHTS_PER_CLUSTER
+		float buildMs = 0;
+	};
+
+	/// <summary>
+	/// Clustered forward lighting. Splits the view volume into a CLUSTER_GRID_X * CLUSTER_GRID_Y * CLUSTER_GRID_Z grid of
+	/// froxels, bins each light's bounding sphere into the froxels it touches on the CPU, and uploads an offset and count
+	/// per cluster plus one flat list of light indices. Lit fragment shaders find their cluster from gl_FragCoord and
+	/// view depth, and only loop over that cluster's lights.
+	/// </summary>
+	class LightClusters {
+	public:
+		LightClusters();
+		~LightClusters();
+		LightClusters(const LightClusters&) = delete;
+		LightClusters& operator=(const LightClusters&) = delete;
+		void build(const LightData* lights, int numLights, const Camera& camera, int viewportWidth, int viewportHeight);
+		void bind();
+		inline const LightClusterStats& getStats()const { return m_stats; }
+	private:
+		struct LightRange {
+			int light;
+			int minX, maxX, minY, maxY, minZ, maxZ;
+		};
+		bool getRange(const LightData& light, const ew::Mat4& view, const ew::Mat4& projection, float nearPlane, float farPlane, LightRange& range)const;
+		int depthSlice(float depth, float nearPlane, float sliceScale)const;
+		unsigned int m_ubo = 0;
+		unsigned int m_clusterBuffer = 0;
+		unsigned int m_indexBuffer = 0;
+		int m_indexCapacity = 0; //Indices the GPU buffer holds
+		ClusterBlock m_block;
+		std::vector<LightRange> m_ranges;
+		std::vector<unsigned int> m_clusters; //Offset and count per cluster
+		std::vector<unsigned int> m_indices;
+		LightClusterStats m_stats;
+	};
+}
@@ -0,0 +1,116 @@
+#include "lightingUniforms.h"
+#include <string.h>
+#include "external/glad.h"
+
+namespace ew {
+	LightingUniforms::LightingUniforms()
+	{
+		glGenBuffers(1, &m_ubo);
+		glBindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(MaterialBlock), &m_material, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		glGenBuffers(1, &m_ssbo);
+	}
+	LightingUniforms::~LightingUniforms()
+	{
+		glDeleteBuffers(1, &m_ubo);
+		glDeleteBuffers(1, &m_ssbo);
+	}
+	void LightingUniforms::setNumLights(int numLights)
+	{
+		if (numLights < 0) {
+			numLights = 0;
+		}
+		int oldCount = (int)m_lights.size();
+		if (numLights == oldCount) {
+			return;
+		}
+		m_lights.resize(numLights, LightData());
+		//New lights start zeroed, so they need uploading even if nothing sets them
+		if (numLights > oldCount) {
+			if (m_dirtyBegin == m_dirtyEnd) {
+				m_dirtyBegin = oldCount;
+				m_dirtyEnd = numLights;
+			}
+			else {
+				m_dirtyBegin = oldCount < m_dirtyBegin ? oldCount : m_dirtyBegin;
+				m_dirtyEnd = numLights;
+			}
+		}
+		else if (m_dirtyEnd > numLights) {
+			m_dirtyEnd = numLights > m_dirtyBegin ? numLights : m_dirtyBegin;
+		}
+	}
+	/// <summary>
+	/// Only marks the light for upload if it actually changed
+	/// </summary>
+	/// <param name="radius">Distance the light fades out by, 0 for a light that reaches everything</param>
+	void LightingUniforms::setLight(int index, const ew::Vec3& position, const ew::Vec3& color, float radius)
+	{
+		if (index < 0 || index >= (int)m_lights.size()) {
+			return;
+		}
+		LightData light;
+		light.position = position;
+		light.radius = radius > 0.0f ? radius : 0.0f;
+		light.color = color;
+		light.pad = 0.0f;
+		if (memcmp(&m_lights[index], &light, sizeof(LightData)) == 0) {
+			return;
+		}
+		m_lights[index] = light;
+		if (m_dirtyBegin == m_dirtyEnd) {
+			m_dirtyBegin = index;
+			m_dirtyEnd = index + 1;
+		}
+		else {
+			m_dirtyBegin = index < m_dirtyBegin ? index : m_dirtyBegin;
+			m_dirtyEnd = index + 1 > m_dirtyEnd ? index + 1 : m_dirtyEnd;
+		}
+	}
+	void LightingUniforms::setMaterial(float ambientK, float diffuseK, float specular, float shininess)
+	{
+		MaterialBlock material = { ambientK, diffuseK, specular, shininess };
+		if (memcmp(&m_material, &material, sizeof(MaterialBlock)) != 0) {
+			m_material = material;
+			m_materialDirty = true;
+		}
+	}
+	/// <summary>
+	/// Uploads what changed (if anything) and binds both buffers to their binding points. Call once per frame.
+	/// </summary>
+	void LightingUniforms::bind()
+	{
+		glBindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+		if (m_materialDirty) {
+			glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(MaterialBlock), &m_material);
+			m_materialDirty = false;
+			m_uploadCount++;
+		}
+		glBindBufferBase(GL_UNIFORM_BUFFER, MATERIAL_BLOCK_BINDING, m_ubo);
+
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_ssbo);
+		int numLights = (int)m_lights.size();
+		if (numLights > m_lightCapacity) {
+			while (m_lightCapacity < numLights) {
+				m_lightCapacity = m_lightCapacity > 0 ? m_lightCapacity * 2 : 64;
+			}
+			glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(LightData) * m_lightCapacity, NULL, GL_DYNAMIC_DRAW);
+			//The new store is empty, so every light goes up
+			m_dirtyBegin = 0;
+			m_dirtyEnd = numLights;
+			m_uploadCount++;
+		}
+		if (m_dirtyBegin != m_dirtyEnd) {
+			glBufferSubData(GL_SHADER_STORAGE_BUFFER, sizeof(LightData) * m_dirtyBegin, sizeof(LightData) * (m_dirtyEnd - m_dirtyBegin), &m_lights[m_dirtyBegin]);
+			m_dirtyBegin = m_dirtyEnd = 0;
+			m_uploadCount++;
+		}
+		if (m_lightCapacity == 0) {
+			//Bindings need a buffer with storage even with no lights
+			glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(LightData), NULL, GL_DYNAMIC_DRAW);
+			m_lightCapacity = 1;
+		}
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_BUFFER_BINDING, m_ssbo);
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <vector>
+#include "ewMath/ewMath.h"
+
+namespace ew {
+	constexpr unsigned int MATERIAL_BLOCK_BINDING = 1; //layout(binding) of MaterialBlock
+	constexpr unsigned int LIGHT_BUFFER_BINDING = 3; //layout(binding) of the LightBuffer shader storage block
+
+	//std430 Light in LightBuffer
+	struct LightData {
+		ew::Vec3 position; //World space
+		float radius; //Fades out by this distance, so ew::LightClusters can cull it. 0 lights everything.
+		ew::Vec3 color; //RGB
+		float pad;
+	};
+
+	//std140 mirror of the MaterialBlock uniform block
+	struct MaterialBlock {
+		float ambientK; //Ambient coefficient (0-1)
+		float diffuseK; //Diffuse coefficient (0-1)
+		float specular; //Specular coefficient (0-1)
+		float shininess; //Shininess
+	};
+
+	/// <summary>
+	/// Lighting inputs shared by every lit shader: the lights in one shader storage buffer (any number of them,
+	/// see ew::LightClusters for which ones each fragment reads) and the material in a uniform buffer.
+	/// Setters only touch CPU copies; bind() uploads whatever changed.
+	/// </summary>
+	class LightingUniforms {
+	public:
+		LightingUniforms();
+		~LightingUniforms();
+		LightingUniforms(const LightingUniforms&) = delete;
+		LightingUniforms& operator=(const LightingUniforms&) = delete;
+		void setNumLights(int numLights);
+		void setLight(int index, const ew::Vec3& position, const ew::Vec3& color, float radius = 0.0f);
+		void setMaterial(float ambientK, float diffuseK, float specular, float shininess);
+		void bind();
+		inline int getNumLights()const { return (int)m_lights.size(); }
+		inline const LightData* getLights()const { return m_lights.data(); }
+		inline unsigned int getUploadCount()const { return m_uploadCount; } //glBufferData/glBufferSubData calls so far
+	private:
+		unsigned int m_ubo = 0;
+		unsigned int m_ssbo = 0;
+		int m_lightCapacity = 0; //Lights the GPU buffer holds
+		int m_dirtyBegin = 0; //Light range to upload
+		int m_dirtyEnd = 0;
+		bool m_materialDirty = true;
+		unsigned int m_uploadCount = 0;
+		MaterialBlock m_material = {};
+		std::vector<LightData> m_lights; //CPU copy
+	};
+}
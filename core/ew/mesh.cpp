@@ -5,60 +5,294 @@
 #include "mesh.h"
 #include "ewMath/ewMath.h"
 #include "external/glad.h"
+#include "glState.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
 
 namespace ew {
-	Mesh::Mesh(const MeshData& meshData)
+	/// <summary>
+	/// Sets attribute formats 0-2 on the bound VAO, all sourced from vertex buffer binding 0.
+	/// Bind the buffer with glBindVertexBuffer(0, vbo, 0, GetVertexSize(format)).
+	/// </summary>
+	void SetupVertexFormat(VertexFormat format)
 	{
+		if (format == VertexFormat::COMPACT) {
+			glVertexAttribFormat(0, 4, GL_HALF_FLOAT, GL_FALSE, offsetof(CompactVertex, pos));
+			glVertexAttribFormat(1, 2, GL_SHORT, GL_TRUE, offsetof(CompactVertex, normal));
+			glVertexAttribFormat(2, 2, GL_UNSIGNED_SHORT, GL_TRUE, offsetof(CompactVertex, uv));
+		}
+		else {
+			glVertexAttribFormat(0, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, pos));
+			glVertexAttribFormat(1, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, normal));
+			glVertexAttribFormat(2, 2, GL_FLOAT, GL_FALSE, offsetof(Vertex, uv));
+		}
+		for (unsigned int i = 0; i < 3; i++)
+		{
+			glVertexAttribBinding(i, 0);
+			glEnableVertexAttribArray(i);
+		}
+	}
+	unsigned int GetIndexGLType(IndexType type)
+	{
+		return type == IndexType::UINT16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	}
+	unsigned int GetTopologyGLMode(Topology topology)
+	{
+		return topology == Topology::TRIANGLE_STRIP ? GL_TRIANGLE_STRIP : GL_TRIANGLES;
+	}
+	/// <summary>
+	/// Fills the bound GL_ELEMENT_ARRAY_BUFFER, narrowing to 16 bits for UINT16.
+	/// PRIMITIVE_RESTART narrows to 0xFFFF, the 16 bit restart value.
+	/// </summary>
+	void UploadIndices(const std::vector<unsigned int>& indices, IndexType type, unsigned int usage)
+	{
+		if (type == IndexType::UINT32) {
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * indices.size(), indices.data(), usage);
+			return;
+		}
+		std::vector<unsigned short> narrow(indices.size());
+		for (size_t i = 0; i < indices.size(); i++) {
+			narrow[i] = (unsigned short)indices[i];
+		}
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned short) * narrow.size(), narrow.data(), usage);
+	}
+	/// <summary>
+	/// Creates a mesh and uploads meshData
+	/// </summary>
+	/// <param name="usage">STREAMING for meshes rewritten every frame, see mapVertices</param>
+	/// <param name="vertexCapacity">Streaming only. Vertices per region, if more than meshData holds.</param>
+	Mesh::Mesh(const MeshData& meshData, MeshUsage usage, int vertexCapacity)
+		:Mesh(meshData, VertexFormat::FLOAT32, usage, vertexCapacity)
+	{
+	}
+	/// <summary>
+	/// Creates a mesh stored in the given vertex format. COMPACT halves vertex memory, see ew::CompactVertex.
+	/// </summary>
+	Mesh::Mesh(const MeshData& meshData, VertexFormat format, MeshUsage usage, int vertexCapacity)
+	{
+		m_format = format;
+		m_usage = usage;
+		if (usage == MeshUsage::STREAMING) {
+			int vertices = (int)meshData.vertices.size();
+			createStreamStorage(vertexCapacity > vertices ? vertexCapacity : vertices);
+		}
 		load(meshData);
 	}
+	void Mesh::setupVertexAttributes()
+	{
+		SetupVertexFormat(m_format);
+		glBindVertexBuffer(0, m_vbo, 0, GetVertexSize(m_format));
+	}
+	/// <summary>
+	/// Allocates immutable, persistently mapped storage for MESH_STREAM_REGIONS regions.
+	/// Immutable storage can't be resized, so growing replaces the buffer.
+	/// </summary>
+	void Mesh::createStreamStorage(int vertexCapacity)
+	{
+		if (!m_initialized) {
+			glGenVertexArrays(1, &m_vao);
+			glGenBuffers(1, &m_ebo);
+			m_initialized = true;
+		}
+		if (m_vbo != 0) {
+			glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+			glUnmapBuffer(GL_ARRAY_BUFFER);
+			glDeleteBuffers(1, &m_vbo);
+		}
+		for (int i = 0; i < MESH_STREAM_REGIONS; i++) {
+			if (m_fences[i]) {
+				glDeleteSync((GLsync)m_fences[i]);
+				m_fences[i] = nullptr;
+			}
+		}
+		m_vertexCapacity = vertexCapacity > 0 ? vertexCapacity : 1;
+		GLsizeiptr size = GetVertexSize(m_format) * (GLsizeiptr)m_vertexCapacity * MESH_STREAM_REGIONS;
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+		GLState::bindVertexArray(m_vao);
+		glGenBuffers(1, &m_vbo);
+		glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+		glBufferStorage(GL_ARRAY_BUFFER, size, NULL, flags);
+		m_mapped = (unsigned char*)glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+		setupVertexAttributes();
+		GLState::bindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		m_region = 0;
+	}
 	void Mesh::load(const MeshData& meshData)
 	{
+		if (m_usage == MeshUsage::STREAMING) {
+			if ((int)meshData.vertices.size() > m_vertexCapacity) {
+				createStreamStorage((int)meshData.vertices.size());
+			}
+			unsigned char* region = mapRegion();
+			if (meshData.vertices.size() > 0) {
+				if (m_format == VertexFormat::COMPACT) {
+					EncodeVertices(meshData.vertices.data(), (int)meshData.vertices.size(), (CompactVertex*)region);
+				}
+				else {
+					memcpy(region, meshData.vertices.data(), sizeof(Vertex) * meshData.vertices.size());
+				}
+			}
+			unmapVertices((int)meshData.vertices.size());
+
+			//Indices stay in a regular buffer and only go up when the topology changes.
+			//Unchanged indices still fit the type they were uploaded as.
+			if (meshData.indices != m_uploadedIndices) {
+				m_indexType = ChooseIndexType((int)meshData.vertices.size());
+				GLState::bindVertexArray(m_vao);
+				glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+				UploadIndices(meshData.indices, m_indexType, GL_DYNAMIC_DRAW);
+				GLState::bindVertexArray(0);
+				m_uploadedIndices = meshData.indices;
+			}
+			m_numIndices = meshData.indices.size();
+			m_topology = meshData.topology;
+			m_bounds = ComputeBounds(meshData.vertices);
+			return;
+		}
 		if (!m_initialized) {
 			glGenVertexArrays(1, &m_vao);
-			glBindVertexArray(m_vao);
+			GLState::bindVertexArray(m_vao);
 
 			glGenBuffers(1, &m_vbo);
 			glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
 
 			glGenBuffers(1, &m_ebo);
 			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
-			//Position attribute
-			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)offsetof(Vertex, pos));
-			glEnableVertexAttribArray(0);
-
-			//Normal attribute
-			glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)offsetof(Vertex, normal));
-			glEnableVertexAttribArray(1);
-
-			//UV attribute
-			glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)(offsetof(Vertex, uv)));
-			glEnableVertexAttribArray(2);
+			setupVertexAttributes();
 
 			m_initialized = true;
 		}
 
-		glBindVertexArray(m_vao);
+		GLState::bindVertexArray(m_vao);
 		glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
 
 		if (meshData.vertices.size() > 0) {
-			glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * meshData.vertices.size(), meshData.vertices.data(), GL_STATIC_DRAW);
+			if (m_format == VertexFormat::COMPACT) {
+				std::vector<CompactVertex> compact(meshData.vertices.size());
+				EncodeVertices(meshData.vertices.data(), (int)compact.size(), compact.data());
+				glBufferData(GL_ARRAY_BUFFER, sizeof(CompactVertex) * compact.size(), compact.data(), GL_STATIC_DRAW);
+			}
+			else {
+				glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * meshData.vertices.size(), meshData.vertices.data(), GL_STATIC_DRAW);
+			}
 		}
+		m_indexType = ChooseIndexType((int)meshData.vertices.size());
 		if (meshData.indices.size() > 0) {
-			glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * meshData.indices.size(), meshData.indices.data(), GL_STATIC_DRAW);
+			UploadIndices(meshData.indices, m_indexType, GL_STATIC_DRAW);
 		}
 		m_numVertices = meshData.vertices.size();
 		m_numIndices = meshData.indices.size();
+		m_topology = meshData.topology;
+		//MeshData built by hand may not have bounds yet
+		m_bounds = (meshData.bounds.radius > 0 || meshData.vertices.empty()) ? meshData.bounds : ComputeBounds(meshData.vertices);
 
-		glBindVertexArray(0);
+		GLState::bindVertexArray(0);
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 	}
+	/// <summary>
+	/// Streaming only. Returns the next region to write getVertexCapacity() vertices into,
+	/// waiting first if the GPU may still be reading it. Finish with unmapVertices.
+	/// Nothing is copied: the memory is the buffer itself. Bounds are not updated.
+	/// </summary>
+	Vertex* Mesh::mapVertices()
+	{
+		if (m_usage != MeshUsage::STREAMING || m_format != VertexFormat::FLOAT32) {
+			printf("Mesh::mapVertices needs a MeshUsage::STREAMING, VertexFormat::FLOAT32 mesh\n");
+			return nullptr;
+		}
+		return (Vertex*)mapRegion();
+	}
+	unsigned char* Mesh::mapRegion()
+	{
+		int region = (m_region + 1) % MESH_STREAM_REGIONS;
+		GLsync fence = (GLsync)m_fences[region];
+		if (fence) {
+			GLenum result = glClientWaitSync(fence, 0, 0);
+			if (result == GL_TIMEOUT_EXPIRED) {
+				m_stallCount++;
+				//Flush so the fence is guaranteed to signal, then block
+				GLbitfield waitFlags = GL_SYNC_FLUSH_COMMANDS_BIT;
+				while (result == GL_TIMEOUT_EXPIRED) {
+					result = glClientWaitSync(fence, waitFlags, 1000000);
+					waitFlags = 0;
+				}
+			}
+			glDeleteSync(fence);
+			m_fences[region] = nullptr;
+		}
+		return m_mapped + (size_t)region * m_vertexCapacity * GetVertexSize(m_format);
+	}
+	/// <summary>
+	/// Makes the region returned by mapVertices the one drawn
+	/// </summary>
+	void Mesh::unmapVertices(int numVertices)
+	{
+		m_region = (m_region + 1) % MESH_STREAM_REGIONS;
+		m_numVertices = numVertices < m_vertexCapacity ? numVertices : m_vertexCapacity;
+	}
+	/// <summary>
+	/// Deletes the GL objects. Meshes are plain values that share their buffers when copied,
+	/// so this is never automatic; MeshCache calls it when the last handle goes.
+	/// </summary>
+	void Mesh::release()
+	{
+		if (!m_initialized) {
+			return;
+		}
+		for (int i = 0; i < MESH_STREAM_REGIONS; i++) {
+			if (m_fences[i]) {
+				glDeleteSync((GLsync)m_fences[i]);
+				m_fences[i] = nullptr;
+			}
+		}
+		if (m_mapped) {
+			glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+			glUnmapBuffer(GL_ARRAY_BUFFER);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			m_mapped = nullptr;
+		}
+		//Deleting the bound VAO unbinds it behind GLState's back, and its name can be reused
+		GLState::bindVertexArray(0);
+		glDeleteVertexArrays(1, &m_vao);
+		glDeleteBuffers(1, &m_vbo);
+		glDeleteBuffers(1, &m_ebo);
+		m_vao = m_vbo = m_ebo = 0;
+		m_numVertices = m_numIndices = 0;
+		m_uploadedIndices.clear();
+		m_initialized = false;
+	}
 	void Mesh::draw(ew::DrawMode drawMode) const
 	{
-		glBindVertexArray(m_vao);
+		GLState::bindVertexArray(m_vao);
+		GLenum mode = GetTopologyGLMode(m_topology);
+		GLenum indexType = GetIndexGLType(m_indexType);
+		if (m_topology == Topology::TRIANGLE_STRIP) {
+			//Restarts on 0xFFFF or 0xFFFFFFFF to match the index type. Neither is a valid index, so this can stay on.
+			GLState::setEnabled(GL_PRIMITIVE_RESTART_FIXED_INDEX, true);
+		}
+		if (m_usage == MeshUsage::STREAMING) {
+			int baseVertex = m_region * m_vertexCapacity;
+			if (drawMode == DrawMode::TRIANGLES) {
+				glDrawElementsBaseVertex(mode, m_numIndices, indexType, NULL, baseVertex);
+			}
+			else {
+				glDrawArrays(GL_POINTS, baseVertex, m_numVertices);
+			}
+			//Replace the region's fence so the next write to it waits for this draw
+			if (m_fences[m_region]) {
+				glDeleteSync((GLsync)m_fences[m_region]);
+			}
+			m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			return;
+		}
 		if (drawMode == DrawMode::TRIANGLES) {
-			glDrawElements(GL_TRIANGLES, m_numIndices, GL_UNSIGNED_INT, NULL);
+			glDrawElements(mode, m_numIndices, indexType, NULL);
 		}
 		else {
 			glDrawArrays(GL_POINTS, 0, m_numVertices);
@@ -4,6 +4,7 @@
 
 #pragma once
 #include "ewMath/ewMath.h"
+#include "vertexFormat.h"
 
 namespace ew {
 	struct Vertex {
@@ -12,30 +13,100 @@ namespace ew {
 		ew::Vec2 uv;
 	};
 
+	//Object space bounds, used for culling
+	struct Bounds {
+		ew::Vec3 min = ew::Vec3(0);
+		ew::Vec3 max = ew::Vec3(0);
+		ew::Vec3 center = ew::Vec3(0); //Center of the bounding sphere (and box)
+		float radius = 0; //Bounding sphere radius
+	};
+
+	enum class Topology {
+		TRIANGLES = 0,
+		TRIANGLE_STRIP = 1 //Strips are separated by PRIMITIVE_RESTART
+	};
+
+	//Ends a triangle strip. Uploaded as the largest value of the index type, see GL_PRIMITIVE_RESTART_FIXED_INDEX.
+	constexpr unsigned int PRIMITIVE_RESTART = 0xFFFFFFFF;
+
 	struct MeshData {
 		std::vector<Vertex> vertices;
 		std::vector<unsigned int> indices;
+		Bounds bounds; //Filled by the create functions, see ComputeBounds
+		Topology topology = Topology::TRIANGLES;
 	};
 
+	//GL-free, in meshData.cpp
+	Bounds ComputeBounds(const std::vector<Vertex>& vertices);
+	std::vector<unsigned int> TriangulateStrips(const std::vector<unsigned int>& strips);
+
+	enum class IndexType {
+		UINT16 = 0,
+		UINT32 = 1
+	};
+
+	//UINT16 when every vertex can be addressed without hitting the 16 bit restart value
+	inline IndexType ChooseIndexType(int numVertices) { return numVertices <= 0xFFFF ? IndexType::UINT16 : IndexType::UINT32; }
+	inline int GetIndexSize(IndexType type) { return type == IndexType::UINT16 ? 2 : 4; }
+	unsigned int GetIndexGLType(IndexType type);
+	unsigned int GetTopologyGLMode(Topology topology);
+	void UploadIndices(const std::vector<unsigned int>& indices, IndexType type, unsigned int usage);
+
 	enum class DrawMode {
 		TRIANGLES = 0,
 		POINTS = 1
 	};
 
+	enum class MeshUsage {
+		STATIC = 0, //Uploaded with glBufferData, for meshes that rarely change
+		STREAMING = 1 //Persistently mapped ring of vertex regions, for meshes rewritten every frame
+	};
+
+	//Vertex regions in a streaming mesh. The CPU writes one while the GPU may still read the other two.
+	constexpr int MESH_STREAM_REGIONS = 3;
+
 	class Mesh {
 	public:
 		Mesh() {};
-		Mesh(const MeshData& meshData);
+		Mesh(const MeshData& meshData, MeshUsage usage = MeshUsage::STATIC, int vertexCapacity = 0);
+		Mesh(const MeshData& meshData, VertexFormat format, MeshUsage usage = MeshUsage::STATIC, int vertexCapacity = 0);
 		void load(const MeshData& meshData);
+		Vertex* mapVertices();
+		void unmapVertices(int numVertices);
 		void draw(DrawMode drawMode = DrawMode::TRIANGLES)const;
+		void release();
 		inline int getNumVertices()const { return m_numVertices; }
 		inline int getNumIndices()const { return m_numIndices; }
+		inline const Bounds& getBounds()const { return m_bounds; }
+		inline MeshUsage getUsage()const { return m_usage; }
+		inline VertexFormat getVertexFormat()const { return m_format; }
+		inline int getVertexBufferSize()const { return m_numVertices * GetVertexSize(m_format); } //Bytes, one region for streaming meshes
+		inline IndexType getIndexType()const { return m_indexType; }
+		inline int getIndexBufferSize()const { return m_numIndices * GetIndexSize(m_indexType); } //Bytes
+		inline Topology getTopology()const { return m_topology; }
+		inline int getVertexCapacity()const { return m_vertexCapacity; }
+		inline unsigned int getStallCount()const { return m_stallCount; } //Streaming writes that had to wait on the GPU
 	private:
+		void setupVertexAttributes();
+		void createStreamStorage(int vertexCapacity);
+		unsigned char* mapRegion();
 		bool m_initialized = false;
 		unsigned int m_vao = 0;
 		unsigned int m_vbo = 0;
 		unsigned int m_ebo = 0;
 		int m_numVertices = 0;
 		int m_numIndices = 0;
+		Bounds m_bounds;
+		VertexFormat m_format = VertexFormat::FLOAT32;
+		IndexType m_indexType = IndexType::UINT32;
+		Topology m_topology = Topology::TRIANGLES;
+		//Streaming only
+		MeshUsage m_usage = MeshUsage::STATIC;
+		int m_vertexCapacity = 0; //Vertices per region
+		int m_region = 0; //Region holding the vertices drawn next
+		unsigned char* m_mapped = nullptr; //All regions, persistently mapped
+		mutable void* m_fences[MESH_STREAM_REGIONS] = {}; //GLsync set after the last draw that read each region
+		unsigned int m_stallCount = 0;
+		std::vector<unsigned int> m_uploadedIndices; //Index buffer contents, so unchanged topology isn't uploaded again
 	};
 }
\ No newline at end of file
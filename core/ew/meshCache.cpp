@@ -0,0 +1,199 @@
+#include "meshCache.h"
+#include "procGen.h"
+#include <string.h>
+
+namespace ew {
+	static const unsigned long long FNV_OFFSET = 14695981039346656037ull;
+	static const unsigned long long FNV_PRIME = 1099511628211ull;
+
+	//FNV-1a, continued from hash
+	static unsigned long long hashBytes(unsigned long long hash, const void* data, size_t size) {
+		const unsigned char* bytes = (const unsigned char*)data;
+		for (size_t i = 0; i < size; i++) {
+			hash = (hash ^ bytes[i]) * FNV_PRIME;
+		}
+		return hash;
+	}
+	//Key for a generator call. Every field is hashed on its own so struct padding never gets in.
+	static unsigned long long parameterKey(char generator, float a, float b, int subdivisions, VertexFormat format, Topology topology) {
+		unsigned long long hash = hashBytes(FNV_OFFSET, &generator, sizeof(generator));
+		hash = hashBytes(hash, &a, sizeof(a));
+		hash = hashBytes(hash, &b, sizeof(b));
+		hash = hashBytes(hash, &subdivisions, sizeof(subdivisions));
+		hash = hashBytes(hash, &format, sizeof(format));
+		return hashBytes(hash, &topology, sizeof(topology));
+	}
+	//Drops the freed entries sharing key's hash table bucket, so churned meshes get cleared as new ones go in.
+	//Local iterators can't erase, so the expired keys are collected first.
+	template<typename Map>
+	static void pruneBucket(Map& map, unsigned long long key) {
+		if (map.bucket_count() == 0) {
+			return;
+		}
+		size_t bucket = map.bucket(key);
+		std::vector<unsigned long long> expired;
+		for (auto it = map.begin(bucket); it != map.end(bucket); ++it) {
+			if (it->second.mesh.expired()) {
+				expired.push_back(it->first);
+			}
+		}
+		for (unsigned long long expiredKey : expired) {
+			auto range = map.equal_range(expiredKey);
+			for (auto it = range.first; it != range.second;) {
+				it = it->second.mesh.expired() ? map.erase(it) : ++it;
+			}
+		}
+	}
+	/// <summary>
+	/// Exact comparison of what HashMeshData hashes, to confirm a hash match
+	/// </summary>
+	bool SameMeshData(const MeshData& a, const MeshData& b)
+	{
+		return a.topology == b.topology && a.vertices.size() == b.vertices.size() && a.indices.size() == b.indices.size()
+			&& memcmp(a.vertices.data(), b.vertices.data(), sizeof(Vertex) * a.vertices.size()) == 0
+			&& memcmp(a.indices.data(), b.indices.data(), sizeof(unsigned int) * a.indices.size()) == 0;
+	}
+	/// <summary>
+	/// 64 bit content hash of the vertices, indices and topology. Bounds are derived, so they are left out.
+	/// </summary>
+	unsigned long long HashMeshData(const MeshData& meshData)
+	{
+		unsigned long long hash = FNV_OFFSET;
+		size_t numVertices = meshData.vertices.size();
+		size_t numIndices = meshData.indices.size();
+		hash = hashBytes(hash, &numVertices, sizeof(numVertices));
+		hash = hashBytes(hash, &numIndices, sizeof(numIndices));
+		hash = hashBytes(hash, &meshData.topology, sizeof(meshData.topology));
+		hash = hashBytes(hash, meshData.vertices.data(), sizeof(Vertex) * numVertices);
+		return hashBytes(hash, meshData.indices.data(), sizeof(unsigned int) * numIndices);
+	}
+	bool MeshCache::GeneratorCall::operator==(const GeneratorCall& other)const
+	{
+		return generator == other.generator && a == other.a && b == other.b && subdivisions == other.subdivisions
+			&& format == other.format && topology == other.topology;
+	}
+	MeshHandle MeshCache::findContent(unsigned long long key, const MeshData& meshData, VertexFormat format)
+	{
+		auto range = m_byContent.equal_range(key);
+		for (auto it = range.first; it != range.second; ++it) {
+			if (it->second.format == format && SameMeshData(it->second.meshData, meshData)) {
+				MeshHandle mesh = it->second.mesh.lock();
+				if (!mesh) {
+					m_byContent.erase(it);
+				}
+				return mesh;
+			}
+		}
+		return nullptr;
+	}
+	MeshHandle MeshCache::findParameters(unsigned long long key, const GeneratorCall& call)
+	{
+		auto range = m_byParameters.equal_range(key);
+		for (auto it = range.first; it != range.second; ++it) {
+			if (it->second.call == call) {
+				MeshHandle mesh = it->second.mesh.lock();
+				if (!mesh) {
+					m_byParameters.erase(it);
+				}
+				return mesh;
+			}
+		}
+		return nullptr;
+	}
+	/// <summary>
+	/// Returns the mesh already uploaded with the same contents and format, or uploads meshData
+	/// </summary>
+	MeshHandle MeshCache::get(const MeshData& meshData, VertexFormat format)
+	{
+		unsigned long long key = hashBytes(HashMeshData(meshData), &format, sizeof(format));
+		MeshHandle mesh = findContent(key, meshData, format);
+		if (mesh) {
+			m_hitCount++;
+			return mesh;
+		}
+		mesh = MeshHandle(new Mesh(meshData, format), [](Mesh* mesh) {
+			mesh->release();
+			delete mesh;
+		});
+		pruneBucket(m_byContent, key);
+		m_byContent.insert({ key, ContentEntry{ meshData, format, mesh } });
+		m_uploadCount++;
+		return mesh;
+	}
+	//Runs the generator only if the same call hasn't been made while its mesh is alive
+	MeshHandle MeshCache::getGenerated(const GeneratorCall& call)
+	{
+		unsigned long long key = parameterKey(call.generator, call.a, call.b, call.subdivisions, call.format, call.topology);
+		MeshHandle mesh = findParameters(key, call);
+		if (mesh) {
+			m_hitCount++;
+			return mesh;
+		}
+		switch (call.generator) {
+		case 'c':
+			mesh = get(createCube(call.a), call.format);
+			break;
+		case 'p':
+			mesh = get(createPlane(call.a, call.b, call.subdivisions, nullptr, call.topology), call.format);
+			break;
+		case 's':
+			mesh = get(createSphere(call.a, call.subdivisions), call.format);
+			break;
+		default:
+			mesh = get(createCylinder(call.a, call.b, call.subdivisions), call.format);
+			break;
+		}
+		pruneBucket(m_byParameters, key);
+		m_byParameters.insert({ key, ParameterEntry{ call, mesh } });
+		return mesh;
+	}
+	MeshHandle MeshCache::getCube(float size, VertexFormat format)
+	{
+		return getGenerated({ 'c', size, 0, 0, format, Topology::TRIANGLES });
+	}
+	MeshHandle MeshCache::getPlane(float width, float height, int subdivisions, VertexFormat format, Topology topology)
+	{
+		return getGenerated({ 'p', width, height, subdivisions, format, topology });
+	}
+	MeshHandle MeshCache::getSphere(float radius, int subdivisions, VertexFormat format)
+	{
+		return getGenerated({ 's', radius, 0, subdivisions, format, Topology::TRIANGLES });
+	}
+	MeshHandle MeshCache::getCylinder(float radius, float height, int subdivisions, VertexFormat format)
+	{
+		return getGenerated({ 'y', radius, height, subdivisions, format, Topology::TRIANGLES });
+	}
+	//Drops entries whose meshes have been freed
+	void MeshCache::prune()
+	{
+		for (auto it = m_byContent.begin(); it != m_byContent.end();) {
+			it = it->second.mesh.expired() ? m_byContent.erase(it) : ++it;
+		}
+		for (auto it = m_byParameters.begin(); it != m_byParameters.end();) {
+			it = it->second.mesh.expired() ? m_byParameters.erase(it) : ++it;
+		}
+	}
+	int MeshCache::getMeshCount()
+	{
+		prune();
+		return (int)m_byContent.size();
+	}
+	int MeshCache::getVertexBufferSize()
+	{
+		prune();
+		int bytes = 0;
+		for (auto& entry : m_byContent) {
+			bytes += entry.second.mesh.lock()->getVertexBufferSize();
+		}
+		return bytes;
+	}
+	int MeshCache::getIndexBufferSize()
+	{
+		prune();
+		int bytes = 0;
+		for (auto& entry : m_byContent) {
+			bytes += entry.second.mesh.lock()->getIndexBufferSize();
+		}
+		return bytes;
+	}
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <memory>
+#include <unordered_map>
+#include "mesh.h"
+
+namespace ew {
+	//Shared by every holder. The GPU buffers are freed with the last handle.
+	typedef std::shared_ptr<Mesh> MeshHandle;
+
+	/// <summary>
+	/// Uploads each unique mesh once. Generator calls are keyed by their parameters, so a hit skips
+	/// generation too. Anything else is keyed by a hash of its vertices and indices. Entries keep what they
+	/// were keyed on and compare it on a hit, so a hash collision uploads a second mesh instead of sharing the wrong one.
+	/// Only static meshes are cached. Handles stay valid if the cache goes away first.
+	/// </summary>
+	class MeshCache {
+	public:
+		MeshHandle get(const MeshData& meshData, VertexFormat format = VertexFormat::FLOAT32);
+		MeshHandle getCube(float size, VertexFormat format = VertexFormat::FLOAT32);
+		MeshHandle getPlane(float width, float height, int subdivisions, VertexFormat format = VertexFormat::FLOAT32, Topology topology = Topology::TRIANGLES);
+		MeshHandle getSphere(float radius, int subdivisions, VertexFormat format = VertexFormat::FLOAT32);
+		MeshHandle getCylinder(float radius, float height, int subdivisions, VertexFormat format = VertexFormat::FLOAT32);
+		int getMeshCount(); //Unique meshes that still have handles
+		int getVertexBufferSize(); //Bytes, over the live meshes
+		int getIndexBufferSize();
+		inline unsigned int getHitCount()const { return m_hitCount; }
+		inline unsigned int getUploadCount()const { return m_uploadCount; }
+	private:
+		struct GeneratorCall {
+			char generator;
+			float a, b;
+			int subdivisions;
+			VertexFormat format;
+			Topology topology;
+			bool operator==(const GeneratorCall& other)const;
+		};
+		struct ContentEntry {
+			MeshData meshData; //CPU copy of what was uploaded, to tell colliding hashes apart
+			VertexFormat format;
+			std::weak_ptr<Mesh> mesh;
+		};
+		struct ParameterEntry {
+			GeneratorCall call;
+			std::weak_ptr<Mesh> mesh;
+		};
+		typedef std::unordered_multimap<unsigned long long, ContentEntry> ContentMap;
+		typedef std::unordered_multimap<unsigned long long, ParameterEntry> ParameterMap;
+		MeshHandle findContent(unsigned long long key, const MeshData& meshData, VertexFormat format);
+		MeshHandle findParameters(unsigned long long key, const GeneratorCall& call);
+		MeshHandle getGenerated(const GeneratorCall& call);
+		void prune();
+		ContentMap m_byContent;
+		ParameterMap m_byParameters;
+		unsigned int m_hitCount = 0;
+		unsigned int m_uploadCount = 0;
+	};
+
+	unsigned long long HashMeshData(const MeshData& meshData);
+	bool SameMeshData(const MeshData& a, const MeshData& b);
+}
@@ -0,0 +1,59 @@
+#include "mesh.h"
+#include <math.h>
+
+//The GL-free half of mesh.h, so tools can build meshes without linking GL
+
+namespace ew {
+	/// <summary>
+	/// Axis aligned box around the vertices, and a sphere around that box
+	/// </summary>
+	Bounds ComputeBounds(const std::vector<Vertex>& vertices)
+	{
+		Bounds bounds;
+		if (vertices.empty()) {
+			return bounds;
+		}
+		bounds.min = bounds.max = vertices[0].pos;
+		for (size_t i = 1; i < vertices.size(); i++)
+		{
+			const ew::Vec3& p = vertices[i].pos;
+			bounds.min = ew::Vec3(fminf(bounds.min.x, p.x), fminf(bounds.min.y, p.y), fminf(bounds.min.z, p.z));
+			bounds.max = ew::Vec3(fmaxf(bounds.max.x, p.x), fmaxf(bounds.max.y, p.y), fmaxf(bounds.max.z, p.z));
+		}
+		bounds.center = (bounds.min + bounds.max) * 0.5f;
+		//Tighter than the box corner for round meshes
+		float radiusSquared = 0;
+		for (size_t i = 0; i < vertices.size(); i++)
+		{
+			ew::Vec3 d = vertices[i].pos - bounds.center;
+			radiusSquared = fmaxf(radiusSquared, ew::Dot(d, d));
+		}
+		bounds.radius = sqrtf(radiusSquared);
+		return bounds;
+	}
+	/// <summary>
+	/// Triangle list drawing the same triangles, with the same winding, as TRIANGLE_STRIP indices
+	/// </summary>
+	std::vector<unsigned int> TriangulateStrips(const std::vector<unsigned int>& strips)
+	{
+		std::vector<unsigned int> triangles;
+		triangles.reserve(strips.size() * 3);
+		size_t stripStart = 0;
+		for (size_t i = 0; i < strips.size(); i++)
+		{
+			if (strips[i] == PRIMITIVE_RESTART) {
+				stripStart = i + 1;
+				continue;
+			}
+			if (i - stripStart < 2) {
+				continue;
+			}
+			//Every other triangle in a strip is wound the other way
+			bool even = ((i - stripStart) & 1) == 0;
+			triangles.push_back(strips[even ? i - 2 : i - 1]);
+			triangles.push_back(strips[even ? i - 1 : i - 2]);
+			triangles.push_back(strips[i]);
+		}
+		return triangles;
+	}
+}
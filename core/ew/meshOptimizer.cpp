@@ -0,0 +1,397 @@
+#include "meshOptimizer.h"
+#include <algorithm>
+
+namespace ew {
+	static const int MAX_CACHE_SIZE = 64;
+
+	/// <summary>
+	/// Simulates a FIFO post transform cache, like most GPUs have, over the triangle list or strips
+	/// </summary>
+	VertexCacheStats AnalyzeVertexCache(const MeshData& mesh, int cacheSize)
+	{
+		VertexCacheStats stats;
+		int numTriangles = (int)mesh.indices.size() / 3;
+		size_t numIndices = (size_t)numTriangles * 3;
+		if (mesh.topology == Topology::TRIANGLE_STRIP) {
+			//Each strip of n indices draws n - 2 triangles
+			numTriangles = 0;
+			numIndices = mesh.indices.size();
+			int stripLength = 0;
+			for (size_t i = 0; i <= numIndices; i++)
+			{
+				if (i == numIndices || mesh.indices[i] == PRIMITIVE_RESTART) {
+					numTriangles += stripLength > 2 ? stripLength - 2 : 0;
+					stripLength = 0;
+				}
+				else {
+					stripLength++;
+				}
+			}
+		}
+		if (numTriangles == 0) {
+			return stats;
+		}
+		cacheSize = cacheSize < MAX_CACHE_SIZE ? cacheSize : MAX_CACHE_SIZE;
+		//Timestamp of each vertex's insertion. In the cache if it was inserted in the last cacheSize misses.
+		std::vector<int> insertedAt(mesh.vertices.size(), -MAX_CACHE_SIZE - 1);
+		std::vector<bool> referenced(mesh.vertices.size(), false);
+		int referencedCount = 0;
+
+		//64 byte lines in a small LRU, for vertex fetch
+		const int LINE_SIZE = 64;
+		const int LINE_CACHE = 16;
+		long long lines[LINE_CACHE];
+		for (int i = 0; i < LINE_CACHE; i++) {
+			lines[i] = -1;
+		}
+		long long bytesFetched = 0;
+
+		for (size_t i = 0; i < numIndices; i++)
+		{
+			unsigned int v = mesh.indices[i];
+			if (v == PRIMITIVE_RESTART) {
+				continue;
+			}
+			if (!referenced[v]) {
+				referenced[v] = true;
+				referencedCount++;
+			}
+			if (stats.transformed - insertedAt[v] <= cacheSize) {
+				continue;
+			}
+			insertedAt[v] = stats.transformed++;
+
+			long long first = (long long)v * sizeof(Vertex) / LINE_SIZE;
+			long long last = ((long long)v * sizeof(Vertex) + sizeof(Vertex) - 1) / LINE_SIZE;
+			for (long long line = first; line <= last; line++)
+			{
+				int hit = -1;
+				for (int j = 0; j < LINE_CACHE; j++) {
+					if (lines[j] == line) {
+						hit = j;
+						break;
+					}
+				}
+				//Move to front, the back falls out on a miss
+				int from = hit >= 0 ? hit : LINE_CACHE - 1;
+				for (int j = from; j > 0; j--) {
+					lines[j] = lines[j - 1];
+				}
+				lines[0] = line;
+				if (hit < 0) {
+					bytesFetched += LINE_SIZE;
+				}
+			}
+		}
+		stats.acmr = (float)stats.transformed / numTriangles;
+		stats.atvr = referencedCount > 0 ? (float)stats.transformed / referencedCount : 0;
+		stats.overfetch = mesh.vertices.empty() ? 0 : (float)((double)bytesFetched / (mesh.vertices.size() * sizeof(Vertex)));
+		return stats;
+	}
+
+	//Forsyth's scoring, see "Linear-Speed Vertex Cache Optimisation"
+	static float vertexScore(int cachePosition, int remainingTriangles, int cacheSize) {
+		if (remainingTriangles == 0) {
+			return -1.0f;
+		}
+		float score = 0;
+		if (cachePosition >= 0) {
+			if (cachePosition < 3) {
+				//The last triangle's vertices: using them again gains nothing over any other cached vertex
+				score = 0.75f;
+			}
+			else {
+				score = powf(1.0f - (float)(cachePosition - 3) / (cacheSize - 3), 1.5f);
+			}
+		}
+		//Favor vertices with few triangles left, so they can leave the working set
+		return score + 2.0f * powf((float)remainingTriangles, -0.5f);
+	}
+	/// <summary>
+	/// Reorders triangles for the post transform vertex cache (Forsyth). Vertices are not moved.
+	/// The original order is kept if the new one doesn't lower ACMR, which happens for small, already ordered grids.
+	/// Strips are left alone, their order is already cache friendly.
+	/// </summary>
+	void OptimizeVertexCache(MeshData& mesh, int cacheSize)
+	{
+		int numTriangles = (int)mesh.indices.size() / 3;
+		int numVertices = (int)mesh.vertices.size();
+		if (numTriangles == 0 || mesh.topology != Topology::TRIANGLES) {
+			return;
+		}
+		cacheSize = cacheSize < MAX_CACHE_SIZE ? cacheSize : MAX_CACHE_SIZE;
+		cacheSize = cacheSize > 4 ? cacheSize : 4;
+		float originalAcmr = AnalyzeVertexCache(mesh, cacheSize).acmr;
+
+		//Triangles using each vertex
+		std::vector<int> remaining(numVertices, 0);
+		for (int i = 0; i < numTriangles * 3; i++) {
+			remaining[mesh.indices[i]]++;
+		}
+		std::vector<int> adjacencyStart(numVertices + 1, 0);
+		for (int v = 0; v < numVertices; v++) {
+			adjacencyStart[v + 1] = adjacencyStart[v] + remaining[v];
+		}
+		std::vector<int> adjacency(numTriangles * 3);
+		std::vector<int> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+		for (int t = 0; t < numTriangles; t++) {
+			for (int k = 0; k < 3; k++) {
+				adjacency[fill[mesh.indices[t * 3 + k]]++] = t;
+			}
+		}
+
+		std::vector<int> cachePosition(numVertices, -1);
+		std::vector<float> score(numVertices);
+		for (int v = 0; v < numVertices; v++) {
+			score[v] = vertexScore(-1, remaining[v], cacheSize);
+		}
+		std::vector<float> triangleScore(numTriangles);
+		std::vector<bool> emitted(numTriangles, false);
+		for (int t = 0; t < numTriangles; t++) {
+			triangleScore[t] = score[mesh.indices[t * 3]] + score[mesh.indices[t * 3 + 1]] + score[mesh.indices[t * 3 + 2]];
+		}
+
+		std::vector<unsigned int> result;
+		result.reserve(numTriangles * 3);
+		int cache[MAX_CACHE_SIZE + 3];
+		int cacheCount = 0;
+		int bestTriangle = 0;
+		int scanCursor = 0;
+
+		for (int emittedCount = 0; emittedCount < numTriangles; emittedCount++)
+		{
+			if (bestTriangle < 0) {
+				//Nothing adjacent to the cache, take the next triangle in order
+				while (emitted[scanCursor]) {
+					scanCursor++;
+				}
+				bestTriangle = scanCursor;
+			}
+			int t = bestTriangle;
+			emitted[t] = true;
+
+			//Emitted vertices go to the front of the LRU, the rest shift back
+			int newCache[MAX_CACHE_SIZE + 3];
+			int newCount = 0;
+			for (int k = 0; k < 3; k++)
+			{
+				unsigned int v = mesh.indices[t * 3 + k];
+				result.push_back(v);
+				newCache[newCount++] = v;
+				//Remove this triangle from the vertex's adjacency
+				int begin = adjacencyStart[v];
+				int end = begin + remaining[v];
+				for (int a = begin; a < end; a++) {
+					if (adjacency[a] == t) {
+						adjacency[a] = adjacency[end - 1];
+						break;
+					}
+				}
+				remaining[v]--;
+			}
+			for (int c = 0; c < cacheCount; c++)
+			{
+				int v = cache[c];
+				if (v != (int)mesh.indices[t * 3] && v != (int)mesh.indices[t * 3 + 1] && v != (int)mesh.indices[t * 3 + 2]) {
+					newCache[newCount++] = v;
+				}
+			}
+			//Rescore everything that was or is in the cache, and the triangles around it
+			bestTriangle = -1;
+			float bestScore = -1.0f;
+			for (int c = 0; c < newCount; c++)
+			{
+				int v = newCache[c];
+				cachePosition[v] = c < cacheSize ? c : -1;
+				float newScore = vertexScore(cachePosition[v], remaining[v], cacheSize);
+				float delta = newScore - score[v];
+				score[v] = newScore;
+				for (int a = adjacencyStart[v]; a < adjacencyStart[v] + remaining[v]; a++)
+				{
+					int other = adjacency[a];
+					triangleScore[other] += delta;
+					if (triangleScore[other] > bestScore) {
+						bestScore = triangleScore[other];
+						bestTriangle = other;
+					}
+				}
+			}
+			cacheCount = newCount < cacheSize ? newCount : cacheSize;
+			for (int c = 0; c < cacheCount; c++) {
+				cache[c] = newCache[c];
+			}
+		}
+		mesh.indices.swap(result);
+		if (AnalyzeVertexCache(mesh, cacheSize).acmr >= originalAcmr) {
+			mesh.indices.swap(result);
+		}
+	}
+	/// <summary>
+	/// Sorts clusters of triangles so outward facing ones draw first, which lets early z reject more
+	/// of what is behind them (after Sander et al., "Fast Triangle Reordering"). Run after OptimizeVertexCache.
+	/// Clusters are split where the cache is flushed anyway, and inside those wherever a cluster drawn
+	/// from a cold cache would still be within acmrThreshold of the cache optimized order.
+	/// The new order is kept only if ACMR grows by less than acmrThreshold. Triangle lists only.
+	/// </summary>
+	/// <returns>Number of clusters sorted, 0 if the order was kept</returns>
+	int OptimizeOverdraw(MeshData& mesh, float acmrThreshold, int cacheSize)
+	{
+		int numTriangles = (int)mesh.indices.size() / 3;
+		if (numTriangles < 2 || mesh.topology != Topology::TRIANGLES) {
+			return 0;
+		}
+		cacheSize = cacheSize < MAX_CACHE_SIZE ? cacheSize : MAX_CACHE_SIZE;
+		float originalAcmr = AnalyzeVertexCache(mesh, cacheSize).acmr;
+
+		std::vector<int> insertedAt(mesh.vertices.size(), -MAX_CACHE_SIZE - 1);
+		int transformed = 0;
+		auto triangleMisses = [&](int t) {
+			int misses = 0;
+			for (int k = 0; k < 3; k++)
+			{
+				unsigned int v = mesh.indices[t * 3 + k];
+				if (transformed - insertedAt[v] > cacheSize) {
+					insertedAt[v] = transformed++;
+					misses++;
+				}
+			}
+			return misses;
+		};
+
+		//Hard boundaries: the cache simulation says the working set was replaced (a triangle with 3 misses)
+		std::vector<int> hardStarts;
+		std::vector<int> hardMisses;
+		for (int t = 0; t < numTriangles; t++)
+		{
+			int misses = triangleMisses(t);
+			if (t == 0 || misses == 3) {
+				hardStarts.push_back(t);
+				hardMisses.push_back(0);
+			}
+			hardMisses.back() += misses;
+		}
+		hardStarts.push_back(numTriangles);
+
+		//Soft boundaries (Tipsify): walk each hard cluster from a cold cache and split as soon as
+		//the running ACMR is back within acmrThreshold of the hard cluster's, so splitting costs little
+		std::vector<int> clusterStarts;
+		for (size_t h = 0; h + 1 < hardStarts.size(); h++)
+		{
+			int begin = hardStarts[h];
+			int end = hardStarts[h + 1];
+			float threshold = (float)hardMisses[h] / (end - begin) * acmrThreshold;
+			int start = begin;
+			int misses = 0;
+			transformed += cacheSize + 1;
+			clusterStarts.push_back(begin);
+			for (int t = begin; t < end - 1; t++)
+			{
+				misses += triangleMisses(t);
+				if ((float)misses / (t + 1 - start) <= threshold) {
+					start = t + 1;
+					misses = 0;
+					//Flush, so the next cluster is measured as if it were drawn on its own
+					transformed += cacheSize + 1;
+					clusterStarts.push_back(start);
+				}
+			}
+		}
+		clusterStarts.push_back(numTriangles);
+		int numClusters = (int)clusterStarts.size() - 1;
+		if (numClusters < 2) {
+			return 0;
+		}
+
+		//Area weighted centroid and normal of each cluster
+		ew::Vec3 meshCentroid = ew::Vec3(0);
+		float meshArea = 0;
+		std::vector<ew::Vec3> clusterCentroid(numClusters), clusterNormal(numClusters);
+		for (int c = 0; c < numClusters; c++)
+		{
+			ew::Vec3 centroid = ew::Vec3(0);
+			ew::Vec3 normal = ew::Vec3(0);
+			float area = 0;
+			for (int t = clusterStarts[c]; t < clusterStarts[c + 1]; t++)
+			{
+				const ew::Vec3& a = mesh.vertices[mesh.indices[t * 3]].pos;
+				const ew::Vec3& b = mesh.vertices[mesh.indices[t * 3 + 1]].pos;
+				const ew::Vec3& d = mesh.vertices[mesh.indices[t * 3 + 2]].pos;
+				ew::Vec3 n = ew::Cross(b - a, d - a);
+				float triangleArea = ew::Magnitude(n) * 0.5f;
+				centroid += (a + b + d) * (triangleArea / 3.0f);
+				normal += n;
+				area += triangleArea;
+			}
+			clusterCentroid[c] = area > 0 ? centroid / area : mesh.vertices[mesh.indices[clusterStarts[c] * 3]].pos;
+			float length = ew::Magnitude(normal);
+			clusterNormal[c] = length > 0 ? normal / length : ew::Vec3(0);
+			meshCentroid += centroid;
+			meshArea += area;
+		}
+		meshCentroid = meshArea > 0 ? meshCentroid / meshArea : ew::Vec3(0);
+
+		//Clusters facing away from the center are most likely to occlude the rest
+		std::vector<float> sortKey(numClusters);
+		std::vector<int> order(numClusters);
+		for (int c = 0; c < numClusters; c++)
+		{
+			sortKey[c] = ew::Dot(clusterCentroid[c] - meshCentroid, clusterNormal[c]);
+			order[c] = c;
+		}
+		std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return sortKey[a] > sortKey[b]; });
+
+		std::vector<unsigned int> sorted;
+		sorted.reserve(mesh.indices.size());
+		for (int i = 0; i < numClusters; i++)
+		{
+			int c = order[i];
+			sorted.insert(sorted.end(), mesh.indices.begin() + clusterStarts[c] * 3, mesh.indices.begin() + clusterStarts[c + 1] * 3);
+		}
+		sorted.swap(mesh.indices);
+		if (AnalyzeVertexCache(mesh, cacheSize).acmr > originalAcmr * acmrThreshold) {
+			sorted.swap(mesh.indices);
+			return 0;
+		}
+		return numClusters;
+	}
+	/// <summary>
+	/// Renumbers vertices in the order the index buffer first uses them, so vertex fetch walks memory forwards.
+	/// Unused vertices move to the end.
+	/// </summary>
+	void OptimizeVertexFetch(MeshData& mesh)
+	{
+		int numVertices = (int)mesh.vertices.size();
+		std::vector<int> remap(numVertices, -1);
+		std::vector<Vertex> vertices;
+		vertices.reserve(numVertices);
+		for (size_t i = 0; i < mesh.indices.size(); i++)
+		{
+			unsigned int v = mesh.indices[i];
+			if (v == PRIMITIVE_RESTART) {
+				continue;
+			}
+			if (remap[v] < 0) {
+				remap[v] = (int)vertices.size();
+				vertices.push_back(mesh.vertices[v]);
+			}
+			mesh.indices[i] = remap[v];
+		}
+		for (int v = 0; v < numVertices; v++) {
+			if (remap[v] < 0) {
+				vertices.push_back(mesh.vertices[v]);
+			}
+		}
+		mesh.vertices.swap(vertices);
+	}
+	/// <summary>
+	/// Vertex cache, then optionally overdraw, then vertex fetch order. The mesh looks the same, it just draws faster.
+	/// </summary>
+	void OptimizeMesh(MeshData& mesh, bool overdraw)
+	{
+		OptimizeVertexCache(mesh);
+		if (overdraw) {
+			OptimizeOverdraw(mesh);
+		}
+		OptimizeVertexFetch(mesh);
+	}
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include "mesh.h"
+
+namespace ew {
+	//Post transform cache simulation of an index buffer
+	struct VertexCacheStats {
+		float acmr = 0; //Average cache miss ratio: transformed vertices per triangle. 0.5 is ideal for large grids, 3 is worst.
+		float atvr = 0; //Average transform to vertex ratio: transformed / referenced vertices. 1 is ideal.
+		float overfetch = 0; //Vertex buffer bytes read / vertex buffer size, with 64 byte cache lines. 1 is ideal.
+		int transformed = 0;
+	};
+
+	VertexCacheStats AnalyzeVertexCache(const MeshData& mesh, int cacheSize = 32);
+	void OptimizeVertexCache(MeshData& mesh, int cacheSize = 32);
+	int OptimizeOverdraw(MeshData& mesh, float acmrThreshold = 1.05f, int cacheSize = 32);
+	void OptimizeVertexFetch(MeshData& mesh);
+	void OptimizeMesh(MeshData& mesh, bool overdraw = true);
+}
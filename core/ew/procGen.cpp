@@ -4,6 +4,7 @@
 
 
 #include "procGen.h"
+#include "threadPool.h"
 #include <stdlib.h>
 
 namespace ew {
@@ -55,111 +56,204 @@ namespace ew {
 		createCubeFace(ew::Vec3{ -1.0f,+0.0f,+0.0f }, size, &mesh); //Left
 		createCubeFace(ew::Vec3{ +0.0f,-1.0f,+0.0f }, size, &mesh); //Bottom
 		createCubeFace(ew::Vec3{ +0.0f,+0.0f,-1.0f }, size, &mesh); //Back
+		mesh.bounds = ew::ComputeBounds(mesh.vertices);
 		return mesh;
 	}
-	MeshData createPlane(float width, float height, int subdivisions)
+	//Runs body over row ranges, on the pool when there is one and the mesh is big enough to be worth it
+	static void forRows(ThreadPool* pool, int begin, int end, int verticesPerRow, const std::function<void(int, int)>& body) {
+		const int MIN_VERTICES_PER_RANGE = 16384;
+		if (pool) {
+			int minRows = MIN_VERTICES_PER_RANGE / (verticesPerRow > 0 ? verticesPerRow : 1);
+			pool->parallelFor(begin, end, body, minRows > 0 ? minRows : 1);
+		}
+		else {
+			body(begin, end);
+		}
+	}
+	//Analytic bounds, so large meshes don't need another pass over their vertices
+	static Bounds boxBounds(ew::Vec3 min, ew::Vec3 max) {
+		Bounds bounds;
+		bounds.min = min;
+		bounds.max = max;
+		bounds.center = (min + max) * 0.5f;
+		bounds.radius = ew::Magnitude(max - bounds.center);
+		return bounds;
+	}
+	/// <summary>
+	/// Creates a subdivided plane on XZ facing +Y
+	/// </summary>
+	/// <param name="pool">Optional. Splits rows across its threads.</param>
+	/// <param name="topology">TRIANGLE_STRIP emits one strip per row, about a third of the indices</param>
+	MeshData createPlane(float width, float height, int subdivisions, ThreadPool* pool, Topology topology)
 	{
-		//VERTICES
 		MeshData mesh;
+		mesh.topology = topology;
 		int columns = subdivisions + 1;
-		for (size_t row = 0; row <= subdivisions; row++)
-		{
-			for (size_t col = 0; col <= subdivisions; col++)
-			{
-				Vertex v;
-				v.uv.x = ((float)col / subdivisions);
-				v.uv.y = ((float)row / subdivisions);
-				v.pos.x = -width/2 + width * v.uv.x;
-				v.pos.y = 0;
-				v.pos.z = height/2 -height * v.uv.y;
-				v.normal = ew::Vec3(0, 1, 0);
-				mesh.vertices.push_back(v);
-			}
+		mesh.vertices.resize((size_t)columns * columns);
+		if (topology == Topology::TRIANGLE_STRIP) {
+			mesh.indices.resize(subdivisions > 0 ? (size_t)subdivisions * (columns * 2 + 1) - 1 : 0);
 		}
-		//INDICES
-		for (size_t row = 0; row < subdivisions; row++)
-		{
-			for (size_t col = 0; col < subdivisions; col++)
+		else {
+			mesh.indices.resize((size_t)subdivisions * subdivisions * 6);
+		}
+
+		//Column positions are the same for every row
+		std::vector<float> u(columns);
+		for (int col = 0; col <= subdivisions; col++) {
+			u[col] = (float)col / subdivisions;
+		}
+		//VERTICES
+		forRows(pool, 0, columns, columns, [&](int rowBegin, int rowEnd) {
+			for (int row = rowBegin; row < rowEnd; row++)
 			{
-				int start = row * columns + col;
-				mesh.indices.push_back(start);
-				mesh.indices.push_back(start + 1);
-				mesh.indices.push_back(start + columns + 1);
-				mesh.indices.push_back(start + columns + 1);
-				mesh.indices.push_back(start + columns);
-				mesh.indices.push_back(start);
+				Vertex* v = &mesh.vertices[(size_t)row * columns];
+				float vCoord = (float)row / subdivisions;
+				float z = height / 2 - height * vCoord;
+				for (int col = 0; col <= subdivisions; col++, v++)
+				{
+					v->uv.x = u[col];
+					v->uv.y = vCoord;
+					v->pos.x = -width / 2 + width * u[col];
+					v->pos.y = 0;
+					v->pos.z = z;
+					v->normal = ew::Vec3(0, 1, 0);
+				}
 			}
+		});
+		//INDICES
+		if (topology == Topology::TRIANGLE_STRIP) {
+			forRows(pool, 0, subdivisions, columns, [&](int rowBegin, int rowEnd) {
+				for (int row = rowBegin; row < rowEnd; row++)
+				{
+					unsigned int* index = &mesh.indices[(size_t)row * (columns * 2 + 1)];
+					for (int col = 0; col <= subdivisions; col++)
+					{
+						//Next row first keeps the same winding as the triangle list
+						*index++ = (row + 1) * columns + col;
+						*index++ = row * columns + col;
+					}
+					if (row < subdivisions - 1) {
+						*index = PRIMITIVE_RESTART;
+					}
+				}
+			});
 		}
+		else {
+			forRows(pool, 0, subdivisions, columns, [&](int rowBegin, int rowEnd) {
+				for (int row = rowBegin; row < rowEnd; row++)
+				{
+					unsigned int* index = &mesh.indices[(size_t)row * subdivisions * 6];
+					for (int col = 0; col < subdivisions; col++)
+					{
+						unsigned int start = row * columns + col;
+						*index++ = start;
+						*index++ = start + 1;
+						*index++ = start + columns + 1;
+						*index++ = start + columns + 1;
+						*index++ = start + columns;
+						*index++ = start;
+					}
+				}
+			});
+		}
+		mesh.bounds = boxBounds(ew::Vec3(-width / 2, 0, -height / 2), ew::Vec3(width / 2, 0, height / 2));
 		return mesh;
 	}
 
-	MeshData createSphere(float radius, int subdivisions)
+	/// <summary>
+	/// Creates a UV sphere
+	/// </summary>
+	/// <param name="pool">Optional. Splits rows across its threads.</param>
+	MeshData createSphere(float radius, int subdivisions, ThreadPool* pool)
 	{
 		MeshData mesh;
+		unsigned int columns = subdivisions + 1;
+		int sideRows = subdivisions > 2 ? subdivisions - 2 : 0;
+		mesh.vertices.resize((size_t)columns * columns);
+		mesh.indices.resize((size_t)subdivisions * 6 + (size_t)sideRows * subdivisions * 6);
+
 		//VERTICES
 		float thetaStep = ew::TAU / subdivisions;
 		float phiStep = ew::PI / subdivisions;
-		for (size_t row = 0; row <= subdivisions; row++)
+		std::vector<float> cosTheta(columns), sinTheta(columns), u(columns);
+		for (unsigned int col = 0; col < columns; col++)
 		{
-			float phi = row * phiStep;
-			for (size_t col = 0; col <= subdivisions; col++)
+			float theta = thetaStep * col;
+			cosTheta[col] = cosf(theta);
+			sinTheta[col] = sinf(theta);
+			u[col] = (float)col / subdivisions;
+		}
+		forRows(pool, 0, columns, columns, [&](int rowBegin, int rowEnd) {
+			for (int row = rowBegin; row < rowEnd; row++)
 			{
-				float theta = thetaStep * col;
-				Vertex v;
-				v.normal.x = cosf(theta) * sinf(phi);
-				v.normal.y = cosf(phi);
-				v.normal.z = sinf(theta) * sinf(phi);
-				v.pos = v.normal * radius;
-				v.uv.x = (float)col / subdivisions;
-				v.uv.y = 1.0 - ((float)row / subdivisions);
-				mesh.vertices.push_back(v);
+				float phi = row * phiStep;
+				float sinPhi = sinf(phi);
+				float cosPhi = cosf(phi);
+				float vCoord = 1.0 - ((float)row / subdivisions);
+				Vertex* v = &mesh.vertices[(size_t)row * columns];
+				for (unsigned int col = 0; col < columns; col++, v++)
+				{
+					v->normal.x = cosTheta[col] * sinPhi;
+					v->normal.y = cosPhi;
+					v->normal.z = sinTheta[col] * sinPhi;
+					v->pos = v->normal * radius;
+					v->uv.x = u[col];
+					v->uv.y = vCoord;
+				}
 			}
-		}
-		
+		});
+
 		//INDICES
-		unsigned int columns = subdivisions + 1;
+		unsigned int* index = mesh.indices.data();
 		unsigned int sideStart = columns;
 		unsigned int poleStart = 0;
 		//Top cap
-		for (size_t i = 0; i < subdivisions; i++)
+		for (int i = 0; i < subdivisions; i++)
 		{
-			mesh.indices.push_back(sideStart + i);
-			mesh.indices.push_back(poleStart + i);
-			mesh.indices.push_back(sideStart +i+1);
+			*index++ = sideStart + i;
+			*index++ = poleStart + i;
+			*index++ = sideStart + i + 1;
 		}
 		//Rows of quads for sides
-		for (size_t row = 1; row < subdivisions - 1; row++)
-		{
-			for (size_t col = 0; col < subdivisions; col++)
+		unsigned int* sideIndices = index;
+		forRows(pool, 1, 1 + sideRows, columns, [&](int rowBegin, int rowEnd) {
+			for (int row = rowBegin; row < rowEnd; row++)
 			{
-				int start = row * columns + col;
-				mesh.indices.push_back(start);
-				mesh.indices.push_back(start + 1);
-				mesh.indices.push_back(start + columns);
-				mesh.indices.push_back(start + columns);
-				mesh.indices.push_back(start + 1);
-				mesh.indices.push_back(start + columns + 1);
+				unsigned int* rowIndex = sideIndices + (size_t)(row - 1) * subdivisions * 6;
+				for (int col = 0; col < subdivisions; col++)
+				{
+					unsigned int start = row * columns + col;
+					*rowIndex++ = start;
+					*rowIndex++ = start + 1;
+					*rowIndex++ = start + columns;
+					*rowIndex++ = start + columns;
+					*rowIndex++ = start + 1;
+					*rowIndex++ = start + columns + 1;
+				}
 			}
-		}
+		});
+		index += (size_t)sideRows * subdivisions * 6;
 		//Bottom cap
 		poleStart = (columns * columns) - columns;
 		sideStart = poleStart - columns;
-		for (size_t i = 0; i < subdivisions; i++)
+		for (int i = 0; i < subdivisions; i++)
 		{
-			mesh.indices.push_back(sideStart + i);
-			mesh.indices.push_back(sideStart + i + 1);
-			mesh.indices.push_back(poleStart + i);
+			*index++ = sideStart + i;
+			*index++ = sideStart + i + 1;
+			*index++ = poleStart + i;
 		}
+		mesh.bounds = boxBounds(ew::Vec3(-radius), ew::Vec3(radius));
+		//The box's corners are outside the sphere, so its bounding sphere is just the sphere
+		mesh.bounds.radius = radius;
 		return mesh;
 	}
-	void createCylinderRing(MeshData* meshData, float radius, int subdivisions, float y, bool sideFacing) {
-		float thetaStep = ew::TAU / subdivisions;
-		for (size_t i = 0; i <= subdivisions; i++)
+	//Writes one ring of subdivisions + 1 vertices
+	static void createCylinderRing(Vertex* vertices, const float* cosTable, const float* sinTable, float radius, int subdivisions, float y, bool sideFacing) {
+		for (int i = 0; i <= subdivisions; i++)
 		{
-			float theta = i * thetaStep;
-			float cosA = cosf(theta);
-			float sinA = sinf(theta);
-			ew::Vertex v;
+			float cosA = cosTable[i];
+			float sinA = sinTable[i];
+			ew::Vertex& v = vertices[i];
 			v.pos = ew::Vec3(cosA * radius, y, sinA * radius);
 			if (sideFacing) {
 				v.normal = ew::Vec3(cosA, 0, sinA);
@@ -169,70 +263,81 @@ namespace ew {
 				v.normal = ew::Vec3(0, ew::Sign(y), 0);
 				v.uv = ew::Vec2(cosA * 0.5 + 0.5, sinA * 0.5 + 0.5);
 			}
-
-			meshData->vertices.push_back(v);
 		}
 	}
 	MeshData createCylinder(float radius, float height, int subdivisions)
 	{
 		MeshData mesh;
+		int columns = subdivisions + 1;
+		mesh.vertices.resize(2 + (size_t)columns * 4);
+		mesh.indices.resize((size_t)columns * 12);
 
 		//VERTICES
 		{
 			const float topY = height * 0.5;
 			const float bottomY = -topY;
 
-			ew::Vertex topVertex;
+			//All 4 rings share one angle table
+			float thetaStep = ew::TAU / subdivisions;
+			std::vector<float> cosTable(columns), sinTable(columns);
+			for (int i = 0; i < columns; i++)
+			{
+				float theta = i * thetaStep;
+				cosTable[i] = cosf(theta);
+				sinTable[i] = sinf(theta);
+			}
+
+			ew::Vertex& topVertex = mesh.vertices[0];
 			topVertex.pos = ew::Vec3(0, topY, 0);
 			topVertex.normal = ew::Vec3(0, 1, 0);
 			topVertex.uv = ew::Vec2(0.5);
-			mesh.vertices.push_back(topVertex);
 
-			createCylinderRing(&mesh, radius, subdivisions, topY, false);
-			createCylinderRing(&mesh, radius, subdivisions, topY, true);
-			createCylinderRing(&mesh, radius, subdivisions, bottomY, true);
-			createCylinderRing(&mesh, radius, subdivisions, bottomY, false);
+			createCylinderRing(&mesh.vertices[1], cosTable.data(), sinTable.data(), radius, subdivisions, topY, false);
+			createCylinderRing(&mesh.vertices[1 + columns], cosTable.data(), sinTable.data(), radius, subdivisions, topY, true);
+			createCylinderRing(&mesh.vertices[1 + columns * 2], cosTable.data(), sinTable.data(), radius, subdivisions, bottomY, true);
+			createCylinderRing(&mesh.vertices[1 + columns * 3], cosTable.data(), sinTable.data(), radius, subdivisions, bottomY, false);
 
-			ew::Vertex bottomVertex;
+			ew::Vertex& bottomVertex = mesh.vertices.back();
 			bottomVertex.pos = ew::Vec3(0, bottomY, 0);
 			bottomVertex.normal = ew::Vec3(0, -1, 0);
 			bottomVertex.uv = ew::Vec2(0.5);
-			mesh.vertices.push_back(bottomVertex);
 		}
-		
 
 		//INDICES
 		{
-			int columns = subdivisions + 1;
+			unsigned int* index = mesh.indices.data();
 			//Top cap
-			for (size_t i = 0; i < columns; i++)
+			for (int i = 0; i < columns; i++)
 			{
-				mesh.indices.push_back(0);
-				mesh.indices.push_back(i + 1);
-				mesh.indices.push_back(i);
+				*index++ = 0;
+				*index++ = i + 1;
+				*index++ = i;
 			}
 			int sideStart = columns;
 			//Sides
-			for (size_t i = 0; i < columns; i++)
+			for (int i = 0; i < columns; i++)
 			{
 				int start = sideStart + i;
-				mesh.indices.push_back(start);
-				mesh.indices.push_back(start + 1);
-				mesh.indices.push_back(start + columns);
-				mesh.indices.push_back(start + columns);
-				mesh.indices.push_back(start + 1);
-				mesh.indices.push_back(start + columns + 1);
+				*index++ = start;
+				*index++ = start + 1;
+				*index++ = start + columns;
+				*index++ = start + columns;
+				*index++ = start + 1;
+				*index++ = start + columns + 1;
 			}
 			//Bottom cap
 			int bottomIndex = mesh.vertices.size() - 1;
 			sideStart = bottomIndex - columns;
-			for (size_t i = 0; i < columns; i++)
+			for (int i = 0; i < columns; i++)
 			{
-				mesh.indices.push_back(bottomIndex);
-				mesh.indices.push_back(sideStart + i);
-				mesh.indices.push_back(sideStart + i + 1);
+				*index++ = bottomIndex;
+				*index++ = sideStart + i;
+				*index++ = sideStart + i + 1;
 			}
 		}
+		mesh.bounds = boxBounds(ew::Vec3(-radius, -height * 0.5f, -radius), ew::Vec3(radius, height * 0.5f, radius));
+		//Furthest points are on the cap rims, not the box corners
+		mesh.bounds.radius = sqrtf(radius * radius + height * height / 4);
 		return mesh;
 	}
-}
\ No newline at end of file
+}
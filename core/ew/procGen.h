@@ -7,8 +7,10 @@
 #include "mesh.h"
 
 namespace ew {
+	class ThreadPool;
+
 	MeshData createCube(float size);
-	MeshData createPlane(float width, float height, int subdivisions);
-	MeshData createSphere(float radius, int subdivisions);
+	MeshData createPlane(float width, float height, int subdivisions, ThreadPool* pool = nullptr, Topology topology = Topology::TRIANGLES);
+	MeshData createSphere(float radius, int subdivisions, ThreadPool* pool = nullptr);
 	MeshData createCylinder(float radius, float height, int subdivisions);
 }
@@ -0,0 +1,387 @@
+#include "profiler.h"
+#include "external/glad.h"
+#include <imgui.h>
+#include <stdio.h>
+#include <string.h>
+#include <float.h>
+#include <chrono>
+#include <algorithm>
+
+namespace ew {
+	namespace {
+		double clockMs() {
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+		//Nearest rank on sorted samples
+		ProfileTimes summarize(std::vector<float>& samples) {
+			ProfileTimes times;
+			if (samples.empty()) {
+				return times;
+			}
+			std::sort(samples.begin(), samples.end());
+			double sum = 0;
+			for (float s : samples) {
+				sum += s;
+			}
+			int last = (int)samples.size() - 1;
+			times.average = (float)(sum / samples.size());
+			times.p50 = samples[(int)(last * 0.50f + 0.5f)];
+			times.p95 = samples[(int)(last * 0.95f + 0.5f)];
+			times.p99 = samples[(int)(last * 0.99f + 0.5f)];
+			times.max = samples[last];
+			return times;
+		}
+		void writeJsonString(FILE* f, const char* s) {
+			fputc('"', f);
+			for (; *s; s++) {
+				if (*s == '"' || *s == '\\') {
+					fputc('\\', f);
+				}
+				fputc(*s, f);
+			}
+			fputc('"', f);
+		}
+	}
+
+	Profiler::Profiler()
+	{
+		m_frames.resize(PROFILER_HISTORY);
+		for (int i = 0; i < PROFILER_LATENCY; i++) {
+			m_pendingFrame[i] = -1;
+		}
+		m_epoch = clockMs();
+	}
+	Profiler::~Profiler()
+	{
+		for (int i = 0; i < PROFILER_LATENCY; i++) {
+			if (!m_queries[i].empty()) {
+				glDeleteQueries((GLsizei)m_queries[i].size(), m_queries[i].data());
+			}
+		}
+	}
+	double Profiler::now()const
+	{
+		return clockMs() - m_epoch;
+	}
+	int Profiler::allocQueries()
+	{
+		int slot = m_frameCount % PROFILER_LATENCY;
+		std::vector<unsigned int>& pool = m_queries[slot];
+		int query = m_queriesUsed[slot];
+		if (query + 2 > (int)pool.size()) {
+			pool.resize(query + 2);
+			glGenQueries(2, pool.data() + query);
+		}
+		m_queriesUsed[slot] += 2;
+		return query;
+	}
+	/// <summary>
+	/// Reads the GPU timestamps of the frame waiting on a slot.
+	/// </summary>
+	/// <param name="wait">Block until they're available. Otherwise a frame that isn't done is dropped.</param>
+	void Profiler::resolve(int slot, bool wait)
+	{
+		int frameIndex = m_pendingFrame[slot];
+		if (frameIndex < 0) {
+			return;
+		}
+		m_pendingFrame[slot] = -1;
+		Frame& frame = m_frames[frameIndex % PROFILER_HISTORY];
+		frame.resolved = true;
+		const std::vector<unsigned int>& pool = m_queries[slot];
+		int used = m_queriesUsed[slot];
+		if (used == 0) {
+			return;
+		}
+		if (!wait) {
+			//Timestamps complete in order, so the frame's last one stands for all of them
+			GLuint available = 0;
+			glGetQueryObjectuiv(pool[1], GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available) {
+				return;
+			}
+		}
+		std::vector<GLuint64> timestamps(used);
+		for (int i = 0; i < used; i++) {
+			glGetQueryObjectui64v(pool[i], GL_QUERY_RESULT, &timestamps[i]);
+		}
+		GLuint64 start = timestamps[0];
+		frame.gpuMs = (timestamps[1] - start) / 1e6;
+		for (Event& e : frame.events) {
+			if (e.query >= 0) {
+				e.gpuStart = (timestamps[e.query] - start) / 1e6;
+				e.gpuEnd = (timestamps[e.query + 1] - start) / 1e6;
+			}
+		}
+	}
+	void Profiler::beginFrame()
+	{
+		if (m_inFrame) {
+			endFrame();
+		}
+		int slot = m_frameCount % PROFILER_LATENCY;
+		resolve(slot, false);
+		m_queriesUsed[slot] = 0;
+		m_pendingFrame[slot] = m_frameCount;
+
+		Frame& frame = m_frames[m_frameCount % PROFILER_HISTORY];
+		frame.events.clear();
+		frame.gpuMs = -1;
+		frame.resolved = false;
+		m_stack.clear();
+		m_inFrame = true;
+		m_frameGpu = gpuTimers;
+		frame.cpuStart = now();
+		//The frame's own pair is always queries 0 and 1
+		if (m_frameGpu) {
+			allocQueries();
+			glQueryCounter(m_queries[slot][0], GL_TIMESTAMP);
+		}
+	}
+	void Profiler::endFrame()
+	{
+		if (!m_inFrame) {
+			return;
+		}
+		while (!m_stack.empty()) {
+			endScope(m_stack.back());
+		}
+		Frame& frame = m_frames[m_frameCount % PROFILER_HISTORY];
+		if (m_frameGpu) {
+			glQueryCounter(m_queries[m_frameCount % PROFILER_LATENCY][1], GL_TIMESTAMP);
+		}
+		frame.cpuEnd = now();
+		m_inFrame = false;
+		m_frameCount++;
+	}
+	int Profiler::findNode(const char* name, int parent, bool gpu)
+	{
+		for (size_t i = 0; i < m_nodes.size(); i++) {
+			if (m_nodes[i].parent == parent && m_nodes[i].name == name) {
+				m_nodes[i].gpuTimed |= gpu;
+				return (int)i;
+			}
+		}
+		Node node;
+		node.name = name;
+		node.parent = parent;
+		node.depth = parent < 0 ? 0 : m_nodes[parent].depth + 1;
+		node.gpuTimed = gpu;
+		m_nodes.push_back(node);
+		return (int)m_nodes.size() - 1;
+	}
+	/// <summary>
+	/// Opens a scope under the innermost open one. Prefer ProfileScope, which closes it.
+	/// </summary>
+	/// <param name="gpu">Also time the GL commands issued inside it</param>
+	/// <returns>Handle for endScope, -1 outside beginFrame/endFrame</returns>
+	int Profiler::beginScope(const char* name, bool gpu)
+	{
+		if (!m_inFrame) {
+			return -1;
+		}
+		Frame& frame = m_frames[m_frameCount % PROFILER_HISTORY];
+		Event e;
+		e.node = findNode(name, m_stack.empty() ? -1 : frame.events[m_stack.back()].node, gpu);
+		e.cpuStart = now();
+		if (gpu && m_frameGpu) {
+			e.query = allocQueries();
+			glQueryCounter(m_queries[m_frameCount % PROFILER_LATENCY][e.query], GL_TIMESTAMP);
+		}
+		frame.events.push_back(e);
+		m_stack.push_back((int)frame.events.size() - 1);
+		return m_stack.back();
+	}
+	void Profiler::endScope(int scope)
+	{
+		if (scope < 0 || !m_inFrame || std::find(m_stack.begin(), m_stack.end(), scope) == m_stack.end()) {
+			return;
+		}
+		//Anything opened inside it and left open ends with it
+		while (m_stack.back() != scope) {
+			endScope(m_stack.back());
+		}
+		m_stack.pop_back();
+		Event& e = m_frames[m_frameCount % PROFILER_HISTORY].events[scope];
+		if (e.query >= 0) {
+			glQueryCounter(m_queries[m_frameCount % PROFILER_LATENCY][e.query + 1], GL_TIMESTAMP);
+		}
+		e.cpuEnd = now();
+	}
+	void Profiler::finish()
+	{
+		if (m_inFrame) {
+			endFrame();
+		}
+		for (int i = 0; i < PROFILER_LATENCY; i++) {
+			resolve(i, true);
+		}
+	}
+	/// <summary>
+	/// Per scope times over the finished frames in the history, parents before their children.
+	/// The first entry is the whole frame.
+	/// </summary>
+	std::vector<ProfileScopeStats> Profiler::getStats()const
+	{
+		int firstFrame = std::max(0, m_frameCount - PROFILER_HISTORY);
+		size_t numNodes = m_nodes.size();
+		std::vector<std::vector<float>> cpuSamples(numNodes + 1), gpuSamples(numNodes + 1);
+		std::vector<double> cpuSum(numNodes), gpuSum(numNodes);
+		std::vector<char> seen(numNodes);
+		for (int i = firstFrame; i < m_frameCount; i++) {
+			const Frame& frame = m_frames[i % PROFILER_HISTORY];
+			std::fill(cpuSum.begin(), cpuSum.end(), 0.0);
+			std::fill(gpuSum.begin(), gpuSum.end(), 0.0);
+			std::fill(seen.begin(), seen.end(), 0);
+			for (const Event& e : frame.events) {
+				cpuSum[e.node] += e.cpuEnd - e.cpuStart;
+				gpuSum[e.node] += e.gpuStart >= 0 ? e.gpuEnd - e.gpuStart : 0;
+				seen[e.node] = 1;
+			}
+			bool gpuValid = frame.gpuMs >= 0;
+			for (size_t n = 0; n < numNodes; n++) {
+				if (seen[n]) {
+					cpuSamples[n + 1].push_back((float)cpuSum[n]);
+					if (gpuValid && m_nodes[n].gpuTimed) {
+						gpuSamples[n + 1].push_back((float)gpuSum[n]);
+					}
+				}
+			}
+			cpuSamples[0].push_back((float)(frame.cpuEnd - frame.cpuStart));
+			if (gpuValid) {
+				gpuSamples[0].push_back((float)frame.gpuMs);
+			}
+		}
+
+		std::vector<ProfileScopeStats> stats;
+		ProfileScopeStats frameStats;
+		frameStats.name = "Frame";
+		frameStats.cpu = summarize(cpuSamples[0]);
+		frameStats.gpu = summarize(gpuSamples[0]);
+		frameStats.gpuTimed = true;
+		stats.push_back(frameStats);
+		//Depth first, siblings in the order they first ran
+		std::vector<int> open;
+		for (int n = (int)numNodes - 1; n >= 0; n--) {
+			if (m_nodes[n].parent < 0) {
+				open.push_back(n);
+			}
+		}
+		while (!open.empty()) {
+			int n = open.back();
+			open.pop_back();
+			ProfileScopeStats s;
+			s.name = m_nodes[n].name;
+			s.depth = m_nodes[n].depth + 1;
+			s.cpu = summarize(cpuSamples[n + 1]);
+			s.gpu = summarize(gpuSamples[n + 1]);
+			s.gpuTimed = m_nodes[n].gpuTimed;
+			stats.push_back(s);
+			for (int child = (int)numNodes - 1; child > n; child--) {
+				if (m_nodes[child].parent == n) {
+					open.push_back(child);
+				}
+			}
+		}
+		return stats;
+	}
+	/// <summary>
+	/// Writes the finished frames in the history in Chrome's trace event format, for chrome://tracing or Perfetto.
+	/// CPU scopes are on one track and GPU scopes on another. The GPU clock isn't the CPU clock, so each frame's
+	/// GPU track is lined up to start with its CPU frame.
+	/// </summary>
+	bool Profiler::writeChromeTrace(const char* filePath)const
+	{
+		FILE* f = fopen(filePath, "w");
+		if (f == NULL) {
+			printf("Failed to open %s for writing\n", filePath);
+			return false;
+		}
+		fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+		fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n");
+		fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}");
+		//Chrome wants microseconds
+		auto writeEvent = [&](const char* name, int track, double startMs, double durationMs) {
+			fprintf(f, ",\n{\"name\":");
+			writeJsonString(f, name);
+			fprintf(f, ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", track, startMs * 1000.0, durationMs * 1000.0);
+		};
+		for (int i = std::max(0, m_frameCount - PROFILER_HISTORY); i < m_frameCount; i++) {
+			const Frame& frame = m_frames[i % PROFILER_HISTORY];
+			writeEvent("Frame", 1, frame.cpuStart, frame.cpuEnd - frame.cpuStart);
+			if (frame.gpuMs >= 0) {
+				writeEvent("Frame", 2, frame.cpuStart, frame.gpuMs);
+			}
+			for (const Event& e : frame.events) {
+				const char* name = m_nodes[e.node].name.c_str();
+				writeEvent(name, 1, e.cpuStart, e.cpuEnd - e.cpuStart);
+				if (frame.gpuMs >= 0 && e.gpuStart >= 0) {
+					writeEvent(name, 2, frame.cpuStart + e.gpuStart, e.gpuEnd - e.gpuStart);
+				}
+			}
+		}
+		fprintf(f, "\n]}\n");
+		fclose(f);
+		return true;
+	}
+	void Profiler::drawUI()
+	{
+		int firstFrame = std::max(0, m_frameCount - PROFILER_HISTORY);
+		std::vector<float> cpuGraph, gpuGraph;
+		for (int i = firstFrame; i < m_frameCount; i++) {
+			const Frame& frame = m_frames[i % PROFILER_HISTORY];
+			cpuGraph.push_back((float)(frame.cpuEnd - frame.cpuStart));
+			if (frame.gpuMs >= 0) {
+				gpuGraph.push_back((float)frame.gpuMs);
+			}
+		}
+		char overlay[32];
+		snprintf(overlay, sizeof(overlay), "%.2f ms", cpuGraph.empty() ? 0.0f : cpuGraph.back());
+		ImGui::PlotLines("CPU frame", cpuGraph.data(), (int)cpuGraph.size(), 0, overlay, 0.0f, FLT_MAX, ImVec2(0, 60));
+		snprintf(overlay, sizeof(overlay), "%.2f ms", gpuGraph.empty() ? 0.0f : gpuGraph.back());
+		ImGui::PlotLines("GPU frame", gpuGraph.data(), (int)gpuGraph.size(), 0, overlay, 0.0f, FLT_MAX, ImVec2(0, 60));
+
+		ImGui::Checkbox("GPU timers", &gpuTimers);
+		std::vector<ProfileScopeStats> stats = getStats();
+		ImGui::Text("Last %d frames, ms", m_frameCount - firstFrame);
+		if (ImGui::BeginTable("ProfilerScopes", 9, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+			const char* columns[9] = { "Scope", "CPU avg", "p50", "p95", "p99", "GPU avg", "p50", "p95", "p99" };
+			for (int i = 0; i < 9; i++) {
+				ImGui::TableSetupColumn(columns[i]);
+			}
+			ImGui::TableHeadersRow();
+			for (const ProfileScopeStats& s : stats) {
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				ImGui::Text("%*s%s", s.depth * 2, "", s.name.c_str());
+				const ProfileTimes* sides[2] = { &s.cpu, &s.gpu };
+				for (int side = 0; side < 2; side++) {
+					float values[4] = { sides[side]->average, sides[side]->p50, sides[side]->p95, sides[side]->p99 };
+					for (int v = 0; v < 4; v++) {
+						ImGui::TableNextColumn();
+						if (side == 1 && !s.gpuTimed) {
+							ImGui::TextDisabled("-");
+						}
+						else {
+							ImGui::Text("%.3f", values[v]);
+						}
+					}
+				}
+			}
+			ImGui::EndTable();
+		}
+		if (ImGui::Button("Export Chrome trace")) {
+			const char* path = "profile_trace.json";
+			if (writeChromeTrace(path)) {
+				snprintf(m_traceMessage, sizeof(m_traceMessage), "Wrote %s", path);
+			}
+			else {
+				snprintf(m_traceMessage, sizeof(m_traceMessage), "Failed to write %s", path);
+			}
+		}
+		if (m_traceMessage[0] != '\0') {
+			ImGui::SameLine();
+			ImGui::Text("%s", m_traceMessage);
+		}
+	}
+}
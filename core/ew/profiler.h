@@ -0,0 +1,101 @@
+#pragma once
+#include <vector>
+#include <string>
+
+namespace ew {
+	constexpr int PROFILER_LATENCY = 2; //Frames of GPU queries in flight. A frame's results are read when its slot comes around again.
+	constexpr int PROFILER_HISTORY = 240; //Frames kept for graphs, percentiles and traces
+
+	struct ProfileTimes {
+		float average = 0;
+		float p50 = 0;
+		float p95 = 0;
+		float p99 = 0;
+		float max = 0;
+	};
+
+	//Milliseconds per frame over the history, scopes that run more than once a frame are summed
+	struct ProfileScopeStats {
+		std::string name;
+		int depth = 0;
+		ProfileTimes cpu;
+		ProfileTimes gpu; //All 0 if the scope has no GPU timer
+		bool gpuTimed = false;
+	};
+
+	/// <summary>
+	/// Hierarchical CPU and GPU profiler. Scopes nest, and are identified by name and parent.
+	/// GPU scopes are a pair of GL_TIMESTAMP queries, which nest where GL_TIME_ELAPSED can't. Queries come from
+	/// one pool per frame slot and are only read once available; a frame the GPU hasn't finished when its slot
+	/// is reused loses its GPU times instead of stalling.
+	/// </summary>
+	class Profiler {
+	public:
+		Profiler();
+		~Profiler();
+		Profiler(const Profiler&) = delete;
+		Profiler& operator=(const Profiler&) = delete;
+		void beginFrame();
+		void endFrame();
+		int beginScope(const char* name, bool gpu = true);
+		void endScope(int scope);
+		void finish(); //Waits for the outstanding GPU results
+		std::vector<ProfileScopeStats> getStats()const;
+		bool writeChromeTrace(const char* filePath)const;
+		void drawUI(); //ImGui contents, call inside a window
+		inline int getFrameCount()const { return m_frameCount; }
+		bool gpuTimers = true; //Read at beginFrame. Some drivers (llvmpipe) flush on every timestamp.
+	private:
+		struct Node {
+			std::string name;
+			int parent;
+			int depth;
+			bool gpuTimed;
+		};
+		struct Event {
+			int node;
+			double cpuStart; //ms since the profiler was created
+			double cpuEnd;
+			double gpuStart = -1; //ms after the frame's first GPU timestamp, -1 until resolved
+			double gpuEnd = -1;
+			int query = -1; //Begin query in the slot's pool, end is query + 1
+		};
+		struct Frame {
+			double cpuStart = 0;
+			double cpuEnd = 0;
+			double gpuMs = -1;
+			bool resolved = false;
+			std::vector<Event> events;
+		};
+		int findNode(const char* name, int parent, bool gpu);
+		int allocQueries(); //Two consecutive queries in the current slot
+		void resolve(int slot, bool wait);
+		double now()const;
+		std::vector<Node> m_nodes;
+		std::vector<Frame> m_frames; //Ring of PROFILER_HISTORY
+		std::vector<int> m_stack; //Open events of the current frame
+		int m_frameCount = 0;
+		bool m_inFrame = false;
+		bool m_frameGpu = false; //gpuTimers for the current frame
+		double m_epoch;
+		//Per slot: query pool, queries used and the frame waiting on them
+		std::vector<unsigned int> m_queries[PROFILER_LATENCY];
+		int m_queriesUsed[PROFILER_LATENCY] = {};
+		int m_pendingFrame[PROFILER_LATENCY];
+		char m_traceMessage[128] = "";
+	};
+
+	//Times the enclosing block
+	class ProfileScope {
+	public:
+		ProfileScope(Profiler& profiler, const char* name, bool gpu = true) : m_profiler(profiler) {
+			m_scope = profiler.beginScope(name, gpu);
+		}
+		~ProfileScope() { m_profiler.endScope(m_scope); }
+		ProfileScope(const ProfileScope&) = delete;
+		ProfileScope& operator=(const ProfileScope&) = delete;
+	private:
+		Profiler& m_profiler;
+		int m_scope;
+	};
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <stdint.h>
+
+namespace ew {
+	/// <summary>
+	/// PCG32 generator (pcg-random.org). A seed gives the same sequence on every platform and compiler,
+	/// unlike rand() behind ew::RandomRange, so generated content is reproducible across builds.
+	/// </summary>
+	class Random {
+	public:
+		/// <param name="stream">Independent sequence for the same seed, so one consumer can't shift another's numbers</param>
+		Random(uint64_t seed = 1, uint64_t stream = 1) {
+			m_inc = (stream << 1u) | 1u;
+			next();
+			m_state += seed;
+			next();
+		}
+		inline uint32_t next() {
+			uint64_t old = m_state;
+			m_state = old * 6364136223846793005ULL + m_inc;
+			uint32_t xorShifted = (uint32_t)(((old >> 18u) ^ old) >> 27u);
+			uint32_t rotation = (uint32_t)(old >> 59u);
+			return (xorShifted >> rotation) | (xorShifted << ((0u - rotation) & 31u));
+		}
+		//[0, 1), 24 bits
+		inline float nextFloat() { return (next() >> 8) * (1.0f / 16777216.0f); }
+		//[min, max)
+		inline float range(float min, float max) { return min + (max - min) * nextFloat(); }
+		//[min, max), max > min
+		inline int rangeInt(int min, int max) { return min + (int)(next() % (uint32_t)(max - min)); }
+	private:
+		uint64_t m_state = 0;
+		uint64_t m_inc;
+	};
+}
@@ -0,0 +1,159 @@
+#include "renderQueue.h"
+#include "external/glad.h"
+#include "glState.h"
+#include <string.h>
+
+namespace ew {
+	RenderQueue::RenderQueue(float maxDepth)
+	{
+		m_maxDepth = maxDepth;
+	}
+	unsigned long long RenderQueue::MakeSortKey(RenderPass pass, unsigned int shader, unsigned int texture, unsigned int mesh, unsigned int depth)
+	{
+		unsigned long long key = (unsigned long long)((unsigned int)pass & 0xF) << 60;
+		if (pass == RenderPass::BLENDED) {
+			//Back to front matters more than state for blending
+			key |= (unsigned long long)(0xFFFF - (depth & 0xFFFF)) << 44;
+			key |= (unsigned long long)(shader & 0xFFF) << 32;
+			key |= (unsigned long long)(texture & 0xFFFF) << 16;
+			key |= (unsigned long long)(mesh & 0xFFFF);
+			return key;
+		}
+		key |= (unsigned long long)(shader & 0xFFF) << 48;
+		key |= (unsigned long long)(texture & 0xFFFF) << 32;
+		key |= (unsigned long long)(mesh & 0xFFFF) << 16;
+		key |= (unsigned long long)(depth & 0xFFFF);
+		return key;
+	}
+	unsigned int RenderQueue::idFor(std::unordered_map<const void*, unsigned int>& ids, const void* object, unsigned int maxId)
+	{
+		if (!object) {
+			return 0;
+		}
+		auto it = ids.find(object);
+		if (it != ids.end()) {
+			return it->second;
+		}
+		//0 is null. Ids past maxId share the last value, which only costs sort quality.
+		unsigned int id = (unsigned int)ids.size() + 1;
+		id = id < maxId ? id : maxId;
+		ids[object] = id;
+		return id;
+	}
+	void RenderQueue::submit(const DrawItem& item)
+	{
+		float depth = item.depth / m_maxDepth;
+		depth = depth < 0 ? 0 : (depth > 1 ? 1 : depth);
+		SortEntry entry;
+		entry.key = MakeSortKey(item.pass, idFor(m_shaderIds, item.shader, 0xFFF), item.texture,
+			idFor(m_meshIds, item.mesh, 0xFFFF), (unsigned int)(depth * 0xFFFF));
+		entry.item = (unsigned int)m_items.size();
+		m_entries.push_back(entry);
+		m_items.push_back(item);
+	}
+	void RenderQueue::clear()
+	{
+		m_items.clear();
+		m_entries.clear();
+	}
+	/// <summary>
+	/// LSD radix sort on the keys, 8 bits per pass. Bytes every key shares are skipped,
+	/// which with few shaders and textures is most of them.
+	/// </summary>
+	void RenderQueue::radixSort()
+	{
+		size_t count = m_entries.size();
+		m_scratch.resize(count);
+		SortEntry* from = m_entries.data();
+		SortEntry* to = m_scratch.data();
+		for (int shift = 0; shift < 64; shift += 8)
+		{
+			unsigned int histogram[256];
+			memset(histogram, 0, sizeof(histogram));
+			for (size_t i = 0; i < count; i++) {
+				histogram[(from[i].key >> shift) & 0xFF]++;
+			}
+			if (histogram[(from[0].key >> shift) & 0xFF] == count) {
+				continue;
+			}
+			unsigned int offset = 0;
+			for (int b = 0; b < 256; b++) {
+				unsigned int n = histogram[b];
+				histogram[b] = offset;
+				offset += n;
+			}
+			for (size_t i = 0; i < count; i++) {
+				to[histogram[(from[i].key >> shift) & 0xFF]++] = from[i];
+			}
+			SortEntry* swap = from;
+			from = to;
+			to = swap;
+		}
+		if (from != m_entries.data()) {
+			memcpy(m_entries.data(), from, sizeof(SortEntry) * count);
+		}
+	}
+	/// <summary>
+	/// Sorts and draws everything submitted since the last flush, then clears the queue.
+	/// Leaves the last program and texture bound.
+	/// </summary>
+	void RenderQueue::flush()
+	{
+		m_stats = RenderQueueStats();
+		m_stats.items = (int)m_entries.size();
+		if (m_entries.empty()) {
+			return;
+		}
+		radixSort();
+
+		const Shader* shader = nullptr;
+		unsigned int texture = 0;
+		const Mesh* mesh = nullptr;
+		bool blending = false;
+		UniformHandle model;
+		for (size_t i = 0; i < m_entries.size(); i++)
+		{
+			const DrawItem& item = m_items[m_entries[i].item];
+			if ((item.pass == RenderPass::BLENDED) != blending) {
+				blending = !blending;
+				if (blending) {
+					GLState::setEnabled(GL_BLEND, true);
+					GLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+					GLState::depthMask(false);
+				}
+			}
+			if (item.shader && item.shader != shader) {
+				shader = item.shader;
+				shader->use();
+				model = shader->getUniform("_Model");
+				m_stats.shaderChanges++;
+			}
+			if (item.texture != 0 && item.texture != texture) {
+				texture = item.texture;
+				GLState::bindTexture(item.textureArray ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D, texture);
+				m_stats.textureChanges++;
+			}
+			if (item.mesh) {
+				if (item.mesh != mesh) {
+					m_stats.meshChanges++;
+				}
+				mesh = item.mesh;
+				if (shader) {
+					shader->setMat4(model, item.model);
+				}
+				item.mesh->draw();
+			}
+			else if (item.draw) {
+				mesh = nullptr;
+				item.draw();
+			}
+		}
+		if (blending) {
+			GLState::setEnabled(GL_BLEND, false);
+			GLState::depthMask(true);
+		}
+		m_stats.shaderChangesAvoided = m_stats.items - m_stats.shaderChanges;
+		m_stats.textureChangesAvoided = m_stats.items - m_stats.textureChanges;
+		clear();
+	}
+}
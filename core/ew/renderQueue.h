@@ -0,0 +1,69 @@
+#pragma once
+#include <vector>
+#include <functional>
+#include <unordered_map>
+#include "ewMath/ewMath.h"
+#include "shader.h"
+#include "mesh.h"
+
+namespace ew {
+	enum class RenderPass {
+		SOLID = 0, //Sorted by state, then front to back
+		BLENDED = 1 //Drawn after SOLID, back to front, with alpha blending and no depth writes
+	};
+
+	struct DrawItem {
+		RenderPass pass = RenderPass::SOLID;
+		const Shader* shader = nullptr;
+		unsigned int texture = 0; //GL_TEXTURE_2D on unit 0. 0 leaves whatever is bound.
+		bool textureArray = false; //Bind texture as GL_TEXTURE_2D_ARRAY instead
+		const Mesh* mesh = nullptr; //Drawn with _Model set to model
+		ew::Mat4 model;
+		std::function<void()> draw; //Used instead of mesh, for batches and anything else with its own draw call
+		float depth = 0; //Distance from the camera, 0 to RenderQueue's maxDepth
+	};
+
+	//Per flush. Avoided counts are against binding the program and texture for every item.
+	struct RenderQueueStats {
+		int items = 0;
+		int shaderChanges = 0;
+		int textureChanges = 0;
+		int meshChanges = 0; //Consecutive items with different meshes, a measure of how well the sort grouped them
+		int shaderChangesAvoided = 0;
+		int textureChangesAvoided = 0;
+	};
+
+	/// <summary>
+	/// Collects a frame's draws, radix sorts them by a 64 bit key and submits them,
+	/// skipping program and texture binds that wouldn't change anything.
+	/// Key, high to low: pass (4 bits), then for SOLID shader (12), texture (16), mesh (16), depth (16);
+	/// for BLENDED the inverted depth comes right after the pass so it overrides state.
+	/// Per frame uniforms can be set before flush(), since Shader setters don't need the program bound.
+	/// </summary>
+	class RenderQueue {
+	public:
+		RenderQueue(float maxDepth = 100.0f);
+		void submit(const DrawItem& item);
+		void flush();
+		void clear();
+		static unsigned long long MakeSortKey(RenderPass pass, unsigned int shader, unsigned int texture, unsigned int mesh, unsigned int depth);
+		inline void setMaxDepth(float maxDepth) { m_maxDepth = maxDepth; }
+		inline const RenderQueueStats& getStats()const { return m_stats; } //From the last flush
+		inline int getCount()const { return (int)m_items.size(); }
+	private:
+		struct SortEntry {
+			unsigned long long key;
+			unsigned int item;
+		};
+		unsigned int idFor(std::unordered_map<const void*, unsigned int>& ids, const void* object, unsigned int maxId);
+		void radixSort();
+		float m_maxDepth;
+		std::vector<DrawItem> m_items;
+		std::vector<SortEntry> m_entries;
+		std::vector<SortEntry> m_scratch;
+		//Small stable ids for the key, handed out in first submission order
+		std::unordered_map<const void*, unsigned int> m_shaderIds;
+		std::unordered_map<const void*, unsigned int> m_meshIds;
+		RenderQueueStats m_stats;
+	};
+}
@@ -0,0 +1,234 @@
+#include "sceneGenerator.h"
+#include "random.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+namespace ew {
+	namespace {
+		//Each kind of object draws from its own stream, so changing one count doesn't move the others
+		enum SceneStream {
+			MESH_STREAM = 1,
+			LIGHT_STREAM = 2,
+			BILLBOARD_STREAM = 3,
+			LIGHT_RADIUS_STREAM = 4 //Own stream so scenes without lightRadius keep their old lights
+		};
+		//Fully saturated color of hue h in [0, 1)
+		ew::Vec3 hueColor(float h) {
+			float r = fabsf(h * 6.0f - 3.0f) - 1.0f;
+			float g = 2.0f - fabsf(h * 6.0f - 2.0f);
+			float b = 2.0f - fabsf(h * 6.0f - 4.0f);
+			return ew::Vec3(ew::Clamp(r, 0.0f, 1.0f), ew::Clamp(g, 0.0f, 1.0f), ew::Clamp(b, 0.0f, 1.0f));
+		}
+	}
+
+	/// <summary>
+	/// A bare name like "cubes10k" is one of the bundled scenes in assets/scenes. Anything with a slash or an extension is a path.
+	/// </summary>
+	std::string GetScenePath(const std::string& nameOrPath)
+	{
+		if (nameOrPath.find_first_of("/\\.") != std::string::npos) {
+			return nameOrPath;
+		}
+		return "assets/scenes/" + nameOrPath + ".scene";
+	}
+	/// <summary>
+	/// Reads a .scene file into config, see SceneConfig for the keys. Keys that aren't in the file keep config's values.
+	/// </summary>
+	/// <returns>False, after printing the offending line, if the file is missing or malformed</returns>
+	bool LoadSceneConfig(const char* filePath, SceneConfig& config)
+	{
+		FILE* f = fopen(filePath, "r");
+		if (f == NULL) {
+			printf("Failed to open scene %s\n", filePath);
+			return false;
+		}
+		config.cameraPath.clear();
+		char line[512];
+		int lineNumber = 0;
+		bool ok = true;
+		while (ok && fgets(line, sizeof(line), f)) {
+			lineNumber++;
+			char* comment = strchr(line, '#');
+			if (comment != NULL) {
+				*comment = '\0';
+			}
+			char key[64];
+			int read = 0;
+			if (sscanf(line, "%63s%n", key, &read) != 1) {
+				continue;
+			}
+			const char* values = line + read;
+			int parsed = 0, expected = 1;
+			if (strcmp(key, "name") == 0) {
+				char name[256];
+				parsed = sscanf(values, "%255s", name);
+				config.name = name;
+			}
+			else if (strcmp(key, "seed") == 0) {
+				parsed = sscanf(values, "%u", &config.seed);
+			}
+			else if (strcmp(key, "extent") == 0) {
+				parsed = sscanf(values, "%f", &config.extent);
+			}
+			else if (strcmp(key, "groundHeight") == 0) {
+				parsed = sscanf(values, "%f", &config.groundHeight);
+			}
+			else if (strcmp(key, "meshes") == 0) {
+				parsed = sscanf(values, "%d", &config.meshes);
+			}
+			else if (strcmp(key, "meshKinds") == 0) {
+				parsed = sscanf(values, "%d", &config.meshKinds);
+			}
+			else if (strcmp(key, "meshScale") == 0) {
+				parsed = sscanf(values, "%f %f", &config.meshScale.x, &config.meshScale.y);
+				expected = 2;
+			}
+			else if (strcmp(key, "meshHeight") == 0) {
+				parsed = sscanf(values, "%f %f", &config.meshHeight.x, &config.meshHeight.y);
+				expected = 2;
+			}
+			else if (strcmp(key, "lights") == 0) {
+				parsed = sscanf(values, "%d", &config.lights);
+			}
+			else if (strcmp(key, "lightHeight") == 0) {
+				parsed = sscanf(values, "%f %f", &config.lightHeight.x, &config.lightHeight.y);
+				expected = 2;
+			}
+			else if (strcmp(key, "lightIntensity") == 0) {
+				parsed = sscanf(values, "%f", &config.lightIntensity);
+			}
+			else if (strcmp(key, "lightRadius") == 0) {
+				parsed = sscanf(values, "%f %f", &config.lightRadius.x, &config.lightRadius.y);
+				expected = 2;
+			}
+			else if (strcmp(key, "billboards") == 0) {
+				parsed = sscanf(values, "%d", &config.billboards);
+			}
+			else if (strcmp(key, "spriteKinds") == 0) {
+				parsed = sscanf(values, "%d", &config.spriteKinds);
+			}
+			else if (strcmp(key, "billboardSize") == 0) {
+				parsed = sscanf(values, "%f %f", &config.billboardSize.x, &config.billboardSize.y);
+				expected = 2;
+			}
+			else if (strcmp(key, "farPlane") == 0) {
+				parsed = sscanf(values, "%f", &config.farPlane);
+			}
+			else if (strcmp(key, "camera") == 0) {
+				CameraKey cameraKey;
+				parsed = sscanf(values, "%f %f %f %f %f %f %f", &cameraKey.time,
+					&cameraKey.position.x, &cameraKey.position.y, &cameraKey.position.z,
+					&cameraKey.target.x, &cameraKey.target.y, &cameraKey.target.z);
+				expected = 7;
+				if (!config.cameraPath.empty() && cameraKey.time <= config.cameraPath.back().time) {
+					printf("%s:%d: camera keys must be in increasing time order\n", filePath, lineNumber);
+					ok = false;
+				}
+				config.cameraPath.push_back(cameraKey);
+			}
+			else {
+				printf("%s:%d: unknown key %s\n", filePath, lineNumber, key);
+				ok = false;
+				continue;
+			}
+			if (ok && parsed != expected) {
+				printf("%s:%d: %s expects %d value(s)\n", filePath, lineNumber, key, expected);
+				ok = false;
+			}
+		}
+		fclose(f);
+		if (ok && (config.meshes < 0 || config.lights < 0 || config.billboards < 0 || config.meshKinds < 1 || config.spriteKinds < 1)) {
+			printf("%s: counts can't be negative and kinds must be at least 1\n", filePath);
+			ok = false;
+		}
+		return ok;
+	}
+	/// <summary>
+	/// Scatters the config's meshes, lights and billboards. The same config always gives the same scene.
+	/// </summary>
+	GeneratedScene GenerateScene(const SceneConfig& config)
+	{
+		GeneratedScene scene;
+		float extent = config.extent;
+
+		Random meshRandom(config.seed, MESH_STREAM);
+		scene.meshes.resize(config.meshes);
+		for (GeneratedMesh& mesh : scene.meshes) {
+			float scale = meshRandom.range(config.meshScale.x, config.meshScale.y);
+			float x = meshRandom.range(-extent, extent);
+			float z = meshRandom.range(-extent, extent);
+			float lift = meshRandom.range(config.meshHeight.x, config.meshHeight.y);
+			mesh.transform.position = ew::Vec3(x, config.groundHeight + scale * 0.5f + lift, z);
+			mesh.transform.rotation = ew::Vec3(meshRandom.range(-180.0f, 180.0f), meshRandom.range(-180.0f, 180.0f), meshRandom.range(-180.0f, 180.0f));
+			mesh.transform.scale = ew::Vec3(scale);
+			mesh.kind = meshRandom.rangeInt(0, config.meshKinds);
+		}
+
+		Random lightRandom(config.seed, LIGHT_STREAM);
+		Random radiusRandom(config.seed, LIGHT_RADIUS_STREAM);
+		scene.lights.resize(config.lights);
+		for (GeneratedLight& light : scene.lights) {
+			float x = lightRandom.range(-extent, extent);
+			float z = lightRandom.range(-extent, extent);
+			float y = config.groundHeight + lightRandom.range(config.lightHeight.x, config.lightHeight.y);
+			light.position = ew::Vec3(x, y, z);
+			light.color = hueColor(lightRandom.nextFloat()) * config.lightIntensity;
+			light.radius = radiusRandom.range(config.lightRadius.x, config.lightRadius.y);
+		}
+
+		Random billboardRandom(config.seed, BILLBOARD_STREAM);
+		scene.billboards.resize(config.billboards);
+		for (GeneratedBillboard& billboard : scene.billboards) {
+			float size = billboardRandom.range(config.billboardSize.x, config.billboardSize.y);
+			float x = billboardRandom.range(-extent, extent);
+			float z = billboardRandom.range(-extent, extent);
+			billboard.position = ew::Vec3(x, config.groundHeight + size * 0.5f, z);
+			billboard.size = ew::Vec2(size);
+			billboard.kind = billboardRandom.rangeInt(0, config.spriteKinds);
+		}
+		return scene;
+	}
+	/// <summary>
+	/// Catmull-Rom through the keys' positions and targets. Times before the first key or after the last clamp to them.
+	/// </summary>
+	/// <returns>False if the path is empty</returns>
+	bool SampleCameraPath(const std::vector<CameraKey>& path, float time, ew::Vec3& position, ew::Vec3& target)
+	{
+		if (path.empty()) {
+			return false;
+		}
+		int last = (int)path.size() - 1;
+		if (time <= path[0].time || last == 0) {
+			position = path[0].position;
+			target = path[0].target;
+			return true;
+		}
+		if (time >= path[last].time) {
+			position = path[last].position;
+			target = path[last].target;
+			return true;
+		}
+		int segment = 0;
+		while (path[segment + 1].time <= time) {
+			segment++;
+		}
+		const CameraKey& k0 = path[segment > 0 ? segment - 1 : 0];
+		const CameraKey& k1 = path[segment];
+		const CameraKey& k2 = path[segment + 1];
+		const CameraKey& k3 = path[segment + 2 <= last ? segment + 2 : last];
+		float t = (time - k1.time) / (k2.time - k1.time);
+		float t2 = t * t;
+		float t3 = t2 * t;
+		auto catmullRom = [&](const ew::Vec3& p0, const ew::Vec3& p1, const ew::Vec3& p2, const ew::Vec3& p3) {
+			return ((p1 * 2.0f) + (p2 - p0) * t + (p0 * 2.0f - p1 * 5.0f + p2 * 4.0f - p3) * t2 + (p1 * 3.0f - p0 - p2 * 3.0f + p3) * t3) * 0.5f;
+		};
+		position = catmullRom(k0.position, k1.position, k2.position, k3.position);
+		target = catmullRom(k0.target, k1.target, k2.target, k3.target);
+		return true;
+	}
+	float GetCameraPathDuration(const std::vector<CameraKey>& path)
+	{
+		return path.empty() ? 0.0f : path.back().time;
+	}
+}
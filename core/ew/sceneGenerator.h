@@ -0,0 +1,67 @@
+#pragma once
+#include <vector>
+#include <string>
+#include "ewMath/ewMath.h"
+#include "transform.h"
+
+namespace ew {
+	struct CameraKey {
+		float time = 0; //Seconds from the start of the path
+		ew::Vec3 position;
+		ew::Vec3 target;
+	};
+
+	/// <summary>
+	/// What GenerateScene builds. Loaded from a .scene file, one "key values" per line, # for comments:
+	///   seed 7 / meshes 10000 / meshKinds 2 / meshScale 0.3 1.2 / meshHeight 0 3
+	///   lights 1000 / lightHeight 0.5 4 / lightIntensity 0.01 / lightRadius 4 8
+	///   billboards 100000 / spriteKinds 3 / billboardSize 0.75 2
+	///   extent 80 / groundHeight -1 / farPlane 250
+	///   camera time px py pz tx ty tz   (one per key, in time order)
+	/// </summary>
+	struct SceneConfig {
+		std::string name;
+		unsigned int seed = 1;
+		float extent = 50.0f; //Everything is scattered over [-extent, extent] in x and z
+		float groundHeight = -1.0f;
+		int meshes = 0;
+		int meshKinds = 1; //GeneratedMesh::kind is in [0, meshKinds), the caller maps it to a mesh
+		ew::Vec2 meshScale = ew::Vec2(0.5f, 1.0f); //Uniform scale range
+		ew::Vec2 meshHeight = ew::Vec2(0.0f, 0.0f); //Lift of the mesh's base above the ground
+		int lights = 0;
+		ew::Vec2 lightHeight = ew::Vec2(0.5f, 3.0f);
+		float lightIntensity = 1.0f; //Scales each light's fully saturated color
+		ew::Vec2 lightRadius = ew::Vec2(0.0f, 0.0f); //Falloff distance range, 0 for lights that reach everything
+		int billboards = 0;
+		int spriteKinds = 1;
+		ew::Vec2 billboardSize = ew::Vec2(0.75f, 2.0f);
+		float farPlane = 100.0f;
+		std::vector<CameraKey> cameraPath;
+	};
+
+	struct GeneratedMesh {
+		ew::Transform transform;
+		int kind = 0;
+	};
+	struct GeneratedLight {
+		ew::Vec3 position;
+		ew::Vec3 color;
+		float radius = 0.0f;
+	};
+	struct GeneratedBillboard {
+		ew::Vec3 position; //Center, so the bottom edge rests on the ground
+		ew::Vec2 size;
+		int kind = 0;
+	};
+	struct GeneratedScene {
+		std::vector<GeneratedMesh> meshes;
+		std::vector<GeneratedLight> lights;
+		std::vector<GeneratedBillboard> billboards;
+	};
+
+	std::string GetScenePath(const std::string& nameOrPath);
+	bool LoadSceneConfig(const char* filePath, SceneConfig& config);
+	GeneratedScene GenerateScene(const SceneConfig& config);
+	bool SampleCameraPath(const std::vector<CameraKey>& path, float time, ew::Vec3& position, ew::Vec3& target);
+	float GetCameraPathDuration(const std::vector<CameraKey>& path);
+}
@@ -1,7 +1,10 @@
 #include "shader.h"
 #include <fstream>
 #include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
 #include "external/glad.h"
+#include "glState.h"
 
 namespace ew {
 	/// <summary>
@@ -73,6 +76,109 @@ namespace ew {
 		return shaderProgram;
 	}
 	/// <summary>
+	/// Enumerates the active uniforms of a linked program and stores their locations by name hash
+	/// </summary>
+	/// <param name="program">Linked shader program handle</param>
+	void UniformTable::build(unsigned int program)
+	{
+		int numUniforms = 0;
+		int maxNameLength = 0;
+		glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &numUniforms);
+		glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+		//Arrays add an entry per element, so size for a few extra slots per uniform
+		unsigned int capacity = 16;
+		while (capacity < (unsigned int)numUniforms * 4) {
+			capacity *= 2;
+		}
+		m_entries.assign(capacity, Entry{ 0, -1 });
+		m_mask = capacity - 1;
+		m_count = 0;
+
+		std::string name(maxNameLength + 16, '\0');
+		for (int i = 0; i < numUniforms; i++)
+		{
+			int nameLength = 0;
+			int arraySize = 0;
+			GLenum type;
+			glGetActiveUniform(program, i, maxNameLength, &nameLength, &arraySize, &type, &name[0]);
+			std::string uniformName = name.substr(0, nameLength);
+			int location = glGetUniformLocation(program, uniformName.c_str());
+			//Uniform block members have no location and are skipped
+			if (location < 0) {
+				continue;
+			}
+			insert(HashUniformName(uniformName.c_str()), location, uniformName.c_str());
+
+			//Arrays of basic types are reported once as "name[0]". Register "name" and every element.
+			size_t bracket = uniformName.rfind("[0]");
+			if (arraySize > 1 || (bracket != std::string::npos && bracket + 3 == uniformName.size())) {
+				std::string baseName = uniformName.substr(0, bracket);
+				insert(HashUniformName(baseName.c_str()), location, baseName.c_str());
+				for (int j = 1; j < arraySize; j++)
+				{
+					std::string elementName = baseName + "[" + std::to_string(j) + "]";
+					insert(HashUniformName(elementName.c_str()), glGetUniformLocation(program, elementName.c_str()), elementName.c_str());
+				}
+			}
+		}
+	}
+	/// <summary>
+	/// Adds a location under its name hash. Two names with one hash would make one of them unreachable,
+	/// so that aborts with both locations; rename one of the uniforms.
+	/// </summary>
+	void UniformTable::insert(unsigned int hash, int location, const char* name)
+	{
+		if (location < 0) {
+			return;
+		}
+		//Keep the table at most half full so probe chains stay short
+		if ((m_count + 1) * 2 > m_entries.size()) {
+			std::vector<Entry> old = m_entries;
+			m_entries.assign(old.size() * 2, Entry{ 0, -1 });
+			m_mask = (unsigned int)m_entries.size() - 1;
+			m_count = 0;
+			for (const Entry& e : old) {
+				if (e.location >= 0) {
+					insert(e.hash, e.location, "");
+				}
+			}
+		}
+		unsigned int slot = hash & m_mask;
+		while (m_entries[slot].location >= 0) {
+			if (m_entries[slot].hash == hash) {
+				if (m_entries[slot].location != location) {
+					printf("Uniform name hash collision (%u): %s (location %d) and the uniform at location %d\n", hash, name, location, m_entries[slot].location);
+					fflush(stdout);
+					abort();
+				}
+				return;
+			}
+			slot = (slot + 1) & m_mask;
+		}
+		m_entries[slot].hash = hash;
+		m_entries[slot].location = location;
+		m_count++;
+	}
+	/// <summary>
+	/// Finds the location of a uniform by name hash
+	/// </summary>
+	/// <returns>Uniform location, or -1 if it is not an active uniform</returns>
+	int UniformTable::find(unsigned int hash) const
+	{
+		if (m_entries.empty()) {
+			return -1;
+		}
+		unsigned int slot = hash & m_mask;
+		while (m_entries[slot].location >= 0) {
+			if (m_entries[slot].hash == hash) {
+				return m_entries[slot].location;
+			}
+			slot = (slot + 1) & m_mask;
+		}
+		return -1;
+	}
+	/// <summary>
 	/// Creates a shader instance with vertex + fragment stages
 	/// </summary>
 	/// <param name="vertexShader">File path to vertex shader</param>
@@ -82,46 +188,87 @@ namespace ew {
 		std::string vertexShaderSource = ew::loadShaderSourceFromFile(vertexShader.c_str());
 		std::string fragmentShaderSource = ew::loadShaderSourceFromFile(fragmentShader.c_str());
 		m_id = ew::createShaderProgram(vertexShaderSource.c_str(), fragmentShaderSource.c_str());
+		m_uniforms.build(m_id);
 	}
 	void Shader::use()const
 	{
-		glUseProgram(m_id);
+		GLState::useProgram(m_id);
+	}
+	/// <summary>
+	/// Looks up a uniform once so hot loops can set it without hashing.
+	/// Setters write straight to this program (glProgramUniform), so it doesn't have to be bound.
+	/// </summary>
+	UniformHandle Shader::getUniform(UniformName name) const
+	{
+		UniformHandle handle;
+		handle.location = m_uniforms.find(name.hash);
+		return handle;
+	}
+	void Shader::setInt(UniformName name, int v) const
+	{
+		setInt(getUniform(name), v);
+	}
+	void Shader::setFloat(UniformName name, float v) const
+	{
+		setFloat(getUniform(name), v);
+	}
+	void Shader::setVec2(UniformName name, float x, float y) const
+	{
+		setVec2(getUniform(name), ew::Vec2(x, y));
+	}
+	void Shader::setVec2(UniformName name, const ew::Vec2& v) const
+	{
+		setVec2(getUniform(name), v);
+	}
+	void Shader::setVec3(UniformName name, float x, float y, float z) const
+	{
+		setVec3(getUniform(name), ew::Vec3(x, y, z));
+	}
+	void Shader::setVec3(UniformName name, const ew::Vec3& v) const
+	{
+		setVec3(getUniform(name), v);
 	}
-	void Shader::setInt(const std::string& name, int v) const
+	void Shader::setVec4(UniformName name, float x, float y, float z, float w) const
 	{
-		glUniform1i(glGetUniformLocation(m_id, name.c_str()), v);
+		setVec4(getUniform(name), ew::Vec4(x, y, z, w));
 	}
-	void Shader::setFloat(const std::string& name, float v) const
+	void Shader::setVec4(UniformName name, const ew::Vec4& v) const
 	{
-		glUniform1f(glGetUniformLocation(m_id, name.c_str()), v);
+		setVec4(getUniform(name), v);
 	}
-	void Shader::setVec2(const std::string& name, float x, float y) const
+	void Shader::setMat4(UniformName name, const ew::Mat4& m) const
 	{
-		glUniform2f(glGetUniformLocation(m_id, name.c_str()), x, y);
+		setMat4(getUniform(name), m);
 	}
-	void Shader::setVec2(const std::string& name, const ew::Vec2& v) const
+	void Shader::setInt(UniformHandle handle, int v) const
 	{
-		setVec2(name, v.x, v.y);
+		m_lookupsAvoided++;
+		glProgramUniform1i(m_id, handle.location, v);
 	}
-	void Shader::setVec3(const std::string& name, float x, float y, float z) const
+	void Shader::setFloat(UniformHandle handle, float v) const
 	{
-		glUniform3f(glGetUniformLocation(m_id, name.c_str()), x, y, z);
+		m_lookupsAvoided++;
+		glProgramUniform1f(m_id, handle.location, v);
 	}
-	void Shader::setVec3(const std::string& name, const ew::Vec3& v) const
+	void Shader::setVec2(UniformHandle handle, const ew::Vec2& v) const
 	{
-		setVec3(name, v.x, v.y, v.z);
+		m_lookupsAvoided++;
+		glProgramUniform2f(m_id, handle.location, v.x, v.y);
 	}
-	void Shader::setVec4(const std::string& name, float x, float y, float z, float w) const
+	void Shader::setVec3(UniformHandle handle, const ew::Vec3& v) const
 	{
-		glUniform4f(glGetUniformLocation(m_id, name.c_str()), x, y, z, w);
+		m_lookupsAvoided++;
+		glProgramUniform3f(m_id, handle.location, v.x, v.y, v.z);
 	}
-	void Shader::setVec4(const std::string& name, const ew::Vec4& v) const
+	void Shader::setVec4(UniformHandle handle, const ew::Vec4& v) const
 	{
-		setVec4(name, v.x, v.y, v.z, v.w);
+		m_lookupsAvoided++;
+		glProgramUniform4f(m_id, handle.location, v.x, v.y, v.z, v.w);
 	}
-	void Shader::setMat4(const std::string& name, const ew::Mat4& m) const
+	void Shader::setMat4(UniformHandle handle, const ew::Mat4& m) const
 	{
-		glUniformMatrix4fv(glGetUniformLocation(m_id, name.c_str()), 1, GL_FALSE, &m[0][0]);
+		m_lookupsAvoided++;
+		glProgramUniformMatrix4fv(m_id, handle.location, 1, GL_FALSE, &m[0][0]);
 	}
 }
 
@@ -1,24 +1,82 @@
 #pragma once
 #include <string>
+#include <vector>
+#include <type_traits>
 #include "ewMath/ewMath.h"
 
+//Uniform name hashed at compile time in every build configuration, e.g. shader.setInt(EW_UNIFORM("_Texture"), 0)
+#define EW_UNIFORM(name) ::ew::UniformName::fromHash(std::integral_constant<unsigned int, ::ew::HashUniformName(name)>::value)
+
 namespace ew {
 	std::string loadShaderSourceFromFile(const std::string& filePath);
 	unsigned int createShaderProgram(const char* vertexShaderSource, const char* fragmentShaderSource);
+
+	/// <summary>
+	/// FNV-1a hash of a uniform name. constexpr so string literals can be hashed by the compiler.
+	/// </summary>
+	constexpr unsigned int HashUniformName(const char* str, unsigned int hash = 2166136261u) {
+		return *str ? HashUniformName(str + 1, (hash ^ (unsigned char)*str) * 16777619u) : hash;
+	}
+
+	//Hashed uniform name. Plain strings are hashed on every call (optimizing compilers fold literals, debug builds don't).
+	//Wrap literals in EW_UNIFORM for a hash that is always computed at compile time.
+	struct UniformName {
+		unsigned int hash;
+		constexpr UniformName(const char* name) :hash(HashUniformName(name)) {};
+		UniformName(const std::string& name) :hash(HashUniformName(name.c_str())) {};
+		static constexpr UniformName fromHash(unsigned int hash) { return UniformName(hash, 0); }
+	private:
+		constexpr UniformName(unsigned int hash, int) :hash(hash) {};
+	};
+
+	//Precomputed uniform location. -1 when the uniform is not active in the program.
+	struct UniformHandle {
+		int location = -1;
+	};
+
+	//Flat open addressing table of name hash -> uniform location, filled once after linking
+	class UniformTable {
+	public:
+		void build(unsigned int program);
+		int find(unsigned int hash) const;
+		inline unsigned int size()const { return m_count; }
+	private:
+		struct Entry {
+			unsigned int hash;
+			int location; //-1 marks an empty slot
+		};
+		void insert(unsigned int hash, int location, const char* name);
+		std::vector<Entry> m_entries;
+		unsigned int m_mask = 0;
+		unsigned int m_count = 0;
+	};
+
 	class Shader {
 	public:
 		Shader(const std::string& vertexShader, const std::string& fragmentShader);
 		void use()const;
-		void setInt(const std::string& name, int v) const;
-		void setFloat(const std::string& name, float v) const;
-		void setVec2(const std::string& name, float x, float y) const;
-		void setVec2(const std::string& name, const ew::Vec2& v) const;
-		void setVec3(const std::string& name, float x, float y, float z) const;
-		void setVec3(const std::string& name, const ew::Vec3& v) const;
-		void setVec4(const std::string& name, float x, float y, float z, float w) const;
-		void setVec4(const std::string& name, const ew::Vec4& v) const;
-		void setMat4(const std::string& name, const ew::Mat4& m) const;
+		inline unsigned int getID()const { return m_id; }
+		UniformHandle getUniform(UniformName name) const;
+		void setInt(UniformName name, int v) const;
+		void setFloat(UniformName name, float v) const;
+		void setVec2(UniformName name, float x, float y) const;
+		void setVec2(UniformName name, const ew::Vec2& v) const;
+		void setVec3(UniformName name, float x, float y, float z) const;
+		void setVec3(UniformName name, const ew::Vec3& v) const;
+		void setVec4(UniformName name, float x, float y, float z, float w) const;
+		void setVec4(UniformName name, const ew::Vec4& v) const;
+		void setMat4(UniformName name, const ew::Mat4& m) const;
+		void setInt(UniformHandle handle, int v) const;
+		void setFloat(UniformHandle handle, float v) const;
+		void setVec2(UniformHandle handle, const ew::Vec2& v) const;
+		void setVec3(UniformHandle handle, const ew::Vec3& v) const;
+		void setVec4(UniformHandle handle, const ew::Vec4& v) const;
+		void setMat4(UniformHandle handle, const ew::Mat4& m) const;
+		//Number of glGetUniformLocation calls the uniform table has saved so far
+		inline unsigned long long getLookupsAvoided()const { return m_lookupsAvoided; }
 	private:
 		unsigned int m_id; //Shader program handle
+		UniformTable m_uniforms;
+		mutable unsigned long long m_lookupsAvoided = 0;
 	};
-}
\ No newline at end of file
+}
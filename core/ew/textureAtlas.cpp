@@ -0,0 +1,259 @@
+#include "textureAtlas.h"
+#include "cookedTexture.h"
+#include "glState.h"
+#include "external/glad.h"
+#include "external/stb_image.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+namespace ew {
+	//Defined in external/stb_image.cpp
+	void GetStbiFlipThread(int& flip, int& set);
+	void RestoreStbiFlipThread(int flip, int set);
+
+	SkylinePacker::SkylinePacker(int width, int height)
+	{
+		m_width = width;
+		m_height = height;
+		Segment floor;
+		floor.x = 0;
+		floor.y = 0;
+		floor.width = width;
+		m_skyline.push_back(floor);
+	}
+	int SkylinePacker::fit(int segment, int width, int height)const
+	{
+		int x = m_skyline[segment].x;
+		if (x + width > m_width) {
+			return -1;
+		}
+		//Rests on the highest segment it spans
+		int y = 0;
+		int remaining = width;
+		for (int i = segment; remaining > 0; i++) {
+			y = m_skyline[i].y > y ? m_skyline[i].y : y;
+			if (y + height > m_height) {
+				return -1;
+			}
+			remaining -= m_skyline[i].width;
+		}
+		return y;
+	}
+	/// <summary>
+	/// Places a width x height rectangle, bottom-left first.
+	/// </summary>
+	/// <returns>False if it doesn't fit anywhere on the page</returns>
+	bool SkylinePacker::pack(int width, int height, AtlasRect& rect)
+	{
+		int best = -1;
+		int bestTop = 0;
+		int bestWidth = 0;
+		for (int i = 0; i < (int)m_skyline.size(); i++) {
+			int y = fit(i, width, height);
+			if (y < 0) {
+				continue;
+			}
+			//Lowest top wins, then the narrowest segment so wide ones stay free for wide rects
+			if (best < 0 || y + height < bestTop || (y + height == bestTop && m_skyline[i].width < bestWidth)) {
+				best = i;
+				bestTop = y + height;
+				bestWidth = m_skyline[i].width;
+			}
+		}
+		if (best < 0) {
+			return false;
+		}
+		rect.x = m_skyline[best].x;
+		rect.y = bestTop - height;
+		rect.width = width;
+		rect.height = height;
+
+		Segment top;
+		top.x = rect.x;
+		top.y = bestTop;
+		top.width = width;
+		m_skyline.insert(m_skyline.begin() + best, top);
+		//Trim the segments the new one now covers
+		for (size_t i = best + 1; i < m_skyline.size();) {
+			int covered = top.x + top.width - m_skyline[i].x;
+			if (covered <= 0) {
+				break;
+			}
+			m_skyline[i].x += covered;
+			m_skyline[i].width -= covered;
+			if (m_skyline[i].width > 0) {
+				break;
+			}
+			m_skyline.erase(m_skyline.begin() + i);
+		}
+		for (size_t i = 0; i + 1 < m_skyline.size();) {
+			if (m_skyline[i].y == m_skyline[i + 1].y) {
+				m_skyline[i].width += m_skyline[i + 1].width;
+				m_skyline.erase(m_skyline.begin() + i + 1);
+			}
+			else {
+				i++;
+			}
+		}
+		m_usedArea += (long long)width * height;
+		return true;
+	}
+	float SkylinePacker::getOccupancy()const
+	{
+		return (float)((double)m_usedArea / ((double)m_width * m_height));
+	}
+
+	/// <param name="pageSize">Width and height of every page (array layer)</param>
+	/// <param name="padding">Edge texels around each sprite, a power of two. Sets how many mips are safe to sample.</param>
+	/// <param name="maxSpriteSize">Sprites are halved until they fit in this. 0 only limits them to the page.</param>
+	TextureAtlas::TextureAtlas(int pageSize, int padding, int maxSpriteSize)
+	{
+		m_pageSize = pageSize > 1 ? pageSize : 1;
+		m_padding = padding > 0 ? padding : 0;
+		int pageLimit = m_pageSize - m_padding * 2;
+		m_maxSpriteSize = (maxSpriteSize > 0 && maxSpriteSize < pageLimit) ? maxSpriteSize : pageLimit;
+	}
+	TextureAtlas::~TextureAtlas()
+	{
+		GLState::deleteTexture(m_texture);
+	}
+	/// <summary>
+	/// Loads an image to pack on the next build()
+	/// </summary>
+	/// <param name="flipVertically">Flip rows on load, as qm::loadTexture does</param>
+	/// <returns>Sprite id, or -1 if the file couldn't be loaded</returns>
+	int TextureAtlas::add(const char* filePath, bool flipVertically)
+	{
+		//Put the flag back afterwards, or this thread's later loads (qm::loadTexture) would ignore stb's global one
+		int previousFlip, previousSet;
+		GetStbiFlipThread(previousFlip, previousSet);
+		stbi_set_flip_vertically_on_load_thread(flipVertically);
+		int width, height, numComponents;
+		unsigned char* data = stbi_load(filePath, &width, &height, &numComponents, 4);
+		RestoreStbiFlipThread(previousFlip, previousSet);
+		if (data == NULL) {
+			printf("Failed to load image %s\n", filePath);
+			return -1;
+		}
+		int sprite = add(data, width, height);
+		stbi_image_free(data);
+		return sprite;
+	}
+	/// <summary>
+	/// Copies RGBA8 pixels to pack on the next build()
+	/// </summary>
+	/// <returns>Sprite id</returns>
+	int TextureAtlas::add(const unsigned char* rgba, int width, int height)
+	{
+		Image image;
+		image.rgba.assign(rgba, rgba + (size_t)width * height * 4);
+		image.width = width;
+		image.height = height;
+		while (image.width > m_maxSpriteSize || image.height > m_maxSpriteSize) {
+			image.rgba = DownsampleRGBA(image.rgba.data(), image.width, image.height);
+			image.width = image.width > 1 ? image.width / 2 : 1;
+			image.height = image.height > 1 ? image.height / 2 : 1;
+		}
+		m_images.push_back(image);
+
+		AtlasSprite sprite;
+		sprite.width = image.width;
+		sprite.height = image.height;
+		m_sprites.push_back(sprite);
+		return (int)m_sprites.size() - 1;
+	}
+	/// <summary>
+	/// Packs every added image, tallest first, opening pages as needed, and uploads them as one array texture.
+	/// Call once, after the last add(). The CPU copies are released afterwards.
+	/// </summary>
+	bool TextureAtlas::build()
+	{
+		if (m_images.size() != m_sprites.size()) {
+			printf("TextureAtlas was already built, add sprites before calling build\n");
+			return false;
+		}
+		int alignment = m_padding > 0 ? m_padding : 1;
+		auto paddedSize = [&](int size) {
+			return (size + m_padding * 2 + alignment - 1) / alignment * alignment;
+		};
+		std::vector<int> order(m_images.size());
+		for (size_t i = 0; i < order.size(); i++) {
+			order[i] = (int)i;
+		}
+		std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+			return m_images[a].height != m_images[b].height ? m_images[a].height > m_images[b].height : m_images[a].width > m_images[b].width;
+		});
+
+		std::vector<SkylinePacker> pages;
+		std::vector<AtlasRect> rects(m_images.size());
+		for (size_t i = 0; i < order.size(); i++) {
+			int sprite = order[i];
+			int width = paddedSize(m_images[sprite].width);
+			int height = paddedSize(m_images[sprite].height);
+			int layer = 0;
+			while (layer < (int)pages.size() && !pages[layer].pack(width, height, rects[sprite])) {
+				layer++;
+			}
+			if (layer == (int)pages.size()) {
+				pages.push_back(SkylinePacker(m_pageSize, m_pageSize));
+				if (!pages.back().pack(width, height, rects[sprite])) {
+					printf("TextureAtlas page size %d is not a multiple of the padding %d\n", m_pageSize, m_padding);
+					return false;
+				}
+			}
+			m_sprites[sprite].layer = layer;
+		}
+		m_layerCount = pages.size() > 0 ? (int)pages.size() : 1;
+
+		//Every texel of a sprite's aligned rect repeats the nearest sprite texel
+		size_t pageBytes = (size_t)m_pageSize * m_pageSize * 4;
+		std::vector<unsigned char> pixels(pageBytes * m_layerCount, 0);
+		m_occupancy = 0;
+		for (size_t sprite = 0; sprite < m_images.size(); sprite++) {
+			const Image& image = m_images[sprite];
+			const AtlasRect& rect = rects[sprite];
+			unsigned char* page = pixels.data() + pageBytes * m_sprites[sprite].layer;
+			for (int y = 0; y < rect.height; y++) {
+				int sy = std::min(std::max(y - m_padding, 0), image.height - 1);
+				unsigned char* row = page + ((size_t)(rect.y + y) * m_pageSize + rect.x) * 4;
+				for (int x = 0; x < rect.width; x++) {
+					int sx = std::min(std::max(x - m_padding, 0), image.width - 1);
+					memcpy(row + x * 4, image.rgba.data() + ((size_t)sy * image.width + sx) * 4, 4);
+				}
+			}
+			AtlasSprite& s = m_sprites[sprite];
+			s.uvOffset = ew::Vec2((rect.x + m_padding) / (float)m_pageSize, (rect.y + m_padding) / (float)m_pageSize);
+			s.uvScale = ew::Vec2(image.width / (float)m_pageSize, image.height / (float)m_pageSize);
+			m_occupancy += (float)image.width * image.height / ((float)m_pageSize * m_pageSize * m_layerCount);
+		}
+
+		//Mips past log2(padding) would average neighbouring sprites together
+		m_levels = 1;
+		while ((1 << m_levels) <= m_padding && (m_pageSize >> m_levels) > 0) {
+			m_levels++;
+		}
+		glGenTextures(1, &m_texture);
+		GLState::bindTexture(GL_TEXTURE_2D_ARRAY, m_texture);
+		glTexStorage3D(GL_TEXTURE_2D_ARRAY, m_levels, GL_RGBA8, m_pageSize, m_pageSize, m_layerCount);
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, m_pageSize, m_pageSize, m_layerCount, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+		GLState::bindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+		m_images.clear();
+		return true;
+	}
+	size_t TextureAtlas::getMemorySize()const
+	{
+		size_t size = 0;
+		for (int level = 0; level < m_levels; level++) {
+			size_t levelSize = (size_t)(m_pageSize >> level);
+			size += levelSize * levelSize * 4 * m_layerCount;
+		}
+		return size;
+	}
+}
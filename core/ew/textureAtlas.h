@@ -0,0 +1,81 @@
+#pragma once
+#include <vector>
+#include "ewMath/ewMath.h"
+
+namespace ew {
+	struct AtlasRect {
+		int x = 0;
+		int y = 0;
+		int width = 0;
+		int height = 0;
+	};
+
+	/// <summary>
+	/// Skyline bottom-left rectangle packer. Keeps the top edge of everything placed so far as a list of
+	/// horizontal segments, and puts each new rectangle where its top ends up lowest.
+	/// </summary>
+	class SkylinePacker {
+	public:
+		SkylinePacker(int width, int height);
+		bool pack(int width, int height, AtlasRect& rect);
+		float getOccupancy()const; //Packed area / page area
+	private:
+		struct Segment {
+			int x;
+			int y;
+			int width;
+		};
+		int fit(int segment, int width, int height)const; //Top of the rect if placed at segment, or -1
+		int m_width;
+		int m_height;
+		long long m_usedArea = 0;
+		std::vector<Segment> m_skyline;
+	};
+
+	//Where a sprite ended up. UVs are in the page, for sampling the array texture at layer.
+	struct AtlasSprite {
+		ew::Vec2 uvOffset;
+		ew::Vec2 uvScale;
+		int layer = 0;
+		int width = 0; //Pixels, after any downscaling
+		int height = 0;
+	};
+
+	/// <summary>
+	/// Packs images into square pages and uploads the pages as the layers of one GL_TEXTURE_2D_ARRAY.
+	/// Each sprite is surrounded by padding texels copied from its edge and starts on a multiple of padding,
+	/// so mips down to log2(padding) never mix neighbouring sprites; the texture stops its mip chain there.
+	/// </summary>
+	class TextureAtlas {
+	public:
+		TextureAtlas(int pageSize = 2048, int padding = 16, int maxSpriteSize = 0);
+		~TextureAtlas();
+		TextureAtlas(const TextureAtlas&) = delete;
+		TextureAtlas& operator=(const TextureAtlas&) = delete;
+		int add(const char* filePath, bool flipVertically = false);
+		int add(const unsigned char* rgba, int width, int height);
+		bool build();
+		inline const AtlasSprite& getSprite(int sprite)const { return m_sprites[sprite]; }
+		inline int getSpriteCount()const { return (int)m_sprites.size(); }
+		inline unsigned int getTexture()const { return m_texture; }
+		inline int getLayerCount()const { return m_layerCount; }
+		inline int getPageSize()const { return m_pageSize; }
+		inline float getOccupancy()const { return m_occupancy; } //Average over the pages
+		size_t getMemorySize()const; //Bytes of the array texture, with mips
+	private:
+		struct Image {
+			std::vector<unsigned char> rgba;
+			int width;
+			int height;
+		};
+		int m_pageSize;
+		int m_padding;
+		int m_maxSpriteSize;
+		int m_layerCount = 0;
+		int m_levels = 1;
+		float m_occupancy = 0;
+		unsigned int m_texture = 0;
+		std::vector<Image> m_images; //Waiting for build()
+		std::vector<AtlasSprite> m_sprites;
+	};
+}
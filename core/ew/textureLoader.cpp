@@ -0,0 +1,231 @@
+#include "textureLoader.h"
+#include "glState.h"
+#include "cookedTexture.h"
+#include "external/glad.h"
+#include "external/stb_image.h"
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+
+namespace ew {
+	static int getTextureFormat(int numComponents) {
+		switch (numComponents) {
+		default:
+			return GL_RGBA;
+		case 3:
+			return GL_RGB;
+		case 2:
+			return GL_RG;
+		case 1:
+			return GL_RED;
+		}
+	}
+
+	TextureLoader::TextureLoader(int numWorkers)
+	{
+		if (numWorkers < 0) {
+			numWorkers = (int)std::thread::hardware_concurrency() - 1;
+		}
+		//The GL thread never decodes, so there has to be at least one worker
+		numWorkers = numWorkers > 0 ? numWorkers : 1;
+		for (int i = 0; i < numWorkers; i++) {
+			m_workers.emplace_back(&TextureLoader::workerLoop, this);
+		}
+	}
+	TextureLoader::~TextureLoader()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+		m_wake.notify_all();
+		for (size_t i = 0; i < m_workers.size(); i++) {
+			m_workers[i].join();
+		}
+		for (size_t i = 0; i < m_decoded.size(); i++) {
+			stbi_image_free(m_decoded[i].pixels);
+		}
+		for (int i = 0; i < TEXTURE_UPLOAD_BUFFERS; i++) {
+			if (m_fences[i]) {
+				glDeleteSync((GLsync)m_fences[i]);
+			}
+		}
+		if (m_buffers[0] != 0) {
+			glDeleteBuffers(TEXTURE_UPLOAD_BUFFERS, m_buffers);
+		}
+	}
+	/// <summary>
+	/// Creates the texture with a 2x2 grey checker and queues the file for decoding. Call on the GL thread.
+	/// If texcook has written a .ewtex next to the file, that is uploaded straight away instead.
+	/// </summary>
+	/// <param name="flipVertically">Flip rows on decode, as qm::loadTexture does</param>
+	/// <returns>The texture name, valid to bind straight away</returns>
+	unsigned int TextureLoader::load(const char* filePath, int wrapMode, int filterMode, bool flipVertically)
+	{
+		std::string cookedPath = GetCookedTexturePath(filePath);
+		CookedTextureFile cooked;
+		if (cooked.open(cookedPath.c_str())) {
+			bool flipped = (cooked.getHeader()->flags & COOKED_TEXTURE_FLIPPED) != 0;
+			if (flipped == flipVertically) {
+				//Already mipped and block compressed, so there's nothing for a worker to do
+				unsigned int texture = uploadCookedTexture(cooked, wrapMode, filterMode);
+				m_resident[texture] = true;
+				m_stats.cooked++;
+				return texture;
+			}
+			printf("%s was cooked with the other flip, decoding %s instead\n", cookedPath.c_str(), filePath);
+		}
+		const unsigned char placeholder[16] = {
+			96, 96, 96, 255,  160, 160, 160, 255,
+			160, 160, 160, 255,  96, 96, 96, 255
+		};
+		unsigned int texture;
+		glGenTextures(1, &texture);
+		GLState::bindTexture(GL_TEXTURE_2D, texture);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 2, 2, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholder);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapMode);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrapMode);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filterMode);
+		float borderColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+		glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
+		glGenerateMipmap(GL_TEXTURE_2D);
+		GLState::bindTexture(GL_TEXTURE_2D, 0);
+
+		m_resident[texture] = false;
+		m_stats.pending++;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			Request request;
+			request.filePath = filePath;
+			request.texture = texture;
+			request.flipVertically = flipVertically;
+			m_requests.push_back(request);
+		}
+		m_wake.notify_one();
+		return texture;
+	}
+	void TextureLoader::workerLoop()
+	{
+		while (true) {
+			Request request;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_wake.wait(lock, [this] { return m_stop || !m_requests.empty(); });
+				if (m_stop) {
+					return;
+				}
+				request = m_requests.front();
+				m_requests.pop_front();
+			}
+			//The flip flag is per thread, so workers don't race on stb's global one
+			stbi_set_flip_vertically_on_load_thread(request.flipVertically);
+			Decoded image;
+			image.texture = request.texture;
+			image.pixels = stbi_load(request.filePath.c_str(), &image.width, &image.height, &image.numComponents, 0);
+			if (image.pixels == NULL) {
+				printf("Failed to load image %s\n", request.filePath.c_str());
+			}
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_decoded.push_back(image);
+		}
+	}
+	/// <summary>
+	/// Copies one decoded image into the next upload buffer and specifies the texture from it.
+	/// Returns false, leaving the image for later, if that buffer is still being read by the GPU.
+	/// </summary>
+	bool TextureLoader::upload(const Decoded& image)
+	{
+		if (m_buffers[0] == 0) {
+			glGenBuffers(TEXTURE_UPLOAD_BUFFERS, m_buffers);
+		}
+		int index = m_nextBuffer;
+		if (m_fences[index]) {
+			//Flushing makes sure the fence will signal even if nothing else submits work
+			if (glClientWaitSync((GLsync)m_fences[index], GL_SYNC_FLUSH_COMMANDS_BIT, 0) == GL_TIMEOUT_EXPIRED) {
+				return false;
+			}
+			glDeleteSync((GLsync)m_fences[index]);
+			m_fences[index] = nullptr;
+		}
+		GLsizeiptr size = (GLsizeiptr)image.width * image.height * image.numComponents;
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_buffers[index]);
+		//Orphan, so the driver never has to wait for the previous contents
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+		void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+		if (mapped) {
+			memcpy(mapped, image.pixels, size);
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+			int format = getTextureFormat(image.numComponents);
+			GLState::bindTexture(GL_TEXTURE_2D, image.texture);
+			//Rows of RGB images aren't 4 byte aligned
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+			glTexImage2D(GL_TEXTURE_2D, 0, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, NULL);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+			glGenerateMipmap(GL_TEXTURE_2D);
+			GLState::bindTexture(GL_TEXTURE_2D, 0);
+			m_fences[index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		}
+		else {
+			printf("TextureLoader could not map an upload buffer\n");
+		}
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		m_nextBuffer = (m_nextBuffer + 1) % TEXTURE_UPLOAD_BUFFERS;
+		return true;
+	}
+	/// <summary>
+	/// Uploads decoded images until budgetMs has been spent. At least one goes up each call, so big images still make progress.
+	/// Call once a frame on the GL thread.
+	/// </summary>
+	void TextureLoader::update(float budgetMs)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		m_stats.uploadsLastFrame = 0;
+		while (true) {
+			Decoded image;
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				if (m_decoded.empty()) {
+					break;
+				}
+				image = m_decoded.front();
+			}
+			if (image.pixels != NULL && !upload(image)) {
+				break;
+			}
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_decoded.pop_front();
+			}
+			stbi_image_free(image.pixels);
+			//Failed loads keep the placeholder but are no longer pending
+			m_resident[image.texture] = image.pixels != NULL;
+			m_stats.pending--;
+			m_stats.uploadsLastFrame++;
+
+			float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+			if (elapsedMs >= budgetMs) {
+				break;
+			}
+		}
+		m_stats.uploadMsLastFrame = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+	/// <summary>
+	/// Blocks until every requested texture is resident, for loading screens and tools
+	/// </summary>
+	void TextureLoader::finish()
+	{
+		while (m_stats.pending > 0) {
+			update(1e30f);
+			if (m_stats.pending > 0) {
+				std::this_thread::yield();
+			}
+		}
+	}
+	bool TextureLoader::isResident(unsigned int texture) const
+	{
+		auto it = m_resident.find(texture);
+		return it != m_resident.end() && it->second;
+	}
+}
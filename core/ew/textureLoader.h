@@ -0,0 +1,64 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
+
+namespace ew {
+	constexpr int TEXTURE_UPLOAD_BUFFERS = 3; //PBOs in the upload ring
+
+	struct TextureLoaderStats {
+		int pending = 0; //Requested but not yet resident
+		int uploadsLastFrame = 0;
+		float uploadMsLastFrame = 0; //GL thread time spent in update()
+		int cooked = 0; //Loaded from .ewtex files, skipping decode
+	};
+
+	/// <summary>
+	/// Loads textures without blocking the render thread. load() returns a texture name right away,
+	/// filled with a placeholder until the image has been decoded on a worker and uploaded by update().
+	/// Uploads go through a ring of pixel unpack buffers and stop once the frame's time budget is spent.
+	/// </summary>
+	class TextureLoader {
+	public:
+		TextureLoader(int numWorkers = -1); //-1 uses hardware_concurrency - 1
+		~TextureLoader();
+		TextureLoader(const TextureLoader&) = delete;
+		TextureLoader& operator=(const TextureLoader&) = delete;
+		unsigned int load(const char* filePath, int wrapMode, int filterMode, bool flipVertically = false);
+		void update(float budgetMs = 2.0f);
+		void finish();
+		bool isResident(unsigned int texture) const;
+		inline const TextureLoaderStats& getStats()const { return m_stats; }
+	private:
+		struct Request {
+			std::string filePath;
+			unsigned int texture;
+			bool flipVertically;
+		};
+		struct Decoded {
+			unsigned int texture;
+			int width;
+			int height;
+			int numComponents;
+			unsigned char* pixels; //stbi_load output, nullptr if the decode failed
+		};
+		void workerLoop();
+		bool upload(const Decoded& image);
+		std::vector<std::thread> m_workers;
+		std::mutex m_mutex;
+		std::condition_variable m_wake;
+		std::deque<Request> m_requests;
+		std::deque<Decoded> m_decoded;
+		bool m_stop = false;
+		//GL thread only
+		unsigned int m_buffers[TEXTURE_UPLOAD_BUFFERS] = {};
+		void* m_fences[TEXTURE_UPLOAD_BUFFERS] = {}; //GLsync after the last upload from each buffer
+		int m_nextBuffer = 0;
+		std::unordered_map<unsigned int, bool> m_resident; //Every texture this loader made, true once uploaded
+		TextureLoaderStats m_stats;
+	};
+}
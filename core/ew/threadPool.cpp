@@ -0,0 +1,100 @@
+#include "threadPool.h"
+
+namespace ew {
+	ThreadPool::ThreadPool(int numWorkers)
+	{
+		if (numWorkers < 0) {
+			numWorkers = (int)std::thread::hardware_concurrency() - 1;
+			numWorkers = numWorkers > 0 ? numWorkers : 0;
+		}
+		for (int i = 0; i < numWorkers; i++) {
+			m_workers.emplace_back(&ThreadPool::workerLoop, this);
+		}
+	}
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+		m_wake.notify_all();
+		for (size_t i = 0; i < m_workers.size(); i++) {
+			m_workers[i].join();
+		}
+	}
+	/// <summary>
+	/// Calls body(rangeBegin, rangeEnd) over [begin, end) split into roughly 4 ranges per thread, and waits for all of them.
+	/// Ranges run concurrently, so body must only write to data owned by its range. Not reentrant.
+	/// </summary>
+	/// <param name="minRange">Smallest range worth handing to another thread</param>
+	void ThreadPool::parallelFor(int begin, int end, const std::function<void(int, int)>& body, int minRange)
+	{
+		if (end <= begin) {
+			return;
+		}
+		int numThreads = (int)m_workers.size() + 1;
+		int rangeSize = (end - begin + numThreads * 4 - 1) / (numThreads * 4);
+		rangeSize = rangeSize > minRange ? rangeSize : minRange;
+		if (m_workers.empty() || rangeSize >= end - begin) {
+			body(begin, end);
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_body = &body;
+			m_next = begin;
+			m_end = end;
+			m_rangeSize = rangeSize;
+			m_pending = 0;
+			m_generation++;
+		}
+		m_wake.notify_all();
+		while (runRange()) {}
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_done.wait(lock, [this] { return m_next >= m_end && m_pending == 0; });
+		m_body = nullptr;
+	}
+	bool ThreadPool::runRange()
+	{
+		int rangeBegin, rangeEnd;
+		const std::function<void(int, int)>* body;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_body == nullptr || m_next >= m_end) {
+				return false;
+			}
+			rangeBegin = m_next;
+			rangeEnd = m_next + m_rangeSize < m_end ? m_next + m_rangeSize : m_end;
+			m_next = rangeEnd;
+			m_pending++;
+			body = m_body;
+		}
+		(*body)(rangeBegin, rangeEnd);
+		bool finished;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_pending--;
+			finished = m_next >= m_end && m_pending == 0;
+		}
+		if (finished) {
+			m_done.notify_all();
+		}
+		return true;
+	}
+	void ThreadPool::workerLoop()
+	{
+		unsigned int seenGeneration = 0;
+		while (true) {
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_wake.wait(lock, [&] { return m_stop || m_generation != seenGeneration; });
+				if (m_stop) {
+					return;
+				}
+				seenGeneration = m_generation;
+			}
+			while (runRange()) {}
+		}
+	}
+}
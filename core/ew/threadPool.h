@@ -0,0 +1,36 @@
+#pragma once
+#include <vector>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace ew {
+	/// <summary>
+	/// Fixed set of worker threads for splitting loops into ranges.
+	/// The calling thread works on ranges too, so a pool of 0 workers runs everything inline.
+	/// </summary>
+	class ThreadPool {
+	public:
+		ThreadPool(int numWorkers = -1); //-1 uses hardware_concurrency - 1
+		~ThreadPool();
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+		void parallelFor(int begin, int end, const std::function<void(int begin, int end)>& body, int minRange = 1);
+		inline int getNumWorkers()const { return (int)m_workers.size(); }
+	private:
+		void workerLoop();
+		bool runRange(); //Takes and runs one pending range. False when there are none left.
+		std::vector<std::thread> m_workers;
+		std::mutex m_mutex;
+		std::condition_variable m_wake;
+		std::condition_variable m_done;
+		const std::function<void(int, int)>* m_body = nullptr;
+		int m_next = 0; //Start of the next range to hand out
+		int m_end = 0;
+		int m_rangeSize = 1;
+		int m_pending = 0; //Ranges handed out but not finished
+		unsigned int m_generation = 0; //Bumped for every parallelFor so sleeping workers know to wake
+		bool m_stop = false;
+	};
+}
@@ -0,0 +1,131 @@
+#include "transformSystem.h"
+#include "ewMath/simd.h"
+#include <string.h>
+
+namespace ew {
+	/// <summary>
+	/// Adds an entry. Its matrix is valid after the next update().
+	/// </summary>
+	/// <returns>Index of the new entry</returns>
+	int TransformSystem::add(const ew::Transform& transform)
+	{
+		int index = m_count++;
+		if (index >= (int)m_dirty.size()) {
+			//Grow a whole block of 4 so update() never reads past the end
+			int padded = (m_count + 3) & ~3;
+			m_positionX.resize(padded, 0.0f); m_positionY.resize(padded, 0.0f); m_positionZ.resize(padded, 0.0f);
+			m_rotationX.resize(padded, 0.0f); m_rotationY.resize(padded, 0.0f); m_rotationZ.resize(padded, 0.0f);
+			m_scaleX.resize(padded, 1.0f); m_scaleY.resize(padded, 1.0f); m_scaleZ.resize(padded, 1.0f);
+			m_dirty.resize(padded, 0);
+			m_models.resize(padded, ew::IdentityMatrix());
+		}
+		set(index, transform);
+		return index;
+	}
+	void TransformSystem::set(int index, const ew::Transform& transform)
+	{
+		setPosition(index, transform.position);
+		setRotation(index, transform.rotation);
+		setScale(index, transform.scale);
+	}
+	void TransformSystem::setPosition(int index, const ew::Vec3& position)
+	{
+		m_positionX[index] = position.x;
+		m_positionY[index] = position.y;
+		m_positionZ[index] = position.z;
+		m_dirty[index] = 1;
+	}
+	void TransformSystem::setRotation(int index, const ew::Vec3& rotation)
+	{
+		m_rotationX[index] = rotation.x;
+		m_rotationY[index] = rotation.y;
+		m_rotationZ[index] = rotation.z;
+		m_dirty[index] = 1;
+	}
+	void TransformSystem::setScale(int index, const ew::Vec3& scale)
+	{
+		m_scaleX[index] = scale.x;
+		m_scaleY[index] = scale.y;
+		m_scaleZ[index] = scale.z;
+		m_dirty[index] = 1;
+	}
+	ew::Transform TransformSystem::get(int index) const
+	{
+		ew::Transform transform;
+		transform.position = ew::Vec3(m_positionX[index], m_positionY[index], m_positionZ[index]);
+		transform.rotation = ew::Vec3(m_rotationX[index], m_rotationY[index], m_rotationZ[index]);
+		transform.scale = ew::Vec3(m_scaleX[index], m_scaleY[index], m_scaleZ[index]);
+		return transform;
+	}
+	void TransformSystem::clear()
+	{
+		m_count = 0;
+		m_positionX.clear(); m_positionY.clear(); m_positionZ.clear();
+		m_rotationX.clear(); m_rotationY.clear(); m_rotationZ.clear();
+		m_scaleX.clear(); m_scaleY.clear(); m_scaleZ.clear();
+		m_dirty.clear();
+		m_models.clear();
+	}
+	/// <summary>
+	/// Rebuilds the model matrices of dirty entries. Same result as Transform::getModelMatrix,
+	/// Translate * RotateY * RotateX * RotateZ * Scale, but written out in closed form.
+	/// </summary>
+	/// <returns>Number of entries whose matrix was rebuilt</returns>
+	int TransformSystem::update()
+	{
+		using namespace ew::simd;
+		int updated = 0;
+		for (int i = 0; i < m_count; i += 4)
+		{
+			unsigned int dirtyBlock;
+			memcpy(&dirtyBlock, &m_dirty[i], sizeof(dirtyBlock));
+			if (dirtyBlock == 0) {
+				continue;
+			}
+			memset(&m_dirty[i], 0, 4);
+			updated += 4;
+
+			float4 sinX, cosX, sinY, cosY, sinZ, cosZ;
+			float4 toRadians = Set1(ew::DEG2RAD);
+			SinCos(Mul(Load(&m_rotationX[i]), toRadians), sinX, cosX);
+			SinCos(Mul(Load(&m_rotationY[i]), toRadians), sinY, cosY);
+			SinCos(Mul(Load(&m_rotationZ[i]), toRadians), sinZ, cosZ);
+
+			//Rows of Ry * Rx * Rz
+			float4 sinYsinX = Mul(sinY, sinX);
+			float4 cosYsinX = Mul(cosY, sinX);
+			float4 r00 = MulAdd(sinYsinX, sinZ, Mul(cosY, cosZ));
+			float4 r01 = Sub(Mul(sinYsinX, cosZ), Mul(cosY, sinZ));
+			float4 r02 = Mul(sinY, cosX);
+			float4 r10 = Mul(cosX, sinZ);
+			float4 r11 = Mul(cosX, cosZ);
+			float4 r12 = Sub(Set1(0.0f), sinX);
+			float4 r20 = Sub(Mul(cosYsinX, sinZ), Mul(sinY, cosZ));
+			float4 r21 = MulAdd(cosYsinX, cosZ, Mul(sinY, sinZ));
+			float4 r22 = Mul(cosY, cosX);
+
+			//Columns scaled by Scale, translation in the last column
+			float4 scaleX = Load(&m_scaleX[i]);
+			float4 scaleY = Load(&m_scaleY[i]);
+			float4 scaleZ = Load(&m_scaleZ[i]);
+			float4 zero = Set1(0.0f);
+			float4 one = Set1(1.0f);
+			float4 columns[4][4] = {
+				{ Mul(r00, scaleX), Mul(r10, scaleX), Mul(r20, scaleX), zero },
+				{ Mul(r01, scaleY), Mul(r11, scaleY), Mul(r21, scaleY), zero },
+				{ Mul(r02, scaleZ), Mul(r12, scaleZ), Mul(r22, scaleZ), zero },
+				{ Load(&m_positionX[i]), Load(&m_positionY[i]), Load(&m_positionZ[i]), one }
+			};
+			//Each float4 holds one element for 4 entries; transpose to get one column per entry
+			for (int c = 0; c < 4; c++)
+			{
+				Transpose(columns[c][0], columns[c][1], columns[c][2], columns[c][3]);
+				for (int e = 0; e < 4; e++)
+				{
+					Store(&m_models[i + e][c][0], columns[c][e]);
+				}
+			}
+		}
+		return updated < m_count ? updated : m_count;
+	}
+}
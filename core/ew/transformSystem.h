@@ -0,0 +1,34 @@
+#pragma once
+#include <vector>
+#include "ewMath/ewMath.h"
+#include "transform.h"
+
+namespace ew {
+	/// <summary>
+	/// Structure of arrays storage for many transforms. update() rebuilds the model matrix of every
+	/// entry changed since the last update, 4 entries at a time, into one contiguous Mat4 array
+	/// that can be copied straight into an instance buffer.
+	/// </summary>
+	class TransformSystem {
+	public:
+		int add(const ew::Transform& transform = ew::Transform());
+		void set(int index, const ew::Transform& transform);
+		void setPosition(int index, const ew::Vec3& position);
+		void setRotation(int index, const ew::Vec3& rotation); //Euler angles (Degrees)
+		void setScale(int index, const ew::Vec3& scale);
+		ew::Transform get(int index) const;
+		void clear();
+		int update();
+		inline int size()const { return m_count; }
+		inline const ew::Mat4& getModelMatrix(int index)const { return m_models[index]; }
+		inline const ew::Mat4* getModelMatrices()const { return m_models.data(); }
+	private:
+		int m_count = 0;
+		//Padded to a multiple of 4 entries
+		std::vector<float> m_positionX, m_positionY, m_positionZ;
+		std::vector<float> m_rotationX, m_rotationY, m_rotationZ;
+		std::vector<float> m_scaleX, m_scaleY, m_scaleZ;
+		std::vector<unsigned char> m_dirty;
+		std::vector<ew::Mat4> m_models;
+	};
+}
@@ -0,0 +1,135 @@
+#include "vertexFormat.h"
+#include "mesh.h"
+#include <string.h>
+
+namespace ew {
+	/// <summary>
+	/// IEEE half, round to nearest even. Overflow becomes infinity, tiny values flush through denormals to 0.
+	/// </summary>
+	unsigned short FloatToHalf(float f)
+	{
+		unsigned int bits;
+		memcpy(&bits, &f, sizeof(bits));
+		unsigned int sign = (bits >> 16) & 0x8000;
+		unsigned int absBits = bits & 0x7FFFFFFF;
+		if (absBits >= 0x7F800000) {
+			//Inf or NaN
+			return (unsigned short)(sign | 0x7C00 | (absBits > 0x7F800000 ? 0x200 : 0));
+		}
+		if (absBits >= 0x477FF000) {
+			//Rounds past the largest half
+			return (unsigned short)(sign | 0x7C00);
+		}
+		if (absBits < 0x38800000) {
+			//Denormal half: shift the mantissa (with its implicit 1) into place, rounding to nearest even
+			if (absBits < 0x33000000) {
+				return (unsigned short)sign;
+			}
+			unsigned int mantissa = (absBits & 0x7FFFFF) | 0x800000;
+			int shift = 126 - (int)(absBits >> 23);
+			unsigned int half = mantissa >> shift;
+			unsigned int remainder = mantissa & ((1u << shift) - 1);
+			unsigned int halfway = 1u << (shift - 1);
+			if (remainder > halfway || (remainder == halfway && (half & 1))) {
+				half++;
+			}
+			return (unsigned short)(sign | half);
+		}
+		//Normal: rebias the exponent, round the 13 dropped mantissa bits to nearest even
+		unsigned int half = ((absBits - 0x38000000) >> 13);
+		unsigned int remainder = absBits & 0x1FFF;
+		if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1))) {
+			half++;
+		}
+		return (unsigned short)(sign | half);
+	}
+	float HalfToFloat(unsigned short h)
+	{
+		unsigned int sign = (h & 0x8000) << 16;
+		unsigned int exponent = (h >> 10) & 0x1F;
+		unsigned int mantissa = h & 0x3FF;
+		unsigned int bits;
+		if (exponent == 0x1F) {
+			bits = sign | 0x7F800000 | (mantissa << 13);
+		}
+		else if (exponent != 0) {
+			bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+		}
+		else if (mantissa != 0) {
+			float f = mantissa * (1.0f / 16777216.0f); //2^-24
+			return sign ? -f : f;
+		}
+		else {
+			bits = sign;
+		}
+		float f;
+		memcpy(&f, &bits, sizeof(f));
+		return f;
+	}
+	static inline short toSnorm16(float v) {
+		v = v < -1.0f ? -1.0f : (v > 1.0f ? 1.0f : v);
+		return (short)roundf(v * 32767.0f);
+	}
+	/// <summary>
+	/// Projects the normal onto an octahedron and unfolds it into a square, 2 x 16 bits
+	/// </summary>
+	void OctahedralEncode(const ew::Vec3& normal, short out[2])
+	{
+		float l1 = fabsf(normal.x) + fabsf(normal.y) + fabsf(normal.z);
+		float x = normal.x / l1;
+		float y = normal.y / l1;
+		if (normal.z < 0) {
+			float foldedX = (1.0f - fabsf(y)) * (x >= 0 ? 1.0f : -1.0f);
+			float foldedY = (1.0f - fabsf(x)) * (y >= 0 ? 1.0f : -1.0f);
+			x = foldedX;
+			y = foldedY;
+		}
+		out[0] = toSnorm16(x);
+		out[1] = toSnorm16(y);
+	}
+	//Same as octDecode in defaultLit.vert
+	ew::Vec3 OctahedralDecode(const short in[2])
+	{
+		float x = fmaxf(in[0] / 32767.0f, -1.0f);
+		float y = fmaxf(in[1] / 32767.0f, -1.0f);
+		ew::Vec3 n = ew::Vec3(x, y, 1.0f - fabsf(x) - fabsf(y));
+		float t = fmaxf(-n.z, 0.0f);
+		n.x += n.x >= 0 ? -t : t;
+		n.y += n.y >= 0 ? -t : t;
+		return ew::Normalize(n);
+	}
+	CompactVertex EncodeVertex(const Vertex& vertex)
+	{
+		CompactVertex out;
+		out.pos[0] = FloatToHalf(vertex.pos.x);
+		out.pos[1] = FloatToHalf(vertex.pos.y);
+		out.pos[2] = FloatToHalf(vertex.pos.z);
+		out.pos[3] = 0;
+		OctahedralEncode(vertex.normal, out.normal);
+		for (int i = 0; i < 2; i++)
+		{
+			float uv = (&vertex.uv.x)[i];
+			uv = uv < 0.0f ? 0.0f : (uv > 1.0f ? 1.0f : uv);
+			out.uv[i] = (unsigned short)roundf(uv * 65535.0f);
+		}
+		return out;
+	}
+	Vertex DecodeVertex(const CompactVertex& vertex)
+	{
+		Vertex out;
+		out.pos = ew::Vec3(HalfToFloat(vertex.pos[0]), HalfToFloat(vertex.pos[1]), HalfToFloat(vertex.pos[2]));
+		out.normal = OctahedralDecode(vertex.normal);
+		out.uv = ew::Vec2(vertex.uv[0] / 65535.0f, vertex.uv[1] / 65535.0f);
+		return out;
+	}
+	void EncodeVertices(const Vertex* vertices, int count, CompactVertex* out)
+	{
+		for (int i = 0; i < count; i++) {
+			out[i] = EncodeVertex(vertices[i]);
+		}
+	}
+	int GetVertexSize(VertexFormat format)
+	{
+		return format == VertexFormat::COMPACT ? (int)sizeof(CompactVertex) : (int)sizeof(Vertex);
+	}
+}
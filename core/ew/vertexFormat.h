@@ -0,0 +1,29 @@
+#pragma once
+#include <vector>
+#include "ewMath/ewMath.h"
+
+namespace ew {
+	struct Vertex;
+
+	enum class VertexFormat {
+		FLOAT32 = 0, //ew::Vertex, 32 bytes
+		COMPACT = 1 //ew::CompactVertex, 16 bytes
+	};
+
+	//Quantized vertex. Decoded by glVertexAttribFormat, apart from the normal which defaultLit.vert unpacks.
+	struct CompactVertex {
+		unsigned short pos[4]; //Half floats. w is 0, which tells the shader the normal is octahedral.
+		short normal[2]; //Octahedral encoded unit normal, snorm16
+		unsigned short uv[2]; //unorm16, UVs are clamped to 0-1
+	};
+
+	unsigned short FloatToHalf(float f);
+	float HalfToFloat(unsigned short h);
+	void OctahedralEncode(const ew::Vec3& normal, short out[2]);
+	ew::Vec3 OctahedralDecode(const short in[2]);
+	CompactVertex EncodeVertex(const Vertex& vertex);
+	Vertex DecodeVertex(const CompactVertex& vertex);
+	void EncodeVertices(const Vertex* vertices, int count, CompactVertex* out);
+	int GetVertexSize(VertexFormat format);
+	void SetupVertexFormat(VertexFormat format); //GL side, in mesh.cpp
+}
@@ -0,0 +1,228 @@
+#include "billboardBatch.h"
+#include <stddef.h>
+#include "../ew/external/glad.h"
+#include "../ew/glState.h"
+
+namespace qm
+{
+	/// <summary>
+	/// Creates a batch that instances the given quad
+	/// </summary>
+	/// <param name="quad">Mesh drawn for every billboard, usually createVertPlane(1, 1)</param>
+	/// <param name="capacity">Instances to allocate up front. The batch grows if more are added.</param>
+	BillboardBatch::BillboardBatch(const ew::MeshData& quad, int capacity)
+	{
+		m_instances.reserve(capacity);
+		m_numIndices = (int)quad.indices.size();
+		ew::IndexType indexType = ew::ChooseIndexType((int)quad.vertices.size());
+		m_indexType = ew::GetIndexGLType(indexType);
+		m_primitive = ew::GetTopologyGLMode(quad.topology);
+		//The quad turns around its origin, so bound it by the furthest vertex from there
+		m_quadRadius = ew::Magnitude(quad.bounds.center) + quad.bounds.radius;
+
+		glGenBuffers(1, &m_vbo);
+		glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(ew::Vertex) * quad.vertices.size(), quad.vertices.data(), GL_STATIC_DRAW);
+
+		m_gpuCapacity = capacity > 0 ? capacity : 1;
+		glGenBuffers(1, &m_instanceVbo);
+		glBindBuffer(GL_ARRAY_BUFFER, m_instanceVbo);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(BillboardInstance) * m_gpuCapacity, NULL, GL_DYNAMIC_DRAW);
+		glGenBuffers(1, &m_visibleVbo);
+
+		//Same quad, instanced from either every billboard or only the ones that passed cull()
+		glGenVertexArrays(1, &m_vao);
+		ew::GLState::bindVertexArray(m_vao);
+		glGenBuffers(1, &m_ebo);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+		ew::UploadIndices(quad.indices, indexType, GL_STATIC_DRAW);
+		setAttributes(m_instanceVbo);
+
+		glGenVertexArrays(1, &m_visibleVao);
+		ew::GLState::bindVertexArray(m_visibleVao);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+		setAttributes(m_visibleVbo);
+
+		ew::GLState::bindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	}
+	/// <summary>
+	/// Points the bound vertex array at the quad and at one instance buffer
+	/// </summary>
+	void BillboardBatch::setAttributes(unsigned int instanceBuffer)
+	{
+		//Per vertex attributes, same layout as ew::Mesh
+		glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(ew::Vertex), (const void*)offsetof(ew::Vertex, pos));
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(ew::Vertex), (const void*)offsetof(ew::Vertex, normal));
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(ew::Vertex), (const void*)offsetof(ew::Vertex, uv));
+		glEnableVertexAttribArray(2);
+
+		//Per instance attributes
+		glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+		glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(BillboardInstance), (const void*)offsetof(BillboardInstance, position));
+		glEnableVertexAttribArray(3);
+		glVertexAttribDivisor(3, 1);
+		glVertexAttribPointer(4, 2, GL_FLOAT, GL_FALSE, sizeof(BillboardInstance), (const void*)offsetof(BillboardInstance, scale));
+		glEnableVertexAttribArray(4);
+		glVertexAttribDivisor(4, 1);
+		//uvOffset and uvScale are adjacent, so they go up as one vec4
+		glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(BillboardInstance), (const void*)offsetof(BillboardInstance, uvOffset));
+		glEnableVertexAttribArray(5);
+		glVertexAttribDivisor(5, 1);
+		glVertexAttribPointer(6, 1, GL_FLOAT, GL_FALSE, sizeof(BillboardInstance), (const void*)offsetof(BillboardInstance, layer));
+		glEnableVertexAttribArray(6);
+		glVertexAttribDivisor(6, 1);
+	}
+	/// <summary>
+	/// Appends a billboard and makes it visible
+	/// </summary>
+	/// <returns>Index of the new billboard</returns>
+	int BillboardBatch::add(const ew::Vec3& position, const ew::Vec2& scale)
+	{
+		BillboardInstance instance;
+		instance.position = position;
+		instance.scale = scale;
+		m_instances.push_back(instance);
+		m_boundX.push_back(0); m_boundY.push_back(0); m_boundZ.push_back(0); m_boundRadius.push_back(0);
+		int index = (int)m_instances.size() - 1;
+		setBounds(index);
+		markDirty(index);
+		m_count = (int)m_instances.size();
+		return index;
+	}
+	/// <summary>
+	/// Appends a billboard showing one sprite of an atlas
+	/// </summary>
+	/// <returns>Index of the new billboard</returns>
+	int BillboardBatch::add(const ew::Vec3& position, const ew::Vec2& scale, const ew::AtlasSprite& sprite)
+	{
+		int index = add(position, scale);
+		setSprite(index, sprite);
+		return index;
+	}
+	void BillboardBatch::setPosition(int index, const ew::Vec3& position)
+	{
+		m_instances[index].position = position;
+		setBounds(index);
+		markDirty(index);
+	}
+	void BillboardBatch::setScale(int index, const ew::Vec2& scale)
+	{
+		m_instances[index].scale = scale;
+		setBounds(index);
+		markDirty(index);
+	}
+	void BillboardBatch::setSprite(int index, const ew::AtlasSprite& sprite)
+	{
+		m_instances[index].uvOffset = sprite.uvOffset;
+		m_instances[index].uvScale = sprite.uvScale;
+		m_instances[index].layer = (float)sprite.layer;
+		markDirty(index);
+	}
+	/// <summary>
+	/// Draws only the first count billboards. Instances past count are kept, not removed.
+	/// </summary>
+	void BillboardBatch::setCount(int count)
+	{
+		if (count < 0) {
+			count = 0;
+		}
+		m_count = count < (int)m_instances.size() ? count : (int)m_instances.size();
+	}
+	void BillboardBatch::clear()
+	{
+		m_instances.clear();
+		m_boundX.clear(); m_boundY.clear(); m_boundZ.clear(); m_boundRadius.clear();
+		m_count = 0;
+		m_dirtyBegin = m_dirtyEnd = 0;
+	}
+	void BillboardBatch::markDirty(int index)
+	{
+		if (m_dirtyBegin == m_dirtyEnd) {
+			m_dirtyBegin = index;
+			m_dirtyEnd = index + 1;
+		}
+		else {
+			m_dirtyBegin = index < m_dirtyBegin ? index : m_dirtyBegin;
+			m_dirtyEnd = index + 1 > m_dirtyEnd ? index + 1 : m_dirtyEnd;
+		}
+	}
+	void BillboardBatch::setBounds(int index)
+	{
+		const BillboardInstance& instance = m_instances[index];
+		m_boundX[index] = instance.position.x;
+		m_boundY[index] = instance.position.y;
+		m_boundZ[index] = instance.position.z;
+		m_boundRadius[index] = m_quadRadius * fmaxf(fabsf(instance.scale.x), fabsf(instance.scale.y));
+	}
+	/// <summary>
+	/// Tests the first count billboards against the frustum. The next draw() only streams and draws the visible ones.
+	/// Call every frame the camera or billboards move; a draw() without cull() draws everything again.
+	/// </summary>
+	ew::CullStats BillboardBatch::cull(const ew::Frustum& frustum)
+	{
+		m_visibleMask.resize(m_count);
+		m_visible.clear();
+		ew::CullStats stats = ew::CullSpheres(frustum, m_boundX.data(), m_boundY.data(), m_boundZ.data(), m_boundRadius.data(), m_count, m_visibleMask.data());
+		m_visible.reserve(stats.visible);
+		for (int i = 0; i < m_count; i++)
+		{
+			if (m_visibleMask[i]) {
+				m_visible.push_back(m_instances[i]);
+			}
+		}
+		m_culled = true;
+		return stats;
+	}
+	/// <summary>
+	/// Uploads instances changed since the last draw, then draws every visible billboard in one call.
+	/// Expects billboard.vert to be bound with _ViewProjection and the _Billboard basis set.
+	/// </summary>
+	void BillboardBatch::draw()
+	{
+		if (m_primitive == GL_TRIANGLE_STRIP) {
+			ew::GLState::setEnabled(GL_PRIMITIVE_RESTART_FIXED_INDEX, true);
+		}
+		if (m_culled) {
+			//The visible list changes every frame, so it goes through its own buffer and the master copy keeps its dirty range
+			m_culled = false;
+			int numVisible = (int)m_visible.size();
+			if (numVisible == 0) {
+				return;
+			}
+			ew::GLState::bindVertexArray(m_visibleVao);
+			glBindBuffer(GL_ARRAY_BUFFER, m_visibleVbo);
+			while (m_visibleCapacity < numVisible) {
+				m_visibleCapacity = m_visibleCapacity > 0 ? m_visibleCapacity * 2 : 256;
+			}
+			//Orphan, so the driver never has to wait for the GPU to finish with last frame's list
+			glBufferData(GL_ARRAY_BUFFER, sizeof(BillboardInstance) * m_visibleCapacity, NULL, GL_STREAM_DRAW);
+			glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(BillboardInstance) * numVisible, m_visible.data());
+			glDrawElementsInstanced(m_primitive, m_numIndices, m_indexType, NULL, numVisible);
+			return;
+		}
+		ew::GLState::bindVertexArray(m_vao);
+		glBindBuffer(GL_ARRAY_BUFFER, m_instanceVbo);
+		if ((int)m_instances.size() > m_gpuCapacity) {
+			//Reallocate, everything gets uploaded below
+			while (m_gpuCapacity < (int)m_instances.size()) {
+				m_gpuCapacity *= 2;
+			}
+			glBufferData(GL_ARRAY_BUFFER, sizeof(BillboardInstance) * m_gpuCapacity, NULL, GL_DYNAMIC_DRAW);
+			markDirty(0);
+			markDirty((int)m_instances.size() - 1);
+		}
+		if (m_dirtyBegin != m_dirtyEnd) {
+			glBufferSubData(GL_ARRAY_BUFFER, sizeof(BillboardInstance) * m_dirtyBegin,
+				sizeof(BillboardInstance) * (m_dirtyEnd - m_dirtyBegin), &m_instances[m_dirtyBegin]);
+			m_dirtyBegin = m_dirtyEnd = 0;
+		}
+		if (m_count > 0) {
+			glDrawElementsInstanced(m_primitive, m_numIndices, m_indexType, NULL, m_count);
+		}
+	}
+}
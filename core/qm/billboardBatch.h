@@ -0,0 +1,67 @@
+#pragma once
+#include <vector>
+#include "../ew/ewMath/ewMath.h"
+#include "../ew/mesh.h"
+#include "../ew/frustum.h"
+#include "../ew/textureAtlas.h"
+
+namespace qm
+{
+	//Per-instance data streamed to billboard.vert (locations 3 to 6)
+	struct BillboardInstance
+	{
+		ew::Vec3 position; //World space center
+		ew::Vec2 scale; //Width, height
+		ew::Vec2 uvOffset = ew::Vec2(0.0f); //Sprite rect in the atlas page, see ew::AtlasSprite
+		ew::Vec2 uvScale = ew::Vec2(1.0f);
+		float layer = 0; //Atlas page
+	};
+
+	//Draws any number of camera-facing quads with one glDrawElementsInstanced call.
+	//The facing rotation is done in billboard.vert, so the CPU only keeps positions and scales.
+	//Each instance can show a different sprite of one ew::TextureAtlas.
+	class BillboardBatch
+	{
+	public:
+		BillboardBatch(const ew::MeshData& quad, int capacity);
+		int add(const ew::Vec3& position, const ew::Vec2& scale = ew::Vec2(1.0f));
+		int add(const ew::Vec3& position, const ew::Vec2& scale, const ew::AtlasSprite& sprite);
+		void setPosition(int index, const ew::Vec3& position);
+		void setScale(int index, const ew::Vec2& scale);
+		void setSprite(int index, const ew::AtlasSprite& sprite);
+		void setCount(int count);
+		void clear();
+		ew::CullStats cull(const ew::Frustum& frustum);
+		void draw();
+		inline int getCount()const { return m_count; } //Drawn, see setCount
+		inline int getInstanceCount()const { return (int)m_instances.size(); } //Stored, drawn or not
+		inline int getCapacity()const { return m_gpuCapacity; } //Instances the GPU buffer holds, grows on the next draw() after add()
+		inline const BillboardInstance& getInstance(int index)const { return m_instances[index]; }
+		inline float getBoundingRadius(int index)const { return m_boundRadius[index]; } //Covers every facing
+	private:
+		void setAttributes(unsigned int instanceBuffer);
+		void markDirty(int index);
+		void setBounds(int index);
+		unsigned int m_vao = 0;
+		unsigned int m_vbo = 0;
+		unsigned int m_ebo = 0;
+		unsigned int m_instanceVbo = 0; //Every instance, updated by dirty range
+		unsigned int m_visibleVao = 0;
+		unsigned int m_visibleVbo = 0; //Instances that passed cull(), streamed each draw
+		int m_visibleCapacity = 0;
+		int m_numIndices = 0;
+		unsigned int m_indexType = 0; //GL enum, see ew::ChooseIndexType
+		unsigned int m_primitive = 0; //GL enum, see ew::Topology
+		int m_count = 0; //Instances drawn
+		int m_gpuCapacity = 0; //Instances the GPU buffer can hold
+		int m_dirtyBegin = 0;
+		int m_dirtyEnd = 0;
+		std::vector<BillboardInstance> m_instances;
+		//Culling. Bounding spheres are kept as separate arrays for ew::CullSpheres.
+		float m_quadRadius = 0; //Bounding radius of the quad at scale 1
+		bool m_culled = false; //cull() ran since the last draw
+		std::vector<float> m_boundX, m_boundY, m_boundZ, m_boundRadius;
+		std::vector<unsigned char> m_visibleMask;
+		std::vector<BillboardInstance> m_visible;
+	};
+}
@@ -36,7 +36,7 @@ namespace qm
 		int poleStart = 0;
 		int sideStart = numSegments + 1;
 
-		for (int i = 0; i <= numSegments; i++)
+		for (int i = 0; i < numSegments; i++)
 		{
 			data.indices.push_back(sideStart + i);
 			data.indices.push_back(poleStart + i);
@@ -47,7 +47,8 @@ namespace qm
 
 		for (int row = 0; row <= numSegments - 1; row++)
 		{
-			for (int col = 0; col <= numSegments; col++)
+			//The last column is the seam duplicate of the first, so it starts no quad
+			for (int col = 0; col < numSegments; col++)
 			{
 				int start = row * columns + col;
 
@@ -62,6 +63,7 @@ namespace qm
 			}
 		}
 
+		data.bounds = ew::ComputeBounds(data.vertices);
 		return data;
 	}
 
@@ -169,29 +171,34 @@ namespace qm
 			data.indices.push_back(start + 1);
 		}
 
+		data.bounds = ew::ComputeBounds(data.vertices);
 		return data;
 	}
 
-	ew::MeshData createPlane(float size, int subdivisions)
+	//Indices for a (subdivisions + 1)^2 vertex grid, as a triangle list or one strip per row
+	static void gridIndices(ew::MeshData& data, int subdivisions, ew::Topology topology)
 	{
-		ew::MeshData data;
-		ew::Vertex v;
-
-		for (float row = 0; row <= subdivisions; row++)
+		int columns = subdivisions + 1;
+		data.topology = topology;
+		if (topology == ew::Topology::TRIANGLE_STRIP)
 		{
-			for (float col = 0; col <= subdivisions; col++)
+			data.indices.reserve(subdivisions > 0 ? subdivisions * (columns * 2 + 1) - 1 : 0);
+			for (int row = 0; row < subdivisions; row++)
 			{
-				v.pos.x = size * (col / subdivisions);
-				v.pos.y = 0;
-				v.pos.z = -size * (row / subdivisions);
-
-				v.normal = ew::Vec3(0, 1, 0);
-				v.uv = ew::Vec2(row/subdivisions, col/subdivisions);
-				data.vertices.push_back(v);
+				if (row > 0)
+				{
+					data.indices.push_back(ew::PRIMITIVE_RESTART);
+				}
+				for (int col = 0; col < columns; col++)
+				{
+					//Next row first keeps the same winding as the triangle list
+					data.indices.push_back((row + 1) * columns + col);
+					data.indices.push_back(row * columns + col);
+				}
 			}
+			return;
 		}
-
-		int columns = subdivisions + 1;
+		data.indices.reserve(subdivisions * subdivisions * 6);
 		for (int row = 0; row < subdivisions; row++)
 		{
 			for (int col = 0; col < subdivisions; col++)
@@ -206,11 +213,34 @@ namespace qm
 				data.indices.push_back(start + columns);
 			}
 		}
+	}
+
+	ew::MeshData createPlane(float size, int subdivisions, ew::Topology topology = ew::Topology::TRIANGLES)
+	{
+		ew::MeshData data;
+		ew::Vertex v;
+
+		for (float row = 0; row <= subdivisions; row++)
+		{
+			for (float col = 0; col <= subdivisions; col++)
+			{
+				v.pos.x = size * (col / subdivisions);
+				v.pos.y = 0;
+				v.pos.z = -size * (row / subdivisions);
+
+				v.normal = ew::Vec3(0, 1, 0);
+				v.uv = ew::Vec2(row/subdivisions, col/subdivisions);
+				data.vertices.push_back(v);
+			}
+		}
+
+		gridIndices(data, subdivisions, topology);
 
+		data.bounds = ew::ComputeBounds(data.vertices);
 		return data;
 	}
 
-	ew::MeshData createVertPlane(float size, int subdivisions)
+	ew::MeshData createVertPlane(float size, int subdivisions, ew::Topology topology = ew::Topology::TRIANGLES)
 	{
 		ew::MeshData data;
 		ew::Vertex v;
@@ -229,22 +259,9 @@ namespace qm
 			}
 		}
 
-		int columns = subdivisions + 1;
-		for (int row = 0; row < subdivisions; row++)
-		{
-			for (int col = 0; col < subdivisions; col++)
-			{
-				int start = row * columns + col;
-				data.indices.push_back(start);
-				data.indices.push_back(start + 1);
-				data.indices.push_back(start + columns + 1);
-
-				data.indices.push_back(start);
-				data.indices.push_back(start + columns + 1);
-				data.indices.push_back(start + columns);
-			}
-		}
+		gridIndices(data, subdivisions, topology);
 
+		data.bounds = ew::ComputeBounds(data.vertices);
 		return data;
 	}
 }
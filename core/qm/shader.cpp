@@ -1,11 +1,12 @@
 #include "../ew/external/glad.h"
 #include "shader.h"
+#include "../ew/glState.h"
 
 namespace qm {
 	std::string loadShaderSourceFromFile(const std::string& filePath) {
 		std::ifstream fstream(filePath);
 		if (!fstream.is_open()) {
-			printf("Failed to load file %s", filePath);
+			printf("Failed to load file %s", filePath.c_str());
 			return {};
 		}
 		std::stringstream buffer;
@@ -59,36 +60,53 @@ namespace qm {
 		std::string vertexShaderSource = loadShaderSourceFromFile(vertexShader.c_str());
 		std::string fragmentShaderSource = loadShaderSourceFromFile(fragmentShader.c_str());
 		m_id = createShaderProgram(vertexShaderSource.c_str(), fragmentShaderSource.c_str());
+		m_uniforms.build(m_id);
 	}
 	void Shader::use()
 	{
-		glUseProgram(m_id);
+		ew::GLState::useProgram(m_id);
 	}
-	void Shader::setInt(const std::string& name, int v) const
+	ew::UniformHandle Shader::getUniform(ew::UniformName name) const
 	{
-		glUniform1i(glGetUniformLocation(m_id, name.c_str()), v);
+		ew::UniformHandle handle;
+		handle.location = m_uniforms.find(name.hash);
+		return handle;
 	}
-	void Shader::setFloat(const std::string& name, float v) const
+	void Shader::setInt(ew::UniformName name, int v) const
 	{
-		glUniform1f(glGetUniformLocation(m_id, name.c_str()), v);
+		m_lookupsAvoided++;
+		glUniform1i(m_uniforms.find(name.hash), v);
+	}
+	void Shader::setFloat(ew::UniformName name, float v) const
+	{
+		m_lookupsAvoided++;
+		glUniform1f(m_uniforms.find(name.hash), v);
 	}
 
-	void Shader::setVec2(const std::string& name, float x, float y) const
+	void Shader::setVec2(ew::UniformName name, float x, float y) const
 	{
-		glUniform2f(glGetUniformLocation(m_id, name.c_str()), x, y);
+		m_lookupsAvoided++;
+		glUniform2f(m_uniforms.find(name.hash), x, y);
 	}
 
-	void Shader::setVec3(const std::string& name, float x, float y, float z) const
+	void Shader::setVec3(ew::UniformName name, float x, float y, float z) const
+	{
+		m_lookupsAvoided++;
+		glUniform3f(m_uniforms.find(name.hash), x, y, z);
+	}
+	void Shader::setVec4(ew::UniformName name, float x, float y, float z, float w) const
 	{
-		glUniform3f(glGetUniformLocation(m_id, name.c_str()), x, y, z);
+		m_lookupsAvoided++;
+		glUniform4f(m_uniforms.find(name.hash), x, y, z, w);
 	}
-	void Shader::setVec4(const std::string& name, float x, float y, float z, float w) const
+	void Shader::setMat4(ew::UniformName name, const ew::Mat4& v) const
 	{
-		glUniform4f(glGetUniformLocation(m_id, name.c_str()), x, y, z, w);
+		setMat4(getUniform(name), v);
 	}
-	void Shader::setMat4(const std::string& name, const ew::Mat4& v) const
+	void Shader::setMat4(ew::UniformHandle handle, const ew::Mat4& v) const
 	{
-		glUniformMatrix4fv(glGetUniformLocation(m_id, name.c_str()), 1, GL_FALSE, &v[0][0]);
+		m_lookupsAvoided++;
+		glUniformMatrix4fv(handle.location, 1, GL_FALSE, &v[0][0]);
 	}
 
-}
+}
\ No newline at end of file
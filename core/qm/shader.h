@@ -2,6 +2,7 @@
 #include <sstream>
 #include <fstream>
 #include "../ew/ewMath/ewMath.h"
+#include "../ew/shader.h"
 
 namespace qm {
 	std::string loadShaderSourceFromFile(const std::string& filePath);
@@ -10,14 +11,19 @@ namespace qm {
 	public:
 		Shader(const std::string& vertexShader, const std::string& fragmentShader);
 		void use();
-		void setInt(const std::string& name, int v) const;
-		void setFloat(const std::string& name, float v) const;
-		void setVec2(const std::string& name, float x, float y) const;
-		void setVec3(const std::string& name, float x, float y, float z) const;
-		void setVec4(const std::string& name, float x, float y, float z, float w) const;
-		void Shader::setMat4(const std::string& name, const ew::Mat4& v) const;
+		ew::UniformHandle getUniform(ew::UniformName name) const;
+		void setInt(ew::UniformName name, int v) const;
+		void setFloat(ew::UniformName name, float v) const;
+		void setVec2(ew::UniformName name, float x, float y) const;
+		void setVec3(ew::UniformName name, float x, float y, float z) const;
+		void setVec4(ew::UniformName name, float x, float y, float z, float w) const;
+		void setMat4(ew::UniformName name, const ew::Mat4& v) const;
+		void setMat4(ew::UniformHandle handle, const ew::Mat4& v) const;
+		inline unsigned long long getLookupsAvoided()const { return m_lookupsAvoided; } //glGetUniformLocation calls saved
 	private:
 		unsigned int m_id; //OpenGL program handle
+		ew::UniformTable m_uniforms; //Active uniform locations, filled after linking
+		mutable unsigned long long m_lookupsAvoided = 0;
 	};
 
 }
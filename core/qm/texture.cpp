@@ -1,6 +1,7 @@
 #include "texture.h"
 #include "../ew/external/stb_image.h"
 #include "../ew/external/glad.h"
+#include "../ew/glState.h"
 
 
 namespace qm
@@ -14,7 +15,7 @@ namespace qm
 		unsigned int texture;
 		unsigned int colorNum;
 		glGenTextures(1, &texture);
-		glBindTexture(GL_TEXTURE_2D, texture);
+		ew::GLState::bindTexture(GL_TEXTURE_2D, texture);
 
 		unsigned char* data = stbi_load(filePath, &width, &height, &numComponents, 0);
 
@@ -53,7 +54,7 @@ namespace qm
 
 		glGenerateMipmap(GL_TEXTURE_2D);
 
-		glBindTexture(GL_TEXTURE_2D, 0);
+		ew::GLState::bindTexture(GL_TEXTURE_2D, 0);
 		stbi_image_free(data);
 		return texture;
 	}
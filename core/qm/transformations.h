@@ -133,20 +133,85 @@ namespace qm
 		}
 	};
 
+	//Billboard orientation modes
+	enum class BillboardMode {
+		Spherical, //Faces the camera plane on every axis
+		Cylindrical //Only turns around world Y, stays upright
+	};
+
+	//Shared orientation for every billboard in a frame. Columns of the rotation matrix.
+	struct BillboardBasis {
+		ew::Vec3 right = ew::Vec3(1, 0, 0);
+		ew::Vec3 up = ew::Vec3(0, 1, 0);
+		ew::Vec3 forward = ew::Vec3(0, 0, 1); //Points back at the camera
+	};
+
+	//Computes the billboard basis once per frame from the camera's view direction.
+	//previous is last frame's basis, used when the view direction alone doesn't define one.
+	inline BillboardBasis billBoardBasis(const ew::Camera& camera, BillboardMode mode, const BillboardBasis& previous = BillboardBasis())
+	{
+		BillboardBasis basis;
+		ew::Vec3 f = camera.position - camera.target;
+		if (mode == BillboardMode::Cylindrical) {
+			f.y = 0;
+		}
+		float length = ew::Magnitude(f);
+		if (length <= 0.0f) {
+			return previous;
+		}
+		f = f / length;
+		ew::Vec3 r = ew::Cross(ew::Vec3(0, 1, 0), f);
+		float rightLength = ew::Magnitude(r);
+		if (rightLength > 0.0001f) {
+			basis.right = r / rightLength;
+		}
+		else {
+			//Looking straight up or down, keep the previous right axis, made perpendicular to f again
+			r = previous.right - f * ew::Dot(previous.right, f);
+			rightLength = ew::Magnitude(r);
+			basis.right = rightLength > 0.0001f ? r / rightLength : ew::Vec3(1, 0, 0);
+		}
+		basis.forward = f;
+		basis.up = ew::Cross(f, basis.right);
+		return basis;
+	}
+
+	//Translate(position) * basis * Scale(scale), written out directly
+	inline void billBoardMatrix(const BillboardBasis& basis, const ew::Vec3& position, const ew::Vec3& scale, ew::Mat4& out)
+	{
+		out[0][0] = basis.right.x * scale.x; out[0][1] = basis.right.y * scale.x; out[0][2] = basis.right.z * scale.x; out[0][3] = 0;
+		out[1][0] = basis.up.x * scale.y; out[1][1] = basis.up.y * scale.y; out[1][2] = basis.up.z * scale.y; out[1][3] = 0;
+		out[2][0] = basis.forward.x * scale.z; out[2][1] = basis.forward.y * scale.z; out[2][2] = basis.forward.z * scale.z; out[2][3] = 0;
+		out[3][0] = position.x; out[3][1] = position.y; out[3][2] = position.z; out[3][3] = 1;
+	}
+
+	//Fills out[0..count) with billboard model matrices in one pass.
+	//scales can be nullptr for unit scale. Nothing is allocated.
+	inline void billBoardMatrices(const BillboardBasis& basis, const ew::Vec3* positions, const ew::Vec3* scales, int count, ew::Mat4* out)
+	{
+		const ew::Vec3 one = ew::Vec3(1.0f);
+		for (int i = 0; i < count; i++)
+		{
+			billBoardMatrix(basis, positions[i], scales ? scales[i] : one, out[i]);
+		}
+	}
+
 	//Billboard Rotation Method
-	inline ew::Mat4 billBoardRotate(ew::Camera camera, ew::Vec3 position)
+	//Faces the camera's position rather than its view plane, so the basis differs per billboard
+	inline BillboardBasis billBoardPointBasis(const ew::Vec3& cameraPosition, const ew::Vec3& position)
 	{
-		ew::Vec3 up = ew::Vec3(0, 1, 0);
-		ew::Vec3 f = ew::Normalize(camera.position - position);
-		ew::Vec3 r = ew::Normalize(ew::Cross(up, f));
-		ew::Vec3 u = ew::Normalize(ew::Cross(f, r));
+		BillboardBasis basis;
+		basis.forward = ew::Normalize(cameraPosition - position);
+		basis.right = ew::Normalize(ew::Cross(ew::Vec3(0, 1, 0), basis.forward));
+		basis.up = ew::Cross(basis.forward, basis.right);
+		return basis;
+	}
 
-		return ew::Mat4(
-			r.x, u.x, f.x, 0,
-			r.y, u.y, f.y, 0,
-			r.z, u.z, f.z, 0,
-			0, 0, 0, 1
-		);
+	inline ew::Mat4 billBoardRotate(const ew::Camera& camera, const ew::Vec3& position)
+	{
+		ew::Mat4 m;
+		billBoardMatrix(billBoardPointBasis(camera.position, position), ew::Vec3(0), ew::Vec3(1), m);
+		return m;
 	}
 
 	//Billboard Transform
@@ -154,9 +219,17 @@ namespace qm
 		ew::Vec3 position = ew::Vec3(0.0f, 0.0f, 0.0f);
 		ew::Vec3 rotation = ew::Vec3(0.0f, 0.0f, 0.0f); //Euler angles (degrees)
 		ew::Vec3 scale = ew::Vec3(1.0f, 1.0f, 1.0f);
-		ew::Mat4 getModelMatrix(ew::Camera camera) const
+		ew::Mat4 getModelMatrix(const ew::Camera& camera) const
+		{
+			ew::Mat4 modelMatrix;
+			billBoardMatrix(billBoardPointBasis(camera.position, position), position, scale, modelMatrix);
+			return modelMatrix;
+		}
+		//Uses a basis shared by every billboard this frame, see billBoardBasis
+		ew::Mat4 getModelMatrix(const BillboardBasis& basis) const
 		{
-			ew::Mat4 modelMatrix = qm::Translate(position) * billBoardRotate(camera,position) * qm::Scale(scale);
+			ew::Mat4 modelMatrix;
+			billBoardMatrix(basis, position, scale, modelMatrix);
 			return modelMatrix;
 		}
 	};
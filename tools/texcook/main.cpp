@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+
+#include <ew/cookedTexture.h>
+#include <ew/blockCompression.h>
+#include <ew/external/stb_image.h>
+
+//Cooks an image into a .ewtex: the full mip chain, block compressed, ready to upload without decoding.
+//Usage: texcook input [output] [--format auto|bc1|bc3|rgba8] [--flip]
+//output defaults to the input path with a .ewtex extension. auto picks BC1 for opaque images and BC3 otherwise.
+//--flip flips rows like qm::loadTexture, for textures the runtime loads with flipVertically.
+
+static bool parseFormat(const char* name, bool* automatic, ew::CookedFormat* format) {
+	*automatic = strcmp(name, "auto") == 0;
+	if (strcmp(name, "bc1") == 0) {
+		*format = ew::CookedFormat::BC1;
+	}
+	else if (strcmp(name, "bc3") == 0) {
+		*format = ew::CookedFormat::BC3;
+	}
+	else if (strcmp(name, "rgba8") == 0) {
+		*format = ew::CookedFormat::RGBA8;
+	}
+	else if (!*automatic) {
+		return false;
+	}
+	return true;
+}
+
+//Peak signal to noise ratio of mip 0 after a round trip through the encoder, in dB
+static double measurePSNR(const unsigned char* rgba, const ew::CookedTextureHeader& header, const unsigned char* file) {
+	const ew::CookedMip& mip = header.mips[0];
+	std::vector<unsigned char> decoded((size_t)mip.width * mip.height * 4);
+	if (header.format == ew::CookedFormat::BC1) {
+		ew::DecodeBC1(file + mip.offset, mip.width, mip.height, decoded.data());
+	}
+	else {
+		ew::DecodeBC3(file + mip.offset, mip.width, mip.height, decoded.data());
+	}
+	int channels = header.format == ew::CookedFormat::BC1 ? 3 : 4;
+	double squaredError = 0;
+	for (size_t i = 0; i < decoded.size(); i++) {
+		if ((int)(i % 4) < channels) {
+			double d = (double)rgba[i] - decoded[i];
+			squaredError += d * d;
+		}
+	}
+	double mse = squaredError / ((double)mip.width * mip.height * channels);
+	return mse > 0 ? 10.0 * log10(255.0 * 255.0 / mse) : 99.0;
+}
+
+int main(int argc, char** argv) {
+	const char* input = nullptr;
+	const char* output = nullptr;
+	bool automatic = true;
+	ew::CookedFormat format = ew::CookedFormat::BC1;
+	bool flip = false;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--flip") == 0) {
+			flip = true;
+		}
+		else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+			if (!parseFormat(argv[++i], &automatic, &format)) {
+				printf("Unknown format %s\n", argv[i]);
+				return 1;
+			}
+		}
+		else if (input == nullptr) {
+			input = argv[i];
+		}
+		else if (output == nullptr) {
+			output = argv[i];
+		}
+	}
+	if (input == nullptr) {
+		printf("Usage: texcook input [output] [--format auto|bc1|bc3|rgba8] [--flip]\n");
+		return 1;
+	}
+	std::string outputPath = output ? output : ew::GetCookedTexturePath(input);
+
+	auto start = std::chrono::high_resolution_clock::now();
+	stbi_set_flip_vertically_on_load(flip);
+	int width, height, numComponents;
+	//Always expand to RGBA so the encoders see one layout
+	unsigned char* rgba = stbi_load(input, &width, &height, &numComponents, 4);
+	if (rgba == NULL) {
+		printf("Failed to load image %s\n", input);
+		return 1;
+	}
+	if (automatic) {
+		format = ew::ChooseCookedFormat(rgba, width, height);
+	}
+	std::vector<unsigned char> file;
+	if (!ew::CookTexture(rgba, width, height, format, flip ? ew::COOKED_TEXTURE_FLIPPED : 0, file)) {
+		stbi_image_free(rgba);
+		return 1;
+	}
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	ew::CookedTextureHeader header;
+	memcpy(&header, file.data(), sizeof(header));
+	size_t uncompressed = 0;
+	for (unsigned int i = 0; i < header.mipCount; i++) {
+		uncompressed += ew::GetCookedMipSize(ew::CookedFormat::RGBA8, header.mips[i].width, header.mips[i].height);
+	}
+	printf("%s -> %s: %s %dx%d, %u mips, %.2f MB (RGBA8 with mips %.2f MB)",
+		input, outputPath.c_str(), ew::GetCookedFormatName(format), width, height, header.mipCount,
+		file.size() / (1024.0 * 1024.0), uncompressed / (1024.0 * 1024.0));
+	if (format != ew::CookedFormat::RGBA8) {
+		printf(", PSNR %.2f dB", measurePSNR(rgba, header, file.data()));
+	}
+	printf(", %.1f ms\n", ms);
+	stbi_image_free(rgba);
+	return ew::WriteCookedTexture(outputPath.c_str(), file) ? 0 : 1;
+}